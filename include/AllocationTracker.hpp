@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Subsystem an allocation is charged to, set with AllocationScope
+enum class AllocationTag : std::uint8_t {
+    Other,
+    Update,
+    Collision,
+    Render,
+    Audio,
+    UI,
+    Count
+};
+
+// Heap allocation telemetry. When the build defines ASTEROIDS_TRACK_ALLOCATIONS
+// (CMake option of the same name) the global operator new and delete are
+// replaced to count allocations and bytes per tag, per thread and in total,
+// and to keep live and peak heap size. Without the option nothing is hooked,
+// scopes compile to nothing and every counter reads zero.
+namespace AllocationTracker {
+
+struct Counters {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Totals since startup; subtract two snapshots to get the cost of a frame
+struct Snapshot {
+    std::array<Counters, static_cast<std::size_t>(AllocationTag::Count)> tags;
+    std::uint64_t liveBytes = 0;      // Allocated and not yet freed
+    std::uint64_t peakLiveBytes = 0;
+    
+    Counters total() const;
+};
+
+constexpr bool isEnabled()
+{
+#if defined(ASTEROIDS_TRACK_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* getTagName(AllocationTag tag);
+
+Snapshot capture();
+
+// Allocations made by the calling thread since it started
+std::uint64_t getThreadAllocationCount();
+
+// Peak resident set size of the process as reported by the OS, 0 if unknown
+std::size_t getPeakResidentBytes();
+
+// Tag of allocations made by the calling thread
+AllocationTag getThreadTag();
+void setThreadTag(AllocationTag tag);
+
+}
+
+// Charges allocations on this thread to a tag until the end of the scope
+class AllocationScope {
+public:
+#if defined(ASTEROIDS_TRACK_ALLOCATIONS)
+    explicit AllocationScope(AllocationTag tag)
+        : m_previous(AllocationTracker::getThreadTag())
+    {
+        AllocationTracker::setThreadTag(tag);
+    }
+    
+    ~AllocationScope()
+    {
+        AllocationTracker::setThreadTag(m_previous);
+    }
+#else
+    explicit AllocationScope(AllocationTag) {}
+#endif
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+#if defined(ASTEROIDS_TRACK_ALLOCATIONS)
+    AllocationTag m_previous;
+#endif
+};
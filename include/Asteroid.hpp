@@ -1,15 +1,18 @@
 #pragma once
 
 #include "Entity.hpp"
-#include <vector>
+#include <array>
+#include <cstddef>
 #include <random>
 
 class Asteroid : public Entity {
 public:
-    Asteroid(sf::Vector2f position, AsteroidSize size);
+    Asteroid(sf::Vector2f position, AsteroidSize size, std::mt19937& rng);
     
-    void update(float deltaTime) override;
-    void render(sf::RenderWindow& window) override;
+    // Put back an asteroid whose motion and outline are already known, such
+    // as one woken up by SleepingSectors
+    Asteroid(sf::Vector2f position, sf::Vector2f velocity, float rotation, float rotationSpeed,
+             AsteroidSize size, const sf::Vector2f* vertices, std::size_t vertexCount);
     
     // Get the size of the asteroid
     AsteroidSize getSize() const;
@@ -17,14 +20,35 @@ public:
     // Get points value for destroying this asteroid
     int getPoints() const;
     
-    // Create a random asteroid away from the player
-    static Asteroid createRandom(const sf::Vector2f& playerPosition);
+    // Spin in degrees per second
+    float getRotationSpeed() const;
+    
+    // Outline of the asteroid around its centre, before rotation
+    std::size_t getVertexCount() const;
+    sf::Vector2f getVertex(std::size_t index) const;
+    
+    // Outline, spin and motion, for keyframes of the simulation
+    void save(StateWriter& out) const;
+    static Asteroid load(StateReader& in);
+    
+    // Create a random asteroid on the world edge, away from the player
+    static Asteroid createRandom(const sf::Vector2f& playerPosition, const sf::Vector2f& worldSize, std::mt19937& rng);
+    
+    // Create a random asteroid anywhere in the world, at least minDistance
+    // from the player (measured across the wrap)
+    static Asteroid createScattered(const sf::Vector2f& playerPosition, const sf::Vector2f& worldSize,
+                                    float minDistance, std::mt19937& rng);
 
 private:
-    // Generate a random polygon shape for the asteroid
-    void generateShape();
+    // Collision radius of each size
+    static float getRadiusFor(AsteroidSize size);
+    
+    // Generate a random polygon outline for the asteroid
+    void generateOutline(std::mt19937& rng);
     
-    sf::ConvexShape m_shape;
+    // Outline around the centre; renderers draw it from snapshots
+    std::array<sf::Vector2f, ASTEROID_VERTICES_MAX> m_vertices;
+    std::size_t m_vertexCount;
     AsteroidSize m_size;
     float m_rotationSpeed;
 };
@@ -1,11 +1,35 @@
 #pragma once
 
 #include <SFML/Audio.hpp>
-#include <unordered_map>
-#include <string>
-#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "SpscQueue.hpp"
+
+// Every sound the game plays
+enum class SoundId : std::uint8_t {
+    Fire,
+    ExplosionSmall,
+    ExplosionMedium,
+    ExplosionLarge,
+    Explosion,
+    Thrust,
+    Count
+};
 
+// Plays sounds on a thread of its own. Callers only push small plain
+// commands into a lock-free queue; loading buffers, creating and starting
+// sf::Sound objects, cleaning up finished ones and anything else that talks
+// to the audio device happens on the audio thread, so none of it (or the
+// device blocking now and then) shows up in a frame or tick time.
+//
+// Commands must all come from one thread, the simulation thread in the game.
 class AudioManager {
 public:
     static AudioManager& getInstance();
@@ -14,21 +38,93 @@ public:
     AudioManager(const AudioManager&) = delete;
     AudioManager& operator=(const AudioManager&) = delete;
     
-    // Play a sound effect
-    void playSound(const std::string& name);
+    ~AudioManager();
+    
+    // Start and stop the audio thread. Commands pushed before start() wait
+    // for it; stopping silences everything
+    void start();
+    void stop();
+    
+    // Load every sound ahead of its first use, so the first shot or
+    // explosion doesn't wait for the disk
+    void preloadSounds();
     
-    // Initialize sound effects
-    void initializeSounds();
+    // Play a sound effect once (volume 0-100)
+    void playSound(SoundId sound, float volume = 100.0f);
     
-    // Update sounds (clean up finished sounds)
-    void update();
+    // Queue a sound for the next flush; copies of the same sound queued
+    // before a flush are merged into one louder sound
+    void queueSound(SoundId sound);
+    
+    // Play everything queued since the last flush
+    void flushQueuedSounds();
+    
+    // Start a sound looping, or resume it from where it was paused
+    void playLoop(SoundId sound);
+    void pauseLoop(SoundId sound);
+    void stopLoop(SoundId sound);
+    
+    // Volume of everything, 0-100
+    void setGain(float volume);
+    
+    // Sounds playing, as of the audio thread's last pass
+    std::size_t getActiveSoundCount() const;
+    
+    // Commands dropped because the audio thread had fallen behind
+    std::uint32_t getDroppedCommandCount() const;
 
 private:
+    static constexpr std::size_t SOUND_COUNT = static_cast<std::size_t>(SoundId::Count);
+    
+    enum class CommandType : std::uint8_t {
+        Preload,
+        Play,
+        PlayLoop,
+        PauseLoop,
+        StopLoop,
+        SetGain
+    };
+    
+    struct Command {
+        CommandType type;
+        SoundId sound;
+        float volume;
+    };
+    
     AudioManager();
     
-    std::unordered_map<std::string, sf::SoundBuffer> m_soundBuffers;
-    std::vector<std::unique_ptr<sf::Sound>> m_activeSounds;
+    void push(CommandType type, SoundId sound = SoundId::Count, float volume = 0.0f);
+    
+    // Body of the audio thread: run commands as they come in
+    void run();
+    
+    // Audio thread
+    void execute(const Command& command);
+    void removeFinishedSounds();
+    sf::SoundBuffer& getBuffer(SoundId sound);
+    
+    // Far more than a tick's worth of commands
+    static constexpr std::size_t COMMAND_CAPACITY = 256;
+    
+    // How long the audio thread sleeps between looks at the queue
+    static constexpr std::chrono::milliseconds IDLE_WAIT{1};
     
     // Maximum number of simultaneous sounds
     static constexpr unsigned int MAX_SOUNDS = 16;
+    
+    // Volume of a single queued sound, leaving headroom for merged ones
+    static constexpr float SOUND_EFFECT_VOLUME = 70.0f;
+    
+    SpscQueue<Command, COMMAND_CAPACITY> m_commands;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<std::uint32_t> m_activeSoundCount;
+    std::atomic<std::uint32_t> m_droppedCommands;
+    
+    // Audio thread
+    std::vector<std::unique_ptr<sf::Sound>> m_activeSounds;
+    std::array<std::optional<sf::Sound>, SOUND_COUNT> m_loops;
+    
+    // Producer: how often each sound was queued since the last flush
+    std::array<int, SOUND_COUNT> m_queuedCounts;
 };
@@ -1,15 +1,30 @@
 #pragma once
 
 #include "Entity.hpp"
+#include <cstdint>
 
 class Bullet : public Entity {
 public:
     Bullet(sf::Vector2f position, sf::Vector2f direction);
     
-    void update(float deltaTime) override;
-    void render(sf::RenderWindow& window) override;
+    // Lifetime tick the bullet disappears on, set when it's scheduled to expire
+    std::uint32_t getExpiryTick() const;
+    void setExpiryTick(std::uint32_t tick);
+    
+    // Expiry and motion, for keyframes of the simulation
+    void save(StateWriter& out) const;
+    static Bullet load(StateReader& in);
 
 private:
-    float m_lifetime;
-    sf::CircleShape m_shape;
+    std::uint32_t m_expiryTick;
 };
+
+inline std::uint32_t Bullet::getExpiryTick() const
+{
+    return m_expiryTick;
+}
+
+inline void Bullet::setExpiryTick(std::uint32_t tick)
+{
+    m_expiryTick = tick;
+}
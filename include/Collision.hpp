@@ -4,19 +4,40 @@
 #include "Player.hpp"
 #include "Asteroid.hpp"
 #include "Bullet.hpp"
-#include "Particle.hpp"  // Added include for Particle
-#include <vector>
-#include <memory>
+#include "EntityCommandBuffer.hpp"
+#include "GameEventQueue.hpp"
+#include "SlotMap.hpp"
+#include "SpatialIndex.hpp"
+#include <cstdint>
+#include <random>
+
+// Work done by one collision pass
+struct CollisionStats {
+    std::uint32_t pairsTested = 0;  // Shape tests run by the index lookups
+    std::uint32_t hits = 0;         // Tests that found an overlap
+};
 
 class Collision {
 public:
-    // Check for collisions between entities and handle them
-    static void checkCollisions(
+    // Check for collisions between entities and handle them.
+    // What happened is reported through events instead of being acted on here.
+    // The entity maps keep their shape: entities destroyed here are only
+    // marked inactive, and their removal and the asteroids they split into
+    // are recorded in commands for the end of the tick.
+    // Explosions are left to whoever reads the events.
+    // Candidates come from asteroidIndex, which must be synced with the
+    // asteroids' current positions; queries is scratch for the lookups.
+    static CollisionStats checkCollisions(
         Player& player,
-        std::vector<std::unique_ptr<Bullet>>& bullets,
-        std::vector<std::unique_ptr<Asteroid>>& asteroids,
-        std::vector<std::unique_ptr<Particle>>& particles,
-        int& score
+        SlotMap<Bullet>& bullets,
+        SlotMap<Asteroid>& asteroids,
+        const SpatialIndex& asteroidIndex,
+        SpatialQueryBatch& queries,
+        int& score,
+        const sf::Vector2f& spawnPosition,
+        std::mt19937& rng,
+        GameEventQueue& events,
+        EntityCommandBuffer& commands
     );
 
 private:
@@ -24,23 +45,22 @@ private:
     static void handleBulletAsteroidCollision(
         Bullet& bullet,
         Asteroid& asteroid,
-        std::vector<std::unique_ptr<Asteroid>>& asteroids,
-        std::vector<std::unique_ptr<Particle>>& particles,
-        int& score
+        int& score,
+        GameEventQueue& events
+    );
+    
+    // Record the smaller asteroids a destroyed one breaks into
+    static void splitAsteroid(
+        const Asteroid& asteroid,
+        std::mt19937& rng,
+        EntityCommandBuffer& commands
     );
     
     // Handle collision between player and asteroid
     static void handlePlayerAsteroidCollision(
         Player& player,
         Asteroid& asteroid,
-        std::vector<std::unique_ptr<Particle>>& particles
-    );
-    
-    // Create explosion particles
-    static void createExplosionParticles(
-        sf::Vector2f position,
-        std::vector<std::unique_ptr<Particle>>& particles,
-        sf::Color color = sf::Color::White,
-        int count = PARTICLES_ON_DESTROY
+        const sf::Vector2f& spawnPosition,
+        GameEventQueue& events
     );
 };
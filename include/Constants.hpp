@@ -4,6 +4,7 @@
 constexpr int WINDOW_WIDTH = 1024;
 constexpr int WINDOW_HEIGHT = 768;
 constexpr const char* WINDOW_TITLE = "Asteroids";
+constexpr float TARGET_FRAME_RATE = 60.0f;
 
 // Game settings
 constexpr float PLAYER_SPEED = 300.0f;
@@ -12,6 +13,8 @@ constexpr float PLAYER_FRICTION = 0.98f;
 constexpr float PLAYER_ACCELERATION = 10.0f;
 constexpr float PLAYER_MAX_SPEED = 500.0f;
 constexpr float PLAYER_INVULNERABILITY_TIME = 3.0f;
+constexpr float PLAYER_BLINK_INTERVAL = 0.1f;       // Hidden, then shown, while invulnerable
+constexpr float LEVEL_INTRO_TIME = 2.0f;            // Before the asteroids of a level move
 
 // Bullet settings
 constexpr float BULLET_SPEED = 600.0f;
@@ -38,6 +41,25 @@ constexpr float PARTICLE_LIFETIME_MAX = 1.0f;
 constexpr float PARTICLE_SPEED_MIN = 50.0f;
 constexpr float PARTICLE_SPEED_MAX = 150.0f;
 constexpr int PARTICLES_ON_DESTROY = 15;
+constexpr float EXHAUST_PARTICLES_PER_SECOND = 40.0f;
+
+// Bullet and particle lifetimes are counted in ticks of this rate on a clock
+// that runs while the game steps, and expire on a whole tick
+constexpr float LIFETIME_TICKS_PER_SECOND = 60.0f;
+
+// Rate of the clock timed game logic waits on (level intros, invulnerability),
+// which runs whenever the game is played, level intros included
+constexpr float TIMELINE_TICKS_PER_SECOND = 60.0f;
+
+// Effects quality, lowered at runtime when frames run over budget
+constexpr float EFFECTS_QUALITY_MIN = 0.25f;
+constexpr int PARTICLES_ON_DESTROY_MIN = 4;
+constexpr float EXHAUST_TRAIL_MIN_QUALITY = 0.75f;  // Trail is the first effect dropped
+
+// Default bounds of the world's render scale (fraction of the window's size
+// per axis), lowered at runtime when rendering runs over budget
+constexpr float RESOLUTION_SCALE_MIN = 0.5f;
+constexpr float RESOLUTION_SCALE_MAX = 1.0f;
 
 // Game states
 enum class GameState {
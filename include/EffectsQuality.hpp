@@ -0,0 +1,26 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include "Constants.hpp"
+
+// How much cosmetic detail the simulation spawns. Everything here is derived
+// from a single level in [EFFECTS_QUALITY_MIN, 1], so the level is all that
+// needs to travel between threads. None of it affects gameplay.
+struct EffectsQuality {
+    float level = 1.0f;
+    int particlesPerExplosion = PARTICLES_ON_DESTROY;
+    float particleLifetimeScale = 1.0f;   // Multiplies PARTICLE_LIFETIME_MIN/MAX
+    bool exhaustTrail = true;             // Particles behind the thrusting ship
+    
+    static EffectsQuality fromLevel(float level)
+    {
+        EffectsQuality quality;
+        quality.level = std::clamp(level, EFFECTS_QUALITY_MIN, 1.0f);
+        quality.particlesPerExplosion = std::max(PARTICLES_ON_DESTROY_MIN,
+            static_cast<int>(std::lround(PARTICLES_ON_DESTROY * quality.level)));
+        quality.particleLifetimeScale = 0.5f + 0.5f * quality.level;
+        quality.exhaustTrail = quality.level >= EXHAUST_TRAIL_MIN_QUALITY;
+        return quality;
+    }
+};
@@ -3,13 +3,13 @@
 #include <SFML/Graphics.hpp>
 #include "Constants.hpp"
 
+class StateReader;
+class StateWriter;
+
 class Entity {
 public:
     Entity(sf::Vector2f position, float radius);
     virtual ~Entity() = default;
-
-    virtual void update(float deltaTime) = 0;
-    virtual void render(sf::RenderWindow& window) = 0;
     
     // Check if the entity is active
     bool isActive() const;
@@ -20,6 +20,18 @@ public:
     // Get the position of the entity
     sf::Vector2f getPosition() const;
     
+    // Place the entity, e.g. after a batch motion update
+    void setPosition(sf::Vector2f position);
+    
+    // Get the velocity of the entity
+    sf::Vector2f getVelocity() const;
+    
+    // Get the rotation of the entity in degrees
+    float getRotation() const;
+    
+    // Set the rotation in degrees, expected in [0, 360)
+    void setRotation(float rotation);
+    
     // Get the radius for collision detection
     float getRadius() const;
     
@@ -27,15 +39,19 @@ public:
     EntityType getType() const;
     
     // Move the entity by the velocity
-    void move(float deltaTime);
+    void move(float deltaTime, const sf::Vector2f& worldSize);
     
     // Check if this entity collides with another
     bool collidesWith(const Entity& other) const;
     
-    // Wrap around screen edges
-    void wrapAroundScreen();
+    // Wrap around the edges of a world of the given size, keeping the overshoot
+    void wrapAroundScreen(const sf::Vector2f& worldSize);
 
 protected:
+    // Position, velocity and rotation, for the subclasses' save() and load()
+    void saveMotion(StateWriter& out) const;
+    void loadMotion(StateReader& in);
+    
     sf::Vector2f m_position;
     sf::Vector2f m_velocity;
     float m_rotation;
@@ -43,3 +59,46 @@ protected:
     bool m_active;
     EntityType m_type;
 };
+
+// Accessors used per entity in the batch motion and collision loops are
+// inline so those loops don't pay a call for every field
+
+inline bool Entity::isActive() const
+{
+    return m_active;
+}
+
+inline void Entity::setInactive()
+{
+    m_active = false;
+}
+
+inline sf::Vector2f Entity::getPosition() const
+{
+    return m_position;
+}
+
+inline void Entity::setPosition(sf::Vector2f position)
+{
+    m_position = position;
+}
+
+inline sf::Vector2f Entity::getVelocity() const
+{
+    return m_velocity;
+}
+
+inline float Entity::getRotation() const
+{
+    return m_rotation;
+}
+
+inline void Entity::setRotation(float rotation)
+{
+    m_rotation = rotation;
+}
+
+inline float Entity::getRadius() const
+{
+    return m_radius;
+}
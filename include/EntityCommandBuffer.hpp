@@ -0,0 +1,80 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "Asteroid.hpp"
+#include "Bullet.hpp"
+#include "Constants.hpp"
+#include "Particle.hpp"
+#include "SlotMap.hpp"
+#include "TimingWheel.hpp"
+
+// Spawns and despawns recorded during a simulation tick and applied together
+// at its end. Until apply() no entity map changes shape, so every system that
+// walks the maps during the tick (movement, collision) sees the same world
+// and can hold positions and references without them moving. Commands hold
+// plain values and handles, never references into the maps, which is also
+// what lets several producers record side by side later on.
+//
+// Entities are constructed in apply(), so the random draws they make happen
+// there, in recording order.
+class EntityCommandBuffer {
+public:
+    // Reserve room for a tick's commands; lists only grow past this on a
+    // tick that records more than any before it
+    void reserve(std::size_t asteroids, std::size_t bullets, std::size_t particles);
+    
+    void spawnAsteroid(sf::Vector2f position, AsteroidSize size);
+    void spawnBullet(sf::Vector2f position, sf::Vector2f direction);
+    void spawnParticle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, float lifetimeScale);
+    
+    // Remove an entity at the end of the tick; despawning twice, or an entity
+    // that is already gone, is harmless
+    void despawnAsteroid(SlotHandle handle);
+    void despawnBullet(SlotHandle handle);
+    void despawnParticle(SlotHandle handle);
+    
+    // Remove the despawned entities, then create the spawned ones (which may
+    // reuse the freed slots), and clear the buffer. Asteroids draw their
+    // shape from rng and particles their lifetime from effectsRng. New
+    // bullets and particles get an expiry tick their lifetime after the
+    // current tick of their wheel, and are scheduled in it
+    void apply(SlotMap<Asteroid>& asteroids, SlotMap<Bullet>& bullets, SlotMap<Particle>& particles,
+               std::mt19937& rng, std::mt19937& effectsRng,
+               TimingWheel& bulletExpiry, TimingWheel& particleExpiry);
+    
+    // Drop every recorded command
+    void clear();
+    
+    bool empty() const;
+    
+    std::size_t getSpawnCount() const;
+    std::size_t getDespawnCount() const;
+
+private:
+    struct AsteroidSpawn {
+        sf::Vector2f position;
+        AsteroidSize size;
+    };
+    
+    struct BulletSpawn {
+        sf::Vector2f position;
+        sf::Vector2f direction;
+    };
+    
+    struct ParticleSpawn {
+        sf::Vector2f position;
+        sf::Vector2f velocity;
+        sf::Color color;
+        float lifetimeScale;
+    };
+    
+    std::vector<AsteroidSpawn> m_asteroidSpawns;
+    std::vector<BulletSpawn> m_bulletSpawns;
+    std::vector<ParticleSpawn> m_particleSpawns;
+    std::vector<SlotHandle> m_asteroidDespawns;
+    std::vector<SlotHandle> m_bulletDespawns;
+    std::vector<SlotHandle> m_particleDespawns;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Player.hpp"
+
+// Always-on record of the last few minutes of simulation ticks, for working
+// out what led up to a crash. Each tick stores what went into it (input,
+// menu actions, delta time, effects level) and what came out (entity counts,
+// score, state, phase timings) in a fixed ring allocated once, so recording
+// is a copy of a few dozen bytes.
+//
+// Every KEYFRAME_INTERVAL ticks the whole simulation state is also saved,
+// into a second ring of KEYFRAME_SLOTS buffers, so the same game can be run
+// again tick by tick (AsteroidsHeadless --flight-replay) from the newest
+// keyframe in a dump, however long the game ran. A dump that reaches back to
+// the first tick can also be run from the seed and world size in its header.
+//
+// dump() writes both rings with plain open/write calls and no allocation, so
+// it is safe to call from the fatal signal handlers installSignalHandlers()
+// sets up as well as from catch blocks.
+class Simulation;
+
+namespace FlightRecorder {
+
+// Ticks kept, a little over nine minutes at 60 Hz
+constexpr std::size_t CAPACITY = 32768;
+
+// A keyframe about every 17 seconds at 60 Hz, so the ring of ticks always
+// reaches back past the older one
+constexpr std::uint64_t KEYFRAME_INTERVAL = 1024;
+constexpr std::size_t KEYFRAME_SLOTS = 2;
+
+// Room for one keyframe at first, plenty for a world of a few screens.
+// A slot grows to fit a state that outgrew it, so large worlds only pay
+// for the state they have
+constexpr std::size_t KEYFRAME_BYTES = 1024 * 1024;
+
+// Bits of TickRecord::actions
+enum TickAction : std::uint8_t {
+    ACTION_START_GAME = 1u << 0,    // startGame() before the update
+    ACTION_TOGGLE_PAUSE = 1u << 1   // togglePause() before the update
+};
+
+struct TickRecord {
+    std::uint64_t tick;             // From 1, set by record()
+    float deltaTime;
+    float effectsLevel;
+    std::uint32_t asteroids;        // After the tick
+    std::uint32_t sleepingAsteroids;
+    std::uint32_t bullets;
+    std::uint32_t particles;
+    std::int32_t score;
+    std::uint16_t updateUs;         // Input, simulation step and sound commands
+    std::uint16_t captureUs;        // Snapshot and replay recording
+    std::uint16_t publishUs;        // Handing the snapshot and metrics over
+    std::uint8_t input;             // packInput()
+    std::uint8_t actions;           // TickAction bits
+    std::uint8_t state;             // GameState after the tick
+    std::uint8_t lives;
+    std::uint16_t padding;
+};
+
+struct Keyframe {
+    std::uint64_t tick;             // State after this tick
+    std::vector<std::uint8_t> state;    // Simulation::saveState()
+};
+
+// Everything in a dump file
+struct Dump {
+    std::uint32_t seed = 0;
+    float worldWidth = 0.0f;
+    float worldHeight = 0.0f;
+    std::string reason;
+    std::vector<TickRecord> ticks;  // Oldest first
+    std::vector<Keyframe> keyframes;    // Oldest first, whole ones only
+    std::uint64_t droppedKeyframes = 0; // Saves that found no memory for the state
+};
+
+// Start recording a simulation created with this seed and world size, and
+// pick the file a dump goes to (crash-<time>-<pid>.flight)
+void begin(std::uint32_t seed, float worldWidth, float worldHeight);
+
+// Append a tick, overwriting the oldest once the ring is full. One thread only
+void record(const TickRecord& record);
+
+// Call after every record(), on the same thread: every KEYFRAME_INTERVAL
+// ticks, saves the simulation's state after the tick just recorded over the
+// oldest keyframe. Only allocates when the state has outgrown its slot; a
+// keyframe there's no memory for is dropped and counted in the dump
+void recordKeyframe(const Simulation& simulation);
+
+// Write the recorded ticks, keyframes and reason to the dump file. Async-signal-safe;
+// returns false if nothing was recorded or the file couldn't be written
+bool dump(const char* reason);
+
+const char* getDumpPath();
+
+// Dump on SIGSEGV, SIGABRT, SIGFPE, SIGILL and SIGBUS, then let the signal
+// take its course. Also installs the calling thread's stack for the handler.
+// No-op where POSIX signals aren't available
+void installSignalHandlers();
+
+// Give the calling thread its own stack to run the handler on, so a thread
+// that overflows its stack still gets a dump. Call at the top of every
+// long-lived thread; calling again does nothing
+void installThreadStack();
+
+// Read a dump file back
+bool load(const std::string& path, Dump& dump);
+
+// PlayerInput as bits and back
+std::uint8_t packInput(const PlayerInput& input);
+PlayerInput unpackInput(std::uint8_t bits);
+
+}
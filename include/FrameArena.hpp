@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Linear allocator for memory that only lives until the end of a frame or
+// tick. Allocation bumps an offset, deallocation does nothing and reset()
+// rewinds everything at once. Use it through std::pmr containers and strings.
+//
+// When a frame needs more than the capacity, the extra comes from the heap
+// and the arena grows to fit on the next reset, so a steady workload settles
+// into zero heap allocations.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(std::size_t capacity);
+    ~FrameArena() override;
+    
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    
+    // Free everything allocated since the last reset
+    void reset();
+    
+    // Bytes handed out since the last reset, including overflow
+    std::size_t getUsed() const;
+    
+    std::size_t getCapacity() const;
+    
+    // Most bytes used between two resets
+    std::size_t getPeak() const;
+    
+    // Allocations that didn't fit and went to the heap, since construction
+    std::size_t getOverflowCount() const;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    
+    // Heap block for an allocation that didn't fit
+    struct Overflow {
+        void* pointer;
+        std::size_t alignment;
+    };
+    
+    std::unique_ptr<std::byte[]> m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_offset;
+    std::size_t m_peak;
+    
+    std::vector<Overflow> m_overflow;
+    std::size_t m_overflowBytes;
+    std::size_t m_overflowCount;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Paces the game loop to a target frame rate. Waits sleep for most of the
+// remaining frame time and spin for the last part, where the split is tuned
+// to the measured sleep overshoot of this machine. Frame deadlines advance by
+// a fixed period, so one slow frame doesn't shift every frame after it.
+//
+// Also keeps the last HISTORY_SIZE frame times with a rolling histogram for
+// jitter and percentile queries.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    static constexpr std::size_t HISTORY_SIZE = 240;
+    static constexpr std::size_t HISTOGRAM_BINS = 64;
+    static constexpr std::uint32_t HISTOGRAM_BIN_US = 500;  // 0.5 ms per bin, last bin holds overflow
+    
+    explicit FramePacer(float targetRate = 60.0f);
+    
+    // Frames per second to pace to, 0 = don't wait at all
+    void setTargetRate(float targetRate);
+    float getTargetRate() const;
+    
+    // Measure how late short sleeps wake up and set the spin threshold from it
+    void calibrate();
+    
+    // Wait until the next frame is due, returns seconds since the previous call
+    float waitForNextFrame();
+    
+    // Forget deadlines and statistics, e.g. after the window was dragged
+    void reset();
+    
+    // Statistics over the last getSampleCount() frames, in milliseconds
+    std::size_t getSampleCount() const;
+    float getMeanFrameTime() const;
+    float getJitter() const;                   // standard deviation of frame times
+    float getPercentile(float percent) const;  // 0-100
+    float getWorstFrameTime() const;
+    
+    // Time the last frame spent working, from the end of one wait to the
+    // start of the next, in milliseconds. Unlike frame times this shows how
+    // close the loop is to missing its deadline.
+    float getWorkTime() const;
+    
+    const std::array<std::uint32_t, HISTOGRAM_BINS>& getHistogram() const;
+    
+    // Current wait tuning, in milliseconds
+    float getSleepOvershoot() const;
+    float getSpinThreshold() const;
+
+private:
+    // Sleep then spin until the deadline
+    void waitUntil(Clock::time_point deadline);
+    
+    // Fold one measured sleep overshoot into the spin threshold
+    void recordOvershoot(Clock::duration overshoot);
+    
+    void recordFrame(std::uint32_t frameTimeUs);
+    
+    Clock::duration m_period;
+    Clock::time_point m_deadline;
+    Clock::time_point m_lastFrame;
+    Clock::duration m_workTime;
+    bool m_started;
+    
+    // Smoothed and peak (slowly decaying) sleep overshoot, in microseconds
+    float m_overshootAverage;
+    float m_overshootPeak;
+    Clock::duration m_spinThreshold;
+    
+    // Ring buffer of frame times in microseconds with exact running sums
+    std::array<std::uint32_t, HISTORY_SIZE> m_history;
+    std::size_t m_historyNext;
+    std::size_t m_historyCount;
+    std::uint64_t m_sum;
+    std::uint64_t m_sumSquares;
+    std::array<std::uint32_t, HISTOGRAM_BINS> m_histogram;
+    
+    // Scratch space for percentile queries
+    mutable std::vector<std::uint32_t> m_sorted;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Constants.hpp"
+
+// Plain copy of everything needed to draw one frame. It holds no SFML
+// objects, so it can be rendered by any backend or sent elsewhere.
+
+struct SnapshotColor {
+    std::uint8_t r = 255;
+    std::uint8_t g = 255;
+    std::uint8_t b = 255;
+    std::uint8_t a = 255;
+};
+
+struct SnapshotAsteroid {
+    float x, y;
+    float rotation;               // Degrees
+    std::uint32_t firstVertex;    // Index into FrameSnapshot::asteroidVertices (pairs of floats)
+    std::uint32_t vertexCount;
+};
+
+struct SnapshotBullet {
+    float x, y;
+    float radius;
+};
+
+struct SnapshotParticle {
+    float x, y;
+    SnapshotColor color;
+};
+
+struct SnapshotPlayer {
+    float x = 0.0f, y = 0.0f;
+    float rotation = 0.0f;        // Degrees
+    bool visible = true;          // False during the invulnerability blink
+    bool thrusting = false;
+};
+
+struct FrameSnapshot {
+    GameState state = GameState::MainMenu;
+    int score = 0;
+    int level = 1;
+    int lives = 0;
+    float worldWidth = static_cast<float>(WINDOW_WIDTH);
+    float worldHeight = static_cast<float>(WINDOW_HEIGHT);
+    
+    // InputQueue::now() time of the newest key press applied so far, for
+    // measuring input latency; not recorded in replays
+    std::uint64_t inputTime = 0;
+    
+    SnapshotPlayer player;
+    std::vector<SnapshotAsteroid> asteroids;
+    std::vector<float> asteroidVertices;  // Local-space outline points, x then y
+    std::vector<SnapshotBullet> bullets;
+    std::vector<SnapshotParticle> particles;
+    
+    // Empty the entity lists, keeping their capacity
+    void clear()
+    {
+        asteroids.clear();
+        asteroidVertices.clear();
+        bullets.clear();
+        particles.clear();
+    }
+};
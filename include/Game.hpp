@@ -1,18 +1,55 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <vector>
-#include <memory>
-#include "Player.hpp"
-#include "Asteroid.hpp"
-#include "Bullet.hpp"
-#include "Particle.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <thread>
+#include "FrameArena.hpp"
+#include "FlightRecorder.hpp"
+#include "FrameSnapshot.hpp"
+#include "FramePacer.hpp"
+#include "InputQueue.hpp"
+#include "MetricsPage.hpp"
+#include "QualityGovernor.hpp"
+#include "Replay.hpp"
+#include "ResolutionScaler.hpp"
+#include "Simulation.hpp"
+#include "Spectator.hpp"
+#include "TripleBuffer.hpp"
 #include "UI.hpp"
+#include "WorldRenderer.hpp"
 #include "Constants.hpp"
 
+// Everything a game is started with
+struct GameConfig {
+    // Size of the world the simulation wraps around in; the camera follows
+    // the player when it's bigger than the window
+    sf::Vector2f worldSize = sf::Vector2f(static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT));
+    
+    // Bounds of the world's render scale, see ResolutionScaler
+    float minResolutionScale = RESOLUTION_SCALE_MIN;
+    float maxResolutionScale = RESOLUTION_SCALE_MAX;
+    
+    // Loopback port to broadcast every tick to spectators on, 0 = off
+    std::uint16_t spectatePort = 0;
+};
+
+// Runs the simulation on its own thread and draws on the main thread. Each
+// simulation step publishes a FrameSnapshot through a triple buffer and the
+// main thread draws whichever snapshot is newest, so neither waits for the
+// other and a slow frame (or a display() blocking on vsync) no longer delays
+// the next update.
+//
+// Only the simulation thread touches m_simulation and sends sound commands,
+// which AudioManager plays on a thread of its own. Keys travel the other way
+// through a timestamped InputQueue.
 class Game {
 public:
-    Game();
+    explicit Game(const GameConfig& config = GameConfig());
+    ~Game();
     
     // Initialize the game
     void init();
@@ -21,48 +58,142 @@ public:
     void run();
 
 private:
-    // Handle user input
-    void handleInput();
+    // Keys the simulation thread cares about, as bits of InputQueue events
+    enum InputKey : std::uint32_t {
+        KEY_THRUST = 1u << 0,
+        KEY_ROTATE_LEFT = 1u << 1,
+        KEY_ROTATE_RIGHT = 1u << 2,
+        KEY_SPACE = 1u << 3,
+        KEY_PAUSE = 1u << 4,
+        KEY_RECORD = 1u << 5
+    };
+    
+    // A keyboard key and the InputKey it holds down
+    struct KeyBinding {
+        sf::Keyboard::Key key;
+        std::uint32_t inputKey;
+    };
+    static const std::array<KeyBinding, 9> KEY_BINDINGS;
+    
+    // Turn a key going down or up into InputQueue events for the simulation
+    // thread, or run the hotkey it is bound to (main thread)
+    void handleKey(sf::Keyboard::Key key, bool pressed, std::uint64_t time);
+    
+    // Send the InputKey changes that a new set of bound keys down makes
+    void setBoundKeys(std::uint32_t boundKeysDown, std::uint64_t time);
     
-    // Update game state
+    // Start recording profiling zones, or stop and save them as a trace
+    void toggleTraceRecording();
+    
+    // Start and stop the simulation thread
+    void startSimulation();
+    void stopSimulation();
+    
+    // Body of the simulation thread: step, play sounds, publish a snapshot
+    void runSimulation();
+    
+    // Update game state (simulation thread)
     void update(float deltaTime);
     
-    // Render the game
+    // Turn the key events up to now into player input and menu actions
+    PlayerInput consumeInput();
+    
+    // Start recording a replay, or finish the one being recorded (simulation thread)
+    void toggleReplayRecording();
+    
+    // Render the newest snapshot
     void render();
     
-    // Initialize a new level
-    void initLevel();
+    // Draw the world into m_worldTarget at the scaler's current scale and
+    // stretch it over the window; straight to the window if there is no target
+    void renderWorld(const FrameSnapshot& snapshot);
+    
+    // Turn the simulation's events from the last update into sounds
+    void playEventSounds();
     
-    // Create a new bullet
-    void createBullet();
+    // Resume or pause the looping thrust sound when the player starts or stops thrusting
+    void updateThrustSound();
     
-    // Clean up inactive entities
-    void cleanupEntities();
+    // Rewind the frame arena and record this frame's heap use
+    void endFrame();
     
-    // Reset the game
-    void resetGame();
+    // Finish the tick's flight recorder entry with its outcome and record it
+    void recordFlightTick();
     
-    // Window and rendering
+    // Live counters for external monitors, one section per thread
+    void publishSimulationMetrics();
+    void publishRenderMetrics(std::uint32_t drawCalls);
+    
+    // Measure input latency if the snapshot just shown is the first with a new press
+    void recordInputLatency(const FrameSnapshot& snapshot);
+    
+    // Print heap use per subsystem since startup (allocation tracking builds)
+    void printAllocationReport() const;
+    
+    // Window and rendering (main thread)
     sf::RenderWindow m_window;
-    sf::Clock m_clock;
+    FramePacer m_framePacer;
     float m_deltaTime;
+    WorldRenderer m_worldRenderer;
+    
+    // The world is drawn offscreen at a resolution that follows the main
+    // thread's load, then scaled up to the window under the native-size HUD.
+    // The target is window-sized and the world takes its top-left corner, so
+    // a change of scale never reallocates it
+    sf::RenderTexture m_worldTarget;
+    std::optional<sf::Sprite> m_worldSprite;    // Empty if the target couldn't be created
+    ResolutionScaler m_resolutionScaler;
+    
+    // Lowers effects detail when either thread runs close to its frame budget
+    QualityGovernor m_qualityGovernor;
+    std::atomic<float> m_effectsLevel;
+    std::atomic<float> m_simulationWorkTime;  // Milliseconds, last simulation step
+    
+    // Shared-memory page read by AsteroidsMetrics
+    MetricsPublisher m_metrics;
+    std::uint64_t m_frameCount;   // Main thread
+    std::uint64_t m_tickCount;    // Simulation thread
     
-    // Game state
-    GameState m_gameState;
-    int m_score;
-    int m_level;
-    float m_levelStartTimer;
+    // Transient memory for one frame, rewound at the end of every loop iteration
+    FrameArena m_frameArena;
+    FrameMemoryStats m_memoryStats;
     
-    // Entities
-    Player m_player;
-    std::vector<std::unique_ptr<Asteroid>> m_asteroids;
-    std::vector<std::unique_ptr<Bullet>> m_bullets;
-    std::vector<std::unique_ptr<Particle>> m_particles;
+    // Game state and entities (simulation thread)
+    Simulation m_simulation;
+    FramePacer m_simulationPacer;
+    ReplayWriter m_replayWriter;
+    SpectatorBroadcaster m_spectators;
+    FlightRecorder::TickRecord m_flightTick;    // Filled in over the tick
+    
+    // Newest simulation state for the renderer
+    TripleBuffer<FrameSnapshot> m_snapshots;
+    
+    std::thread m_simulationThread;
+    std::atomic<bool> m_simulationRunning;
+    std::exception_ptr m_simulationError;  // Set by the simulation thread before it stops
     
     // UI
     UI m_ui;
     
-    // Input control
-    bool m_spacePressed;
-    bool m_pPressed;
+    // Whether the thrust loop was last told to play (simulation thread)
+    bool m_thrustSoundPlaying;
+    
+    // Input control: key events for the simulation thread, the bound keys
+    // down now (one bit per binding, main thread) and the InputKey bits they
+    // add up to, so a key repeat or a second binding of the same InputKey
+    // doesn't send another event
+    InputQueue m_input;
+    std::uint32_t m_boundKeysDown;
+    std::uint32_t m_inputKeysDown;
+    std::uint64_t m_lastPressTime;      // Simulation thread, newest press applied
+    
+    // Newest press already measured by recordInputLatency
+    std::uint64_t m_lastShownPressTime;
+    InputLatency m_inputLatency;
+    
+    bool m_showFrameStats;
+    
+    // The trace being recorded
+    std::uint64_t m_traceStart;
+    unsigned int m_traceCount;
 };
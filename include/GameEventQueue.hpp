@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+#include "Constants.hpp"
+
+// Things that happened during a simulation tick that the front-end may react to
+enum class GameEventType {
+    BulletFired,
+    AsteroidDestroyed,
+    PlayerHit
+};
+
+struct GameEvent {
+    GameEventType type;
+    sf::Vector2f position;
+    AsteroidSize asteroidSize;  // Only meaningful for AsteroidDestroyed
+};
+
+// Events emitted during one simulation tick, in the order they happened.
+// The simulation clears it at the start of every tick; front-ends read it
+// after the tick and handle the whole batch at once.
+class GameEventQueue {
+public:
+    GameEventQueue();
+    
+    void push(GameEventType type, const sf::Vector2f& position, AsteroidSize asteroidSize = AsteroidSize::Small);
+    void clear();
+    
+    bool empty() const;
+    std::size_t size() const;
+    const std::vector<GameEvent>& getEvents() const;
+
+private:
+    std::vector<GameEvent> m_events;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Printable ASCII of one font rasterised at a fixed set of character sizes
+// and packed into a single texture, together with the metrics sf::Text uses
+// to lay glyphs out.
+//
+// The packed pixels and metrics are cached on disk. With a valid cache the
+// font file isn't opened at all, so the HUD costs one small file read and one
+// texture upload instead of FreeType rasterising every glyph at every size.
+// The cache is rebuilt whenever the font file or the list of sizes changes.
+class GlyphAtlas {
+public:
+    static constexpr char32_t FIRST_CHARACTER = U' ';
+    static constexpr char32_t LAST_CHARACTER = U'~';
+    static constexpr std::size_t CHARACTER_COUNT = LAST_CHARACTER - FIRST_CHARACTER + 1;
+    
+    // Where and how big a glyph is, in the same terms as sf::Glyph
+    struct Glyph {
+        float advance;
+        float left, top, width, height;     // Bounds relative to the pen position on the baseline
+        std::int32_t x, y, w, h;            // Texture rectangle in the atlas
+    };
+    
+    // Extra advance between two characters
+    struct Kerning {
+        std::uint32_t pair;                 // First character << 8 | second character
+        float offset;
+    };
+    
+    // All glyphs at one character size
+    struct Page {
+        unsigned int characterSize = 0;
+        float lineSpacing = 0.f;
+        std::array<Glyph, CHARACTER_COUNT> glyphs{};
+        std::vector<Kerning> kerning;       // Non-zero pairs only, sorted by pair
+        
+        // Characters outside printable ASCII are drawn as '?'
+        const Glyph& getGlyph(char32_t character) const;
+        float getKerning(char32_t first, char32_t second) const;
+    };
+    
+    GlyphAtlas();
+    
+    // Load the font's glyphs at the given sizes from cachePath, or rasterise
+    // them with ResourceManager's copy of the font and write the cache. False
+    // if there is no cache and the font can't be loaded
+    bool load(const std::string& fontFilename, const std::vector<unsigned int>& sizes, const std::string& cachePath);
+    
+    bool isLoaded() const;
+    
+    // True if the last load came from the disk cache
+    bool wasCached() const;
+    
+    const sf::Texture& getTexture() const;
+    
+    // The page for a size the atlas was loaded with, or nullptr
+    const Page* getPage(unsigned int characterSize) const;
+
+private:
+    // Read the cache; false if it's missing or was made for another font or sizes
+    bool readCache(const std::string& path, std::uint64_t fontBytes, std::int64_t fontTime,
+                   const std::vector<unsigned int>& sizes);
+    
+    // Rasterise every page with the font and pack them into m_alpha
+    bool rasterise(const std::string& fontFilename, const std::vector<unsigned int>& sizes);
+    
+    // Write the cache through a temporary file; false (and no cache) on failure
+    bool writeCache(const std::string& path, std::uint64_t fontBytes, std::int64_t fontTime) const;
+    
+    // Upload m_alpha as white pixels with that alpha
+    bool createTexture();
+    
+    std::vector<Page> m_pages;
+    std::vector<std::uint8_t> m_alpha;      // Coverage of every atlas pixel
+    sf::Vector2u m_size;
+    sf::Texture m_texture;
+    bool m_loaded;
+    bool m_cached;
+};
+
+// A line (or lines) of text drawn from a GlyphAtlas page. Lays glyphs out the
+// way sf::Text does, but all of them come from one texture, and setString()
+// reuses the text's storage so an updating label doesn't allocate once it's
+// held its longest value.
+class AtlasText : public sf::Drawable, public sf::Transformable {
+public:
+    // characterSize must be one of the atlas's sizes
+    AtlasText(const GlyphAtlas& atlas, std::string_view value, unsigned int characterSize);
+    
+    // No-op when unchanged
+    void setString(std::string_view value);
+    void setFillColor(sf::Color color);
+    
+    // Bounds of the laid out glyphs, before the transform
+    sf::FloatRect getLocalBounds() const;
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    
+    // Lay the string out again
+    void updateGeometry();
+    
+    const GlyphAtlas* m_atlas;
+    const GlyphAtlas::Page* m_page;
+    std::string m_string;
+    sf::Color m_fillColor;
+    std::vector<sf::Vertex> m_vertices;
+    sf::FloatRect m_bounds;
+};
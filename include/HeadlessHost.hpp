@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "SoftwareRenderer.hpp"
+#include "Spectator.hpp"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Settings for a batch of headless game instances
+struct HeadlessHostConfig {
+    unsigned int instanceCount = 64;
+    unsigned int threadCount = 0;      // 0 = one worker per hardware thread
+    unsigned int ticks = 3600;         // Ticks to run every instance for
+    float tickRate = 60.0f;            // Simulated ticks per second
+    bool pinThreads = true;            // Pin each worker to one CPU (Linux only)
+    SimulationConfig simulation;       // Template for every instance; seeds are derived per instance
+    
+    // Frame capture through the software renderer (0 = off)
+    unsigned int captureInterval = 0;  // Save a frame of every instance every N ticks
+    std::string captureDirectory = ".";
+    unsigned int captureWidth = 256;
+    unsigned int captureHeight = 192;
+    PixelFormat captureFormat = PixelFormat::RGBA8;
+    
+    // Fail steady-state ticks that allocate (needs ASTEROIDS_TRACK_ALLOCATIONS).
+    // A tick is steady when it raises no events and nothing spawns, levels up
+    // or changes state.
+    bool checkAllocations = false;
+    unsigned int warmupTicks = 600;    // Ticks to run before checking
+    
+    // Record every tick of instance 0 to a replay file (empty = off)
+    std::string recordPath;
+    
+    // Broadcast every tick of instance 0 to spectators on this loopback port (0 = off)
+    std::uint16_t spectatePort = 0;
+};
+
+// Tick cost and game results for one instance
+struct alignas(64) InstanceStats {
+    std::uint64_t ticks = 0;
+    std::uint64_t totalNanoseconds = 0;
+    std::uint64_t maxNanoseconds = 0;
+    unsigned int worker = 0;
+    int gamesPlayed = 0;
+    int bestScore = 0;
+    
+    // Allocation check results
+    std::uint64_t steadyTicks = 0;
+    std::uint64_t allocatingTicks = 0;
+    std::int64_t firstAllocatingTick = -1;
+};
+
+// Runs many independent simulations in one process. Instances are split
+// statically between worker threads; each instance is created, stepped and
+// destroyed on its own worker and shares no mutable state with the others.
+class HeadlessHost {
+public:
+    explicit HeadlessHost(const HeadlessHostConfig& config);
+    
+    // Run every instance for the configured number of ticks (blocks until done)
+    void run();
+    
+    // Per-instance results of the last run, indexed by instance
+    const std::vector<InstanceStats>& getStats() const;
+    
+    // False if the allocation check was on and a steady-state tick allocated
+    bool passedAllocationCheck() const;
+    
+    // Print a summary of the last run, plus one line per instance when verbose
+    void printReport(std::ostream& out, bool verbose) const;
+
+private:
+    // Worker thread body: owns and steps the instances [first, last)
+    void runWorker(unsigned int worker, unsigned int first, unsigned int last);
+    
+    HeadlessHostConfig m_config;
+    std::vector<InstanceStats> m_stats;
+    double m_wallSeconds;
+    
+    // Recording and broadcast of instance 0, fed by the worker that owns it
+    ReplayWriter m_replay;
+    SpectatorBroadcaster m_spectators;
+};
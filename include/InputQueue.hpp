@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "SpscQueue.hpp"
+
+// Some keys went down or up
+struct InputEvent {
+    std::uint64_t time;     // InputQueue::now() when the window reported it
+    std::uint32_t keys;     // Bits that changed
+    bool pressed;
+};
+
+// Keys as one simulation tick sees them
+struct InputFrame {
+    std::uint32_t held = 0;             // Down at the tick's time
+    std::uint32_t pressed = 0;          // Went down since the previous tick, even if already up again
+    std::uint64_t lastPressTime = 0;    // Newest of those presses, 0 if there were none
+};
+
+// Key changes from the window's event loop (main thread) to the simulation
+// thread, in order and with the time each was read. Each tick drains the
+// events up to its own start time, so a press lands in the tick it happened
+// before, and one that went down and up again between two ticks still
+// counts as pressed for one tick instead of falling between two samples.
+class InputQueue {
+public:
+    // Events between two ticks; far more than anyone can type
+    static constexpr std::size_t CAPACITY = 256;
+    
+    // Monotonic clock for event times, in nanoseconds
+    static std::uint64_t now();
+    
+    // Main thread: keys went down (or up) at time. Dropped and counted if
+    // the simulation has fallen CAPACITY events behind
+    void push(std::uint32_t keys, bool pressed, std::uint64_t time);
+    
+    // Simulation thread: apply the events up to time
+    InputFrame drain(std::uint64_t time);
+    
+    std::uint32_t getDroppedCount() const;
+
+private:
+    SpscQueue<InputEvent, CAPACITY> m_events;
+    std::uint32_t m_held = 0;                   // Simulation thread
+    std::atomic<std::uint32_t> m_dropped{0};
+};
+
+// Time from a key press being read to the first frame showing its effect
+// handed to the display, over the last HISTORY_SIZE presses
+class InputLatency {
+public:
+    static constexpr std::size_t HISTORY_SIZE = 64;
+    
+    void record(float latencyMs);
+    
+    // Milliseconds, 0 before the first press
+    float getLast() const;
+    float getMean() const;
+    float getWorst() const;
+    std::size_t getSampleCount() const;
+
+private:
+    std::array<float, HISTORY_SIZE> m_history{};
+    std::size_t m_next = 0;
+    std::size_t m_count = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// Hysteresis over the frame load that the runtime quality controllers share.
+// Fed the work time of every frame, it keeps a smoothed load (work time /
+// frame budget) and says when to step down or up to keep it in a band:
+//
+// - over HIGH_LOAD for a few frames in a row: step down, then wait for the
+//   smoothed load to catch up before stepping again;
+// - under LOW_LOAD for about a second: step up.
+//
+// Between the two thresholds nothing changes, and stepping up takes much
+// longer than stepping down, so a controller settles instead of flapping
+// around the budget. How big each step is stays with the controller.
+class LoadBand {
+public:
+    static constexpr float HIGH_LOAD = 0.85f;
+    static constexpr float LOW_LOAD = 0.6f;
+    
+    enum class Step {
+        None,
+        Down,
+        Up
+    };
+    
+    // cooldownFrames: frames to let the smoothed load settle after a step
+    LoadBand(float budgetMs, int cooldownFrames);
+    
+    // Frame time budget in milliseconds
+    void setBudget(float budgetMs);
+    float getBudget() const;
+    
+    // Account for one frame that spent workMs working, and say which way to
+    // step. canStepDown/canStepUp are false at the controller's limits; a
+    // step that is returned has to be taken
+    Step recordFrame(float workMs, bool canStepDown, bool canStepUp);
+    
+    // No history and no steps counted
+    void reset();
+    
+    float getLoad() const;                  // Smoothed work time / budget
+    std::uint32_t getDownCount() const;
+    std::uint32_t getUpCount() const;
+
+private:
+    float m_budget;
+    int m_cooldown;
+    float m_load;
+    int m_overFrames;      // Consecutive frames over HIGH_LOAD
+    int m_underFrames;     // Consecutive frames under LOW_LOAD
+    int m_cooldownFrames;  // Frames left before another step is allowed
+    std::uint32_t m_downs;
+    std::uint32_t m_ups;
+};
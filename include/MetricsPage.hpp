@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Seqlock.hpp"
+
+// Live counters of a running game, published in a shared-memory segment so
+// a monitor in another process can watch them without touching the game.
+// Each thread of the game owns one section and rewrites it once per step or
+// frame; readers copy a section out under its seqlock and never write, so
+// they cannot slow the writer down or see half an update.
+//
+// The layout is fixed-size and plain data. Change METRICS_PAGE_VERSION
+// whenever it changes, so an old reader refuses a new page instead of
+// misreading it.
+constexpr std::uint32_t METRICS_PAGE_MAGIC = 0x4D545341u;  // "ASTM"
+constexpr std::uint32_t METRICS_PAGE_VERSION = 4;
+
+// Written by the simulation thread after every step
+struct SimulationMetrics {
+    std::uint64_t tick = 0;
+    std::int32_t state = 0;                 // GameState
+    std::int32_t score = 0;
+    std::int32_t level = 0;
+    std::uint32_t asteroids = 0;
+    std::uint32_t sleepingAsteroids = 0;    // In far sectors of a large world
+    std::uint32_t bullets = 0;
+    std::uint32_t particles = 0;
+    std::uint32_t collisionPairsTested = 0;  // Last step
+    std::uint32_t collisionHits = 0;         // Last step
+    std::uint32_t activeSounds = 0;
+    float tickTimeMs = 0.0f;                // Work time of the last step
+    float effectsLevel = 0.0f;
+};
+
+// Written by the main thread after every frame
+struct RenderMetrics {
+    std::uint64_t frame = 0;
+    std::uint32_t drawCalls = 0;            // Last frame
+    float frameTimeMs = 0.0f;               // Time since the previous frame
+    float workTimeMs = 0.0f;                // Time spent rendering the last frame
+    float jitterMs = 0.0f;
+    float resolutionScale = 1.0f;           // World render scale, per axis
+    float inputLatencyMs = 0.0f;            // Last key press read to its frame displayed
+};
+
+struct MetricsPage {
+    std::atomic<std::uint32_t> magic;       // Stored last, once the rest is set up
+    std::uint32_t version;
+    std::uint32_t size;                     // sizeof(MetricsPage)
+    std::int32_t pid;                       // Process that owns the page
+    Seqlock<SimulationMetrics> simulation;
+    Seqlock<RenderMetrics> render;
+};
+
+// Creates the page and writes to it (the game)
+class MetricsPublisher {
+public:
+    MetricsPublisher();
+    ~MetricsPublisher();
+    
+    MetricsPublisher(const MetricsPublisher&) = delete;
+    MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+    
+    // Create the segment for this process; false if shared memory isn't
+    // available, in which case the publish calls do nothing
+    bool open();
+    
+    // Unmap and remove the segment
+    void close();
+    
+    bool isOpen() const;
+    const std::string& getName() const;
+    
+    // Each section must only be published from one thread
+    void publishSimulation(const SimulationMetrics& metrics);
+    void publishRender(const RenderMetrics& metrics);
+
+private:
+    MetricsPage* m_page;
+    std::string m_name;
+};
+
+// Maps another process's page read-only (the monitor)
+class MetricsReader {
+public:
+    MetricsReader();
+    ~MetricsReader();
+    
+    MetricsReader(const MetricsReader&) = delete;
+    MetricsReader& operator=(const MetricsReader&) = delete;
+    
+    // Map a page by segment name; false if it doesn't exist or isn't a
+    // page this reader understands
+    bool open(const std::string& name);
+    void close();
+    
+    bool isOpen() const;
+    
+    // Process that owns the page
+    std::int32_t getPid() const;
+    
+    // Consistent copies of the sections
+    SimulationMetrics readSimulation() const;
+    RenderMetrics readRender() const;
+
+private:
+    const MetricsPage* m_page;
+};
+
+namespace Metrics {
+
+// Segment name of a process's page, "/asteroids-metrics-<pid>"
+std::string getSegmentName(std::int32_t pid);
+
+// Names of all pages on this machine (newest process first); only
+// implemented where segments show up under /dev/shm
+std::vector<std::string> findSegments();
+
+}
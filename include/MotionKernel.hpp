@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+// Batch kernels for the per-tick motion every entity pays: integrate
+// position and wrap it into the world, spin and wrap angles. They work on
+// plain float arrays (one per field), several elements per instruction where
+// the target has SIMD, so callers gather the fields of a whole entity list,
+// run the kernels once, and scatter back.
+//
+// Wrapping keeps the overshoot: an entity leaving the right edge by 3 units
+// comes back 3 units in from the left, whatever its speed. The vector and
+// scalar paths do the same IEEE operations in the same order, so they give
+// bit-identical results; verify() checks that.
+namespace MotionKernel {
+
+// position += velocity * deltaTime, then wrap into [0, width) x [0, height)
+void integrate(float* x, float* y, const float* velocityX, const float* velocityY,
+               std::size_t count, float deltaTime, float width, float height);
+
+// angle += speed * deltaTime, wrapped into [0, 360) degrees
+void advanceAngles(float* angles, const float* speeds, std::size_t count, float deltaTime);
+
+// Wrap one value into [0, size), matching the batch kernels exactly
+float wrap(float value, float size);
+
+// The same kernels one element at a time, the reference for the vector path
+namespace scalar {
+void integrate(float* x, float* y, const float* velocityX, const float* velocityY,
+               std::size_t count, float deltaTime, float width, float height);
+void advanceAngles(float* angles, const float* speeds, std::size_t count, float deltaTime);
+}
+
+// True if the batch kernels use SIMD on this build
+bool isVectorized();
+
+// Elements processed per instruction by the batch kernels
+std::size_t getWidth();
+
+// Run random and edge-case inputs through both paths and count the results
+// that differ in any bit (0 = identical)
+std::size_t verify(unsigned int seed, std::size_t count);
+
+}
@@ -1,17 +1,49 @@
 #pragma once
 
 #include "Entity.hpp"
+#include <cstdint>
+#include <random>
 
 class Particle : public Entity {
 public:
-    Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color);
+    // lifetimeScale stretches or shortens the random lifetime (effects quality)
+    Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, std::mt19937& rng,
+             float lifetimeScale = 1.0f);
     
-    void update(float deltaTime) override;
-    void render(sf::RenderWindow& window) override;
+    // Colour at a point on the lifetime clock (in ticks, fractions allowed),
+    // faded by the time left until the expiry tick
+    sf::Color getColor(float tick) const;
+    
+    // Seconds the particle lives, drawn when it's created
+    float getLifetime() const;
+    
+    // Lifetime tick the particle disappears on, set when it's scheduled to expire
+    std::uint32_t getExpiryTick() const;
+    void setExpiryTick(std::uint32_t tick);
+    
+    // Lifetime, colour and motion, for keyframes of the simulation
+    void save(StateWriter& out) const;
+    static Particle load(StateReader& in);
 
 private:
+    Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, float lifetime);
+    
     float m_lifetime;
-    float m_maxLifetime;
+    std::uint32_t m_expiryTick;
     sf::Color m_color;
-    sf::RectangleShape m_shape;
 };
+
+inline float Particle::getLifetime() const
+{
+    return m_lifetime;
+}
+
+inline std::uint32_t Particle::getExpiryTick() const
+{
+    return m_expiryTick;
+}
+
+inline void Particle::setExpiryTick(std::uint32_t tick)
+{
+    m_expiryTick = tick;
+}
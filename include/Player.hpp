@@ -2,22 +2,29 @@
 
 #include "Entity.hpp"
 #include <vector>
-#include <SFML/Audio.hpp>
+
+// Control state for one update, sampled from the keyboard or supplied by a bot
+struct PlayerInput {
+    bool thrust = false;
+    bool rotateLeft = false;
+    bool rotateRight = false;
+    bool fire = false;       // Fire was pressed since the previous update
+};
 
 class Player : public Entity {
 public:
     Player();
     
-    void update(float deltaTime) override;
-    void render(sf::RenderWindow& window) override;
+    // Move, slow down and count the fire cooldown down
+    void update(float deltaTime, const sf::Vector2f& worldSize);
+    
+    // Handle input for player movement
+    void handleInput(const PlayerInput& input, float deltaTime);
     
-    // Handle input for player movement and actions
-    void handleInput(float deltaTime);
-
     void setLives(int lives);
     
-    // Reset the player when starting a new game or after death
-    void reset();
+    // Reset the player to the spawn position when starting a new game or after death
+    void reset(const sf::Vector2f& spawnPosition);
     
     // Apply thrust to the player ship
     void thrust(float deltaTime);
@@ -45,19 +52,27 @@ public:
     
     // Check if player is currently invulnerable
     bool isInvulnerable() const;
+    
+    // The invulnerability window is timed by the simulation's timeline,
+    // which blinks the ship and ends it
+    void setBlinkVisible(bool visible);
+    void endInvulnerability();
+    
+    // Check if the player is currently thrusting
+    bool isThrusting() const;
+    
+    // Check if the ship is drawn this frame (it blinks while invulnerable)
+    bool isVisible() const;
+    
+    // Motion, lives, cooldown and invulnerability, for keyframes of the simulation
+    void save(StateWriter& out) const;
+    void load(StateReader& in);
 
 private:
-    // Create the ship shape
-    void createShipShape();
-    
-    sf::ConvexShape m_shipShape;
-    sf::Sound m_thrustSound;
-    bool m_thrustSoundPlaying = false;
     float m_fireCooldown;
     int m_lives;
     bool m_invulnerable;
-    float m_invulnerabilityTimer;
-    float m_blinkTimer;  // For blinking effect when invulnerable
+    bool m_blinkVisible; // Shown at this point of the blink while invulnerable
     bool m_thrusting;    // Is the player currently thrusting
 
 };
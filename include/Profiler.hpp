@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Timeline profiling. PROFILE_ZONE marks the rest of a scope as a named zone;
+// while recording is on, each zone that ends is appended to a ring buffer
+// owned by the thread it ran on, so threads never contend and the last
+// minute or so of every thread is kept. While recording is off a zone is a
+// relaxed load and a branch.
+//
+// writeTrace() saves the buffered zones as Chrome trace-event JSON, which
+// chrome://tracing and ui.perfetto.dev open as one timeline per thread.
+//
+// Spike capture records continuously and, whenever a frame reported through
+// endFrame() runs over budget, saves the seconds before and after it once
+// the after-window has passed.
+namespace Profiler {
+
+// Nanoseconds on the profiler clock (steady, zero at the first use)
+std::uint64_t now();
+
+inline std::atomic<bool>& enabledFlag()
+{
+    static std::atomic<bool> enabled{false};
+    return enabled;
+}
+
+inline bool isRecording()
+{
+    return enabledFlag().load(std::memory_order_relaxed);
+}
+
+// Start or stop recording zones; stopping keeps what was buffered
+void setRecording(bool recording);
+
+// Name the calling thread in saved traces ("main", "simulation", ...)
+void setThreadName(const char* name);
+
+// Append a finished zone to the calling thread's buffer. name must outlive
+// the profiler (a string literal)
+void record(const char* name, std::uint64_t start, std::uint64_t end);
+
+// Save the buffered zones that overlap [from, to] on the profiler clock.
+// Returns the number of zones written, or -1 if the file couldn't be written
+long writeTrace(const std::string& path, std::uint64_t from = 0, std::uint64_t to = UINT64_MAX);
+
+// Spike capture: frames whose work takes longer than budgetMs are saved with
+// the given seconds of context as <prefix>-<n>.json. Turning it on turns
+// recording on.
+void setSpikeCapture(bool enabled, float budgetMs = 0.0f, float beforeSeconds = 2.0f,
+                     float afterSeconds = 1.0f, const std::string& prefix = "spike");
+bool isSpikeCaptureEnabled();
+
+// Report the work time of a frame that just ended (one thread only).
+// Returns the path of a spike trace if one was saved during this call
+std::string endFrame(float workMs);
+
+}
+
+// Times the rest of the enclosing scope while recording is on
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name)
+        : m_name(Profiler::isRecording() ? name : nullptr)
+        , m_start(m_name ? Profiler::now() : 0)
+    {
+    }
+    
+    ~ProfileZone()
+    {
+        if (m_name) {
+            Profiler::record(m_name, m_start, Profiler::now());
+        }
+    }
+    
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_start;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
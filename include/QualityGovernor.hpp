@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include "EffectsQuality.hpp"
+#include "LoadBand.hpp"
+
+// Trades cosmetic detail for frame rate. A LoadBand watches the work time of
+// every frame; when the load stays high the effects quality level drops by a
+// fraction, and when it stays low the level rises by a small step. Each step
+// up waits out the cooldown and a second under the band, about 70 frames at
+// 60 Hz, so a single drop from full quality takes about 5 seconds to win
+// back, and climbing from the floor takes about 17.5 seconds.
+class QualityGovernor {
+public:
+    explicit QualityGovernor(float budgetMs);
+    
+    // Frame time budget in milliseconds
+    void setBudget(float budgetMs);
+    float getBudget() const;
+    
+    // Account for one frame that spent workMs working. With canRaise false
+    // the level doesn't rise, while another controller climbs back first
+    void recordFrame(float workMs, bool canRaise);
+    
+    // Back to full quality with no history
+    void reset();
+    
+    // Telemetry
+    float getLevel() const;
+    float getLoad() const;                  // Smoothed work time / budget
+    EffectsQuality getQuality() const;
+    std::uint32_t getDowngradeCount() const;
+    std::uint32_t getUpgradeCount() const;
+
+private:
+    LoadBand m_band;
+    float m_level;
+};
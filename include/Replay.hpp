@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "FrameSnapshot.hpp"
+
+// Replay files: one FrameSnapshot per simulation tick, so any moment of a
+// session can be looked at again.
+//
+// Every tick is flattened into 32-bit words. Each keyframeInterval ticks the
+// words are stored whole (a keyframe); the ticks in between store their XOR
+// against the previous tick. Either way the words are split into byte planes
+// and runs of zero bytes are collapsed, so values that barely change between
+// ticks (the high bytes of positions, asteroid outlines) cost almost nothing.
+//
+// Layout: file header, one record per tick (record header + payload), then
+// an index of keyframe offsets and a footer pointing at it. Seeking to a tick
+// looks up its keyframe in the index and decodes at most keyframeInterval
+// records. A file without an index (a recording still in progress, or one
+// that was cut short) is indexed by walking the records instead.
+//
+// Words are stored in the byte order of the machine that recorded them.
+constexpr std::uint32_t REPLAY_MAGIC = 0x50525341u;        // "ASRP"
+constexpr std::uint32_t REPLAY_INDEX_MAGIC = 0x49525341u;  // "ASRI"
+constexpr std::uint32_t REPLAY_VERSION = 1;
+
+// Streams ticks to disk as they happen. Memory use doesn't grow with the
+// length of the recording, apart from one offset per keyframe.
+class ReplayWriter {
+public:
+    ReplayWriter();
+    ~ReplayWriter();
+    
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    
+    // Start a new file, replacing any existing one
+    bool open(const std::string& path, std::uint32_t keyframeInterval = 120);
+    
+    // Append the next tick; tickTimeMs is how long the simulation took for it
+    void write(const FrameSnapshot& snapshot, float tickTimeMs);
+    
+    // Write the index and close the file; false if anything failed to write
+    bool close();
+    
+    bool isOpen() const;
+    const std::string& getPath() const;
+    std::uint64_t getTickCount() const;
+    std::uint64_t getBytesWritten() const;
+
+private:
+    std::FILE* m_file;
+    std::string m_path;
+    std::uint32_t m_keyframeInterval;
+    std::uint64_t m_tickCount;
+    std::uint64_t m_offset;
+    bool m_failed;
+    
+    std::vector<std::uint64_t> m_keyframes;  // File offset of every keyframe record
+    std::vector<std::uint32_t> m_previous;   // Words of the last tick written
+    std::vector<std::uint32_t> m_current;
+    std::vector<std::uint8_t> m_payload;
+};
+
+// Maps a replay file and decodes any tick of it
+class ReplayReader {
+public:
+    ReplayReader();
+    ~ReplayReader();
+    
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+    
+    // Map a file; false if it can't be read or isn't a replay
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const;
+    std::uint64_t getTickCount() const;
+    std::uint32_t getKeyframeInterval() const;
+    std::size_t getFileSize() const;
+    
+    // True if the file ended without an index and its records were walked
+    bool wasRecovered() const;
+    
+    // Decode a tick into snapshot. Stepping forward from the last tick read
+    // applies the deltas in between; anything else starts from the tick's
+    // keyframe. False if the tick is out of range or its data is corrupt
+    bool read(std::uint64_t tick, FrameSnapshot& snapshot);
+    
+    // Simulation time of a tick in milliseconds, as recorded
+    float getTickTime(std::uint64_t tick) const;
+    
+    // First tick at or after from that took longer than thresholdMs,
+    // or getTickCount() if there is none
+    std::uint64_t findSlowTick(std::uint64_t from, float thresholdMs) const;
+
+private:
+    // Offset of a tick's record, walking forward from its keyframe
+    std::uint64_t findRecord(std::uint64_t tick) const;
+    
+    // Decode the record at offset on top of m_words; returns the next offset or 0
+    std::uint64_t applyRecord(std::uint64_t offset);
+    
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    bool m_mapped;                    // m_data is a mapping rather than m_fallback
+    std::vector<std::uint8_t> m_fallback;
+    
+    std::uint32_t m_keyframeInterval;
+    std::uint64_t m_tickCount;
+    std::vector<std::uint64_t> m_keyframes;
+    bool m_recovered;
+    
+    // Decoder position: m_words holds tick m_currentTick, whose successor starts at m_nextOffset
+    std::vector<std::uint32_t> m_words;
+    std::uint64_t m_currentTick;
+    std::uint64_t m_nextOffset;
+};
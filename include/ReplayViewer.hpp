@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include "FrameArena.hpp"
+#include "FrameSnapshot.hpp"
+#include "FramePacer.hpp"
+#include "Replay.hpp"
+#include "UI.hpp"
+#include "WorldRenderer.hpp"
+
+// Plays a replay file back in a window. The file is mapped, not loaded, and
+// every frame decodes the tick under the playhead, so jumping anywhere in a
+// long recording or scrubbing at 64x costs at most one keyframe interval of
+// decoding per frame.
+class ReplayViewer {
+public:
+    // Throws std::runtime_error if the file isn't a readable replay
+    explicit ReplayViewer(const std::string& path);
+    
+    // Run until the window is closed
+    void run();
+
+private:
+    // Playback controls; deltaTime is the real time since the last frame
+    void handleInput(float deltaTime);
+    
+    // Draw the tick under the playhead with the HUD and position bar
+    void render();
+    
+    // Move the playhead, clamped to the recording
+    void seek(double tick);
+    
+    sf::RenderWindow m_window;
+    FramePacer m_framePacer;
+    FrameArena m_frameArena;
+    WorldRenderer m_worldRenderer;
+    UI m_ui;
+    
+    ReplayReader m_reader;
+    FrameSnapshot m_snapshot;
+    double m_position;             // Playhead in ticks; fractional while playing slower than 1x
+    int m_speedStep;               // Index into the speed table
+    bool m_paused;
+    std::uint32_t m_previousKeys;
+};
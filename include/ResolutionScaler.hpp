@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include "LoadBand.hpp"
+
+// Trades the world's render resolution for frame rate. A LoadBand watches
+// the main thread's work time every frame, and the render scale moves
+// within [min, max] to keep the load in its band: down by a fraction when
+// it stays high, up a step when it stays low.
+//
+// Where effects quality cuts how much is drawn, this cuts how many pixels
+// each of it costs, which is what runs out on fill-rate bound machines. The
+// scale moves in steps of 1/SCALE_STEPS so the render target's size doesn't
+// change on every adjustment.
+class ResolutionScaler {
+public:
+    static constexpr int SCALE_STEPS = 32;
+    
+    ResolutionScaler(float budgetMs, float minScale, float maxScale);
+    
+    // Frame time budget in milliseconds
+    void setBudget(float budgetMs);
+    
+    // Scale bounds, clamped to (0, 1]; the current scale is kept within them
+    void setBounds(float minScale, float maxScale);
+    float getMinScale() const;
+    float getMaxScale() const;
+    
+    // Account for one frame that spent workMs working. With canLower false
+    // the scale doesn't drop, while cheaper savings are left elsewhere
+    void recordFrame(float workMs, bool canLower);
+    
+    // Back to the maximum scale with no history
+    void reset();
+    
+    // Telemetry
+    float getScale() const;
+    float getLoad() const;                  // Smoothed work time / budget
+    std::uint32_t getDowngradeCount() const;
+    std::uint32_t getUpgradeCount() const;
+
+private:
+    // Round to a whole step, within the bounds
+    float snap(float scale) const;
+    
+    LoadBand m_band;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+};
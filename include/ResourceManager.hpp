@@ -6,6 +6,9 @@
 #include <string>
 #include <memory>
 
+// Loads fonts and sounds on first use and keeps them for the life of the
+// process. Fonts are only asked for on the main thread and sounds only on the
+// audio thread, which is why the two maps need no lock.
 class ResourceManager {
 public:
     static ResourceManager& getInstance();
@@ -17,12 +20,12 @@ public:
     // Font handling
     sf::Font& getFont(const std::string& filename);
     
+    // Where getFont looks for a font
+    static std::string getFontPath(const std::string& filename);
+    
     // Sound handling
     sf::SoundBuffer& getSoundBuffer(const std::string& filename);
-    
-    // Initialize resources
-    void loadResources();
-    
+
 private:
     ResourceManager() = default;
     
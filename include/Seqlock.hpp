@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// A value with one writer and any number of readers that never block the
+// writer. The writer makes the sequence odd, copies the value in and makes
+// it even again; a reader copies the value out and keeps the copy only if
+// the sequence was even and unchanged around it.
+//
+// Standard layout with a lock-free sequence, so it can live in memory shared
+// between processes: readers in another process see the same protocol.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock values are copied as bytes");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "sequence must be address-free");
+
+public:
+    // Writer only
+    void write(const T& value)
+    {
+        std::uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        
+        std::memcpy(&m_value, &value, sizeof(T));
+        
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+    
+    // One attempt at a consistent copy, false if a write was in progress
+    bool tryRead(T& value) const
+    {
+        std::uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            return false;
+        }
+        
+        std::memcpy(&value, &m_value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        
+        return m_sequence.load(std::memory_order_relaxed) == before;
+    }
+    
+    // Retry until a consistent copy is read; writes are short, so this is brief
+    T read() const
+    {
+        T value;
+        while (!tryRead(value)) {
+        }
+        return value;
+    }
+    
+    // Number of completed writes
+    std::uint32_t getVersion() const
+    {
+        return m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    std::atomic<std::uint32_t> m_sequence{0};
+    T m_value{};
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <random>
+#include "Player.hpp"
+#include "Asteroid.hpp"
+#include "Bullet.hpp"
+#include "Collision.hpp"
+#include "Particle.hpp"
+#include "EffectsQuality.hpp"
+#include "EntityCommandBuffer.hpp"
+#include "FrameArena.hpp"
+#include "FrameSnapshot.hpp"
+#include "GameEventQueue.hpp"
+#include "SleepingSectors.hpp"
+#include "SpatialIndex.hpp"
+#include "SlotMap.hpp"
+#include "StateArchive.hpp"
+#include "Timeline.hpp"
+#include "TimingWheel.hpp"
+#include "Constants.hpp"
+
+// Per-instance settings for a simulation
+struct SimulationConfig {
+    // Size of the toroidal world the entities wrap around in. Worlds several
+    // screens across are filled in proportion and put their far sectors to sleep
+    sf::Vector2f worldSize = sf::Vector2f(static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT));
+    
+    // Seed for the instance's random number generator
+    unsigned int seed = 5489u;
+};
+
+// Game state and rules without a window. Each instance owns all of its
+// mutable state, so many of them can run side by side on different threads.
+class Simulation {
+public:
+    explicit Simulation(const SimulationConfig& config = SimulationConfig());
+    
+    // Start a new game from level 1 and switch to the playing state
+    void startGame();
+    
+    // Switch between the playing and paused states
+    void togglePause();
+    
+    // Detail of cosmetic effects spawned from now on (never affects gameplay)
+    void setEffectsQuality(const EffectsQuality& quality);
+    const EffectsQuality& getEffectsQuality() const;
+    
+    // Advance the game by one step
+    void update(const PlayerInput& input, float deltaTime);
+    
+    // Accessors
+    GameState getState() const;
+    int getScore() const;
+    int getLevel() const;
+    const sf::Vector2f& getWorldSize() const;
+    unsigned int getSeed() const;
+    const Player& getPlayer() const;
+    Player& getPlayer();
+    const SlotMap<Asteroid>& getAsteroids() const;
+    SlotMap<Asteroid>& getAsteroids();
+    const SlotMap<Bullet>& getBullets() const;
+    SlotMap<Bullet>& getBullets();
+    const SlotMap<Particle>& getParticles() const;
+    SlotMap<Particle>& getParticles();
+    
+    // Asteroids far from the player, not in getAsteroids() until they wake
+    std::size_t getSleepingAsteroidCount() const;
+    
+    // Awake asteroids by position, in step with getAsteroids() between updates
+    const SpatialIndex& getAsteroidIndex() const;
+    
+    // Events from the last update, valid until the next one
+    const GameEventQueue& getEvents() const;
+    
+    // Collision work done by the last update
+    const CollisionStats& getCollisionStats() const;
+    
+    // Copy the drawable state into a snapshot, reusing its storage
+    void capture(FrameSnapshot& snapshot) const;
+    
+    // Everything that decides how the game plays on, for flight recorder
+    // keyframes. Writes into the writer's buffer without allocating. Effects
+    // quality is left out, as it is set before every update
+    void saveState(StateWriter& out) const;
+    
+    // Undo saveState() on a simulation created with the same world size.
+    // False if the state is damaged, which leaves this simulation unusable
+    bool loadState(StateReader& in);
+
+private:
+    // Initialize a new level
+    void initLevel();
+    
+    // Timeline tasks: levels one after another, each started with an intro
+    // and ended by its last asteroid, and the blinking invulnerability
+    // window after every respawn, which only counts down while the world
+    // moves. With resume set they carry on from the level or window the
+    // members below describe, for loadState()
+    TimelineTask runLevels(Timeline& timeline, bool resume);
+    TimelineTask runInvulnerability(Timeline& timeline, bool resume);
+    
+    // Spawn the timeline tasks of a new game
+    void startTimeline();
+    
+    // Move everything, resolve collisions and spawn effects (past the level start delay)
+    void step(const PlayerInput& input, float deltaTime);
+    
+    // Record a new bullet, returns false while the fire cooldown is running
+    bool createBullet();
+    
+    // Spawn the cosmetic particles for this tick's events and the ship's exhaust
+    void spawnEffects(float deltaTime);
+    
+    // Burst of particles flying out from a point
+    void createExplosion(sf::Vector2f position, sf::Color color);
+    
+    // Apply the spawns and despawns recorded this tick
+    void applyCommands();
+    
+    // Reset the game
+    void resetGame();
+    
+    // Whole ticks on the lifetime and timeline clocks
+    std::uint32_t getLifetimeTick() const;
+    std::uint32_t getTimelineTick() const;
+    
+    // Centre of the world, where the player spawns
+    sf::Vector2f getSpawnPosition() const;
+    
+    SimulationConfig m_config;
+    std::mt19937 m_rng;
+    
+    // Effects draw from their own generator, so their quality can change
+    // without changing how the game plays out
+    std::mt19937 m_effectsRng;
+    EffectsQuality m_effectsQuality;
+    float m_exhaustTimer;
+    
+    GameEventQueue m_events;
+    CollisionStats m_collisionStats;
+    
+    // Scratch memory for a single update, rewound at the start of each one
+    FrameArena m_scratch;
+    
+    // Game state
+    GameState m_gameState;
+    int m_score;
+    int m_level;
+    bool m_levelRunning;    // Past the level intro and not yet cleared
+    
+    // Entities; anything that goes inactive is despawned at the end of the same tick
+    Player m_player;
+    SlotMap<Asteroid> m_asteroids;
+    SlotMap<Bullet> m_bullets;
+    SlotMap<Particle> m_particles;
+    
+    // Seconds the game has stepped, which bullet and particle lifetimes run
+    // on, and the wheels their expiry ticks are scheduled in
+    double m_lifetimeClock;
+    TimingWheel m_bulletExpiry;
+    TimingWheel m_particleExpiry;
+    
+    // Timed game logic, run as coroutines on whole ticks of a clock that
+    // runs whenever the game is played, intro included
+    double m_timelineClock;
+    Timeline m_timeline;
+    Timeline::EventId m_levelCleared;
+    
+    // Timed logic that stands still with the world through level intros,
+    // on whole ticks of the lifetime clock
+    Timeline m_stepTimeline;
+    Timeline::EventId m_playerShielded;
+    
+    // Where the timeline tasks are, as coroutines themselves can't be
+    // saved: the timeline tick the level intro ends on, and the step tick
+    // the running invulnerability window started on
+    std::uint32_t m_introEndTick;
+    bool m_shieldRunning;
+    std::uint32_t m_shieldStartTick;
+    
+    // Asteroids in the far sectors of a large world, moved between here and
+    // m_asteroids after the commands are applied
+    SleepingSectors m_sleepingSectors;
+    
+    // Synced after the asteroids move and again once the map has changed
+    // shape, so collisions and callers between updates both see it current
+    SpatialIndex m_asteroidIndex;
+    SpatialQueryBatch m_collisionQueries;
+    
+    // Spawns and despawns of the current tick; the maps above only change
+    // shape when it's applied, at the end of update()
+    EntityCommandBuffer m_commands;
+};
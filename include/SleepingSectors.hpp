@@ -0,0 +1,117 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Asteroid.hpp"
+#include "Constants.hpp"
+#include "SlotMap.hpp"
+#include "StateArchive.hpp"
+
+// Asteroids of a large world that are too far from the player to matter.
+// The world is cut into sectors about a screen wide; asteroids in the
+// sectors around the player are awake and live in the simulation's map as
+// usual, the rest are asleep here. A sleeping asteroid is a few plain values
+// and moves analytically: where it is now follows from where and when it
+// fell asleep, so sleepers cost nothing per tick, never collide and spawn no
+// particles. Each tick looks at the sectors at the edge of the awake zone,
+// plus a fixed fraction of all the others (about 1/200 at 60 Hz) to keep
+// every sleeper filed under the sector it is in. That re-filing still grows
+// with the number of sleepers, but at a small fraction of stepping them all.
+//
+// Worlds that are only a few sectors across have no far sectors, and then
+// nothing ever sleeps.
+class SleepingSectors {
+public:
+    // Sector edge in pixels, before rounding so whole sectors tile the world
+    static constexpr float SECTOR_SIZE = 1024.0f;
+    
+    // Sectors this many (or fewer) from the player's are awake. Asteroids
+    // wake on entering that zone and fall asleep one sector further out,
+    // so one drifting along the edge doesn't flip every tick
+    static constexpr int ACTIVE_RADIUS = 2;
+    
+    SleepingSectors();
+    
+    // Lay the sectors out over a world; drops every sleeper
+    void configure(const sf::Vector2f& worldSize);
+    
+    // False when the world is too small to have far sectors
+    bool isEnabled() const;
+    
+    // Drop every sleeper
+    void clear();
+    
+    // True if an asteroid at this position should be asleep
+    bool isFar(const sf::Vector2f& position, const sf::Vector2f& playerPosition) const;
+    
+    // Put an asteroid to sleep; it is no longer simulated until woken
+    void sleep(const Asteroid& asteroid);
+    
+    // Advance the sleepers' clock by one tick, wake the ones that moved into
+    // the awake zone (or that it moved onto) and put awake asteroids that
+    // left it to sleep. Must not run while the map is being walked
+    void update(SlotMap<Asteroid>& asteroids, const sf::Vector2f& playerPosition, float deltaTime);
+    
+    // Number of sleeping asteroids
+    std::size_t size() const;
+    bool empty() const;
+    
+    // Every sleeper, the clock and the re-filing round robin, for keyframes
+    // of the simulation. load() expects the same world as the save and
+    // returns false if the state is damaged
+    void save(StateWriter& out) const;
+    bool load(StateReader& in);
+
+private:
+    struct Sleeper {
+        sf::Vector2f position;      // Where it was at m_time == since
+        sf::Vector2f velocity;
+        float rotation;
+        float rotationSpeed;
+        double since;
+        AsteroidSize size;
+        std::uint8_t vertexCount;
+        std::array<sf::Vector2f, ASTEROID_VERTICES_MAX> vertices;
+    };
+    
+    // Sector coordinates
+    struct Cell {
+        int x, y;
+    };
+    
+    Cell getCell(const sf::Vector2f& position) const;
+    std::size_t getIndex(Cell cell) const;
+    
+    // Sectors between two cells along each axis, across the wrap
+    int getDistance(Cell a, Cell b) const;
+    
+    // Bring a sleeper's position and rotation up to m_time
+    void catchUp(Sleeper& sleeper) const;
+    
+    // Wake the sleepers of one sector that are now within the awake zone
+    void wakeSector(std::size_t index, Cell playerCell, SlotMap<Asteroid>& asteroids);
+    
+    // File a slice of the sectors' sleepers under the sectors they drifted into
+    void rebucket(float deltaTime);
+    
+    sf::Vector2f m_worldSize;
+    sf::Vector2f m_sectorSize;
+    int m_columns;
+    int m_rows;
+    bool m_enabled;
+    
+    // Sleepers filed by the sector they were in when last caught up; they
+    // can have drifted less than one sector since
+    std::vector<std::vector<Sleeper>> m_sectors;
+    std::size_t m_count;
+    
+    double m_time;                  // Seconds of simulated play
+    std::size_t m_rebucketCursor;   // Next sector to re-file
+    float m_rebucketBudget;         // Sectors owed to the round robin
+    
+    // Awake asteroids leaving the zone this tick, reused between ticks
+    std::vector<SlotHandle> m_leaving;
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "StateArchive.hpp"
+
+// Reference to an element of a SlotMap. It stays valid while the element is
+// alive; once the element is removed the slot's generation moves on and the
+// handle reads as stale, even after the slot is reused.
+struct SlotHandle {
+    static constexpr std::uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+    
+    std::uint32_t index = INVALID_INDEX;
+    std::uint32_t generation = 0;
+    
+    bool operator==(const SlotHandle& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    
+    bool operator!=(const SlotHandle& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Values stored contiguously with O(1) insert and O(1) swap-remove.
+//
+// Iteration walks the packed values, whose order changes when elements are
+// removed. References and iterators are invalidated by insert and erase, so
+// anything kept across those must be a SlotHandle. The simulation never
+// inserts or erases while a map is being walked: it records spawns and
+// despawns in an EntityCommandBuffer and applies them after.
+template <typename T>
+class SlotMap {
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+    
+    void reserve(std::size_t capacity)
+    {
+        m_values.reserve(capacity);
+        m_valueSlots.reserve(capacity);
+        m_slots.reserve(capacity);
+    }
+    
+    // Construct a new element in place and return its handle
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args)
+    {
+        std::uint32_t slotIndex;
+        if (m_freeHead != SlotHandle::INVALID_INDEX) {
+            slotIndex = m_freeHead;
+            m_freeHead = m_slots[slotIndex].dense;
+        } else {
+            slotIndex = static_cast<std::uint32_t>(m_slots.size());
+            m_slots.push_back({0, 0});
+        }
+        
+        m_values.emplace_back(std::forward<Args>(args)...);
+        m_valueSlots.push_back(slotIndex);
+        m_slots[slotIndex].dense = static_cast<std::uint32_t>(m_values.size() - 1);
+        return {slotIndex, m_slots[slotIndex].generation};
+    }
+    
+    SlotHandle insert(T value)
+    {
+        return emplace(std::move(value));
+    }
+    
+    // Remove an element now by moving the last one into its place.
+    // Returns false if the handle was already stale.
+    bool erase(SlotHandle handle)
+    {
+        if (!contains(handle)) {
+            return false;
+        }
+        
+        std::uint32_t dense = m_slots[handle.index].dense;
+        std::uint32_t last = static_cast<std::uint32_t>(m_values.size() - 1);
+        if (dense != last) {
+            m_values[dense] = std::move(m_values[last]);
+            m_valueSlots[dense] = m_valueSlots[last];
+            m_slots[m_valueSlots[dense]].dense = dense;
+        }
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+        
+        releaseSlot(handle.index);
+        return true;
+    }
+    
+    // Remove every element; all existing handles become stale
+    void clear()
+    {
+        for (std::uint32_t slotIndex : m_valueSlots) {
+            releaseSlot(slotIndex);
+        }
+        m_values.clear();
+        m_valueSlots.clear();
+    }
+    
+    bool contains(SlotHandle handle) const
+    {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+    }
+    
+    // The element behind a handle, null if the handle is stale
+    T* get(SlotHandle handle)
+    {
+        return contains(handle) ? &m_values[m_slots[handle.index].dense] : nullptr;
+    }
+    
+    const T* get(SlotHandle handle) const
+    {
+        return contains(handle) ? &m_values[m_slots[handle.index].dense] : nullptr;
+    }
+    
+    // Handle of the element at a position in iteration order
+    SlotHandle handleAt(std::size_t position) const
+    {
+        std::uint32_t slotIndex = m_valueSlots[position];
+        return {slotIndex, m_slots[slotIndex].generation};
+    }
+    
+    // Element at a position in iteration order
+    T& operator[](std::size_t position) { return m_values[position]; }
+    const T& operator[](std::size_t position) const { return m_values[position]; }
+    
+    std::size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+    
+    iterator begin() { return m_values.begin(); }
+    iterator end() { return m_values.end(); }
+    const_iterator begin() const { return m_values.begin(); }
+    const_iterator end() const { return m_values.end(); }
+    
+    // Every value with T::save(), and the slots, so handles saved elsewhere
+    // (timing wheels, spatial indexes) stay valid and slots are reused in
+    // the same order after a load
+    void save(StateWriter& out) const
+    {
+        out.write(static_cast<std::uint64_t>(m_values.size()));
+        for (const T& value : m_values) {
+            value.save(out);
+        }
+        out.writeVector(m_valueSlots);
+        out.writeVector(m_slots);
+        out.write(m_freeHead);
+    }
+    
+    // Undo save(), building each value with T::load(). False if the state is damaged
+    bool load(StateReader& in)
+    {
+        std::uint64_t count = 0;
+        if (!in.read(count) || count > in.getRemaining()) {
+            in.fail();
+            return false;
+        }
+        
+        m_values.clear();
+        for (std::uint64_t i = 0; i < count && in.isValid(); ++i) {
+            m_values.push_back(T::load(in));
+        }
+        in.readVector(m_valueSlots);
+        in.readVector(m_slots);
+        in.read(m_freeHead);
+        
+        // Every value needs a live slot that points back at it
+        bool consistent = in.isValid() && m_valueSlots.size() == m_values.size();
+        for (std::size_t i = 0; consistent && i < m_valueSlots.size(); ++i) {
+            consistent = m_valueSlots[i] < m_slots.size() && m_slots[m_valueSlots[i]].dense == i;
+        }
+        
+        // Every other slot is on the free list exactly once. The walk stops
+        // after that many, so a chain that loops or leaves the slots fails
+        // instead of running on
+        std::size_t freeSlots = consistent ? m_slots.size() - m_values.size() : 0;
+        std::size_t walked = 0;
+        for (std::uint32_t next = m_freeHead; consistent && next != SlotHandle::INVALID_INDEX; ++walked) {
+            consistent = walked < freeSlots && next < m_slots.size() && !isLive(next);
+            next = consistent ? m_slots[next].dense : SlotHandle::INVALID_INDEX;
+        }
+        consistent = consistent && walked == freeSlots;
+        if (!consistent) {
+            in.fail();
+            m_values.clear();
+            m_valueSlots.clear();
+            m_slots.clear();
+            m_freeHead = SlotHandle::INVALID_INDEX;
+        }
+        return consistent;
+    }
+
+private:
+    // A live slot stores the position of its value; a free slot stores the next free slot
+    struct Slot {
+        std::uint32_t dense;
+        std::uint32_t generation;
+    };
+    
+    // True if a slot holds a value, rather than being on the free list
+    bool isLive(std::uint32_t slotIndex) const
+    {
+        std::uint32_t dense = m_slots[slotIndex].dense;
+        return dense < m_valueSlots.size() && m_valueSlots[dense] == slotIndex;
+    }
+    
+    // Make a slot's handles stale and put it on the free list
+    void releaseSlot(std::uint32_t slotIndex)
+    {
+        Slot& slot = m_slots[slotIndex];
+        slot.generation++;
+        slot.dense = m_freeHead;
+        m_freeHead = slotIndex;
+    }
+    
+    std::vector<T> m_values;
+    std::vector<std::uint32_t> m_valueSlots;  // Slot of each value, parallel to m_values
+    std::vector<Slot> m_slots;
+    std::uint32_t m_freeHead = SlotHandle::INVALID_INDEX;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrameSnapshot.hpp"
+
+// The word layout that replay records and spectator frames share. A
+// FrameSnapshot flattens to FIXED_WORDS words of game state and list sizes,
+// then the asteroids, outline vertices, bullets and particles; both formats
+// then send the XOR of those words against the previous frame's, framed as
+// alternating varint runs of skipped and taken units (words or bytes).
+//
+// How a float becomes a word is up to the caller's Quantiser: replays keep
+// the exact bits, spectators round to fixed point so that a delta stays
+// small.
+namespace SnapshotCodec {
+
+// Words before the entity lists
+constexpr std::size_t FIXED_WORDS = 14;
+
+// Most words a frame may decode to, far more than any game produces. Zero
+// runs cost next to nothing in a payload, so its size alone is no bound
+constexpr std::uint32_t MAX_WORDS = 1u << 24;
+
+struct Quantiser {
+    std::uint32_t (*position)(float value);     // Positions and sizes
+    float (*unposition)(std::uint32_t word);
+    std::uint32_t (*angle)(float degrees);
+    float (*unangle)(std::uint32_t word);
+};
+
+// The float's bits unchanged, for both positions and angles
+extern const Quantiser EXACT;
+
+void flatten(const FrameSnapshot& snapshot, const Quantiser& quantiser, std::vector<std::uint32_t>& words);
+
+// False if words isn't a whole snapshot
+bool unflatten(const std::vector<std::uint32_t>& words, const Quantiser& quantiser, FrameSnapshot& snapshot);
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value);
+bool getVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value);
+
+// One run of the framing: skipped units, then taken units whose bytes follow
+inline void putRun(std::vector<std::uint8_t>& out, std::size_t skipped, std::size_t taken)
+{
+    putVarint(out, skipped);
+    putVarint(out, taken);
+}
+
+// Walk the runs of a payload covering total units. take(first, count, data,
+// end) reads the bytes of the count units from first on, advancing data, and
+// returns false if they are damaged. False if the payload is damaged or its
+// runs go past total
+template <typename Take>
+bool readRuns(const std::uint8_t* data, std::size_t size, std::size_t total, Take take)
+{
+    const std::uint8_t* end = data + size;
+    std::size_t unit = 0;
+    while (data < end) {
+        std::uint64_t skipped, taken;
+        if (!getVarint(data, end, skipped) || !getVarint(data, end, taken) ||
+            skipped > total - unit || taken > total - unit - skipped) {
+            return false;
+        }
+        
+        unit += static_cast<std::size_t>(skipped);
+        if (!take(unit, static_cast<std::size_t>(taken), data, end)) {
+            return false;
+        }
+        unit += static_cast<std::size_t>(taken);
+    }
+    return true;
+}
+
+}
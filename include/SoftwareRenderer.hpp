@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FrameSnapshot.hpp"
+
+// Pixel layouts supported by the software renderer
+enum class PixelFormat {
+    RGBA8,  // 4 bytes per pixel, R G B A in memory
+    Gray8   // 1 byte per pixel, luma
+};
+
+// Draws a FrameSnapshot into an in-memory pixel buffer without a window or
+// GPU. The world is scaled to fill the buffer and the HUD is laid out as on
+// a WINDOW_WIDTH x WINDOW_HEIGHT window, then scaled the same way. Output is
+// deterministic for a given snapshot, resolution and format.
+class SoftwareRenderer {
+public:
+    SoftwareRenderer(unsigned int width, unsigned int height, PixelFormat format = PixelFormat::RGBA8);
+    
+    // Change the resolution (reallocates the owned buffer)
+    void resize(unsigned int width, unsigned int height);
+    
+    // Draw into caller-owned memory of getBufferSize() bytes instead of the
+    // owned buffer; null switches back to the owned buffer
+    void bindTarget(std::uint8_t* pixels);
+    
+    // Draw a complete frame: background, world and HUD
+    void render(const FrameSnapshot& snapshot);
+    
+    // Primitives, in pixel coordinates
+    void clear(SnapshotColor color);
+    void drawLine(float x0, float y0, float x1, float y1, SnapshotColor color);
+    void fillRect(float x, float y, float width, float height, SnapshotColor color);
+    void fillCircle(float centerX, float centerY, float radius, SnapshotColor color);
+    void fillConvexPolygon(const float* points, std::size_t count, SnapshotColor color);
+    void drawPolygonOutline(const float* points, std::size_t count, SnapshotColor color);
+    
+    // Built-in 5x7 bitmap font; size is the line height in pixels, '\n' starts a new line
+    void drawText(float x, float y, const char* text, float size, SnapshotColor color);
+    float measureText(const char* text, float size) const;
+    
+    unsigned int getWidth() const;
+    unsigned int getHeight() const;
+    PixelFormat getFormat() const;
+    std::size_t getBytesPerPixel() const;
+    std::size_t getBufferSize() const;
+    const std::uint8_t* getPixels() const;
+    
+    // Write the buffer as binary PPM (RGBA, alpha dropped) or PGM (grey)
+    bool saveToFile(const std::string& path) const;
+
+private:
+    // Fill pixels [x0, x1] of row y, clipped; blends when color.a < 255
+    void fillSpan(int y, int x0, int x1, SnapshotColor color);
+    
+    void renderWorld(const FrameSnapshot& snapshot);
+    void renderHud(const FrameSnapshot& snapshot);
+    
+    // Draw text centred on a point in HUD (window) coordinates
+    void drawCenteredText(float x, float y, const char* text, float size, SnapshotColor color);
+    
+    unsigned int m_width;
+    unsigned int m_height;
+    PixelFormat m_format;
+    std::vector<std::uint8_t> m_buffer;
+    std::uint8_t* m_pixels;
+    
+    // World to pixel and HUD to pixel scale of the frame being drawn
+    float m_worldScaleX, m_worldScaleY;
+    float m_hudScaleX, m_hudScaleY;
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SlotMap.hpp"
+#include "StateArchive.hpp"
+
+// One entity found by a spatial query
+struct SpatialHit {
+    SlotHandle handle;
+    sf::Vector2f delta;     // From the query point to the entity's nearest copy
+    float distance;         // Centre to centre, or along the ray for ray casts
+};
+
+// Uniform grid over a toroidal world, answering "what is near here" for the
+// entities of one SlotMap. Each cell holds a linked list of the entities
+// whose centres are in it, threaded through one node per map slot, so the
+// index is kept up to date in place: a sync rewrites positions, relinks the
+// nodes that changed cell, were spawned or are gone, and only allocates when
+// the map itself has grown.
+//
+// Every query is wrap-aware: distances are measured to an entity's copy
+// nearest the query point, and rays carry on across the world's edges.
+// Queries don't modify the index, so any number of threads can run them at
+// once between syncs.
+class SpatialIndex {
+public:
+    // Cells are at least this wide, and there are at most MAX_CELLS of them
+    // along each side, so huge worlds get bigger cells instead of more
+    static constexpr float MIN_CELL_SIZE = 128.0f;
+    static constexpr int MAX_CELLS = 256;
+    
+    SpatialIndex();
+    
+    // Lay the grid out over a world; drops every entry
+    void configure(const sf::Vector2f& worldSize);
+    
+    // Drop every entry
+    void clear();
+    
+    // Bring the index in line with a map: file new entities, move the ones
+    // that changed cell and drop the ones no longer in it. Inactive entities
+    // are left out
+    template <typename T>
+    void sync(const SlotMap<T>& entities)
+    {
+        m_stamp++;
+        for (std::size_t i = 0; i < entities.size(); ++i) {
+            const T& entity = entities[i];
+            if (entity.isActive()) {
+                track(entities.handleAt(i), entity.getPosition(), entity.getRadius());
+            }
+        }
+        removeUnseen();
+    }
+    
+    // Append the entities whose circle overlaps the given one to hits,
+    // closest first. Returns the number of entries tested
+    std::size_t queryCircle(sf::Vector2f center, float radius, std::vector<SpatialHit>& hits) const;
+    
+    // Append the (up to) count entities with centres closest to a point to
+    // hits, closest first. Returns the number of entries tested
+    std::size_t queryNearest(sf::Vector2f center, std::size_t count, std::vector<SpatialHit>& hits) const;
+    
+    // First entity whose circle the ray enters within maxDistance, starting
+    // inside one counts at distance 0. direction needn't be normalised. The
+    // ray reaches no further than it takes to cross the world once along
+    // either axis, so any maxDistance (infinity included) is fine
+    bool raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance, SpatialHit& hit) const;
+    
+    std::size_t size() const;
+    
+    // Run circle, nearest and ray queries over random entities in a few
+    // random worlds and check them against a scan of every entity; returns
+    // the number of queries that disagree
+    static std::size_t verify(unsigned int seed, std::size_t count);
+    
+    // Every filed entity in its cell's list order, for keyframes of the
+    // simulation, so queries after a load see ties in the same order.
+    // load() expects the same world as the save and returns false if the
+    // state is damaged
+    void save(StateWriter& out) const;
+    bool load(StateReader& in);
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    
+    // One per map slot; linked into its cell's list while the slot's entity is filed
+    struct Node {
+        SlotHandle handle;
+        sf::Vector2f position;
+        float radius;
+        std::uint32_t cell;         // NONE while not filed
+        std::uint32_t previous;
+        std::uint32_t next;
+        std::uint32_t stamp;        // Last sync that saw it
+    };
+    
+    // File or refresh one entity
+    void track(SlotHandle handle, sf::Vector2f position, float radius);
+    
+    // Unlink the nodes the last sync didn't see
+    void removeUnseen();
+    
+    void link(std::uint32_t node, std::uint32_t cell);
+    void unlink(std::uint32_t node);
+    
+    // Cell coordinates of a point, not wrapped
+    int getColumn(float x) const;
+    int getRow(float y) const;
+    
+    // Index of a cell given coordinates that may lie outside the grid
+    std::size_t getCell(int column, int row) const;
+    
+    // Shortest vector from a to b across the wrap
+    sf::Vector2f getDelta(sf::Vector2f a, sf::Vector2f b) const;
+    
+    sf::Vector2f m_worldSize;
+    sf::Vector2f m_cellSize;
+    int m_columns;
+    int m_rows;
+    float m_maxRadius;              // Largest entity radius filed so far
+    
+    std::vector<std::uint32_t> m_heads;     // First node of each cell
+    std::vector<Node> m_nodes;              // By slot index
+    std::size_t m_count;
+    std::uint32_t m_stamp;
+};
+
+// Queries from many callers in a tick, answered in one pass. Callers add
+// their queries and keep the returned ticket; after run() each ticket reads
+// its hits. Results share one buffer that is reused tick after tick, so a
+// steady number of queries doesn't allocate.
+class SpatialQueryBatch {
+public:
+    using Ticket = std::size_t;
+    
+    // Hits of one query
+    struct Hits {
+        const SpatialHit* first;
+        std::size_t count;
+        
+        const SpatialHit* begin() const { return first; }
+        const SpatialHit* end() const { return first + count; }
+        bool empty() const { return count == 0; }
+    };
+    
+    SpatialQueryBatch();
+    
+    void reserve(std::size_t queries, std::size_t hits);
+    
+    Ticket addCircle(sf::Vector2f center, float radius);
+    Ticket addNearest(sf::Vector2f center, std::size_t count);
+    Ticket addRay(sf::Vector2f origin, sf::Vector2f direction, float maxDistance);
+    
+    // Answer every query added since the last clear()
+    void run(const SpatialIndex& index);
+    
+    // Valid after run() until clear()
+    Hits getHits(Ticket ticket) const;
+    
+    // Entries tested by the circle and nearest queries of the last run
+    std::size_t getTestedCount() const;
+    
+    // Forget the queries and their results, keeping the storage
+    void clear();
+
+private:
+    enum class Kind { Circle, Nearest, Ray };
+    
+    struct Query {
+        Kind kind;
+        sf::Vector2f point;
+        sf::Vector2f direction;
+        float extent;               // Radius, hit count or ray length
+        std::size_t firstHit;
+        std::size_t hitCount;
+    };
+    
+    std::vector<Query> m_queries;
+    std::vector<SpatialHit> m_hits;
+    std::size_t m_tested;
+};
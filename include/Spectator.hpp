@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "FrameSnapshot.hpp"
+#include "TripleBuffer.hpp"
+
+// Watching a running game from other processes over loopback UDP.
+//
+// A SpectatorBroadcaster takes the snapshot of every tick and sends it to
+// every spectator that has said hello to its port. Snapshots are quantised
+// (positions to 1/8 unit, angles to 1/65536 turn) into 32-bit fields, and
+// each frame is the XOR of its fields against the frame before, written as
+// runs of unchanged fields and varints of the changed ones. A keyframe
+// (XOR against nothing) goes out every KEYFRAME_INTERVAL frames and
+// whenever a spectator joins or asks for one.
+//
+// Encoding and sending happen on a thread of the broadcaster's own. The
+// publisher only copies its snapshot into a triple buffer, so a slow
+// encoder skips ticks instead of holding the game up, and a spectator that
+// doesn't keep up loses datagrams, notices the gap and asks for a keyframe.
+class SpectatorBroadcaster {
+public:
+    static constexpr std::size_t MAX_SPECTATORS = 16;
+    static constexpr std::uint32_t KEYFRAME_INTERVAL = 120;
+    
+    SpectatorBroadcaster();
+    ~SpectatorBroadcaster();
+    
+    SpectatorBroadcaster(const SpectatorBroadcaster&) = delete;
+    SpectatorBroadcaster& operator=(const SpectatorBroadcaster&) = delete;
+    
+    // Listen for spectators on a loopback port and start the encoder thread.
+    // False if the port can't be bound or there are no sockets here
+    bool start(std::uint16_t port);
+    void stop();
+    
+    bool isRunning() const;
+    
+    // Publisher: hand over this tick's snapshot. One thread only
+    void publish(const FrameSnapshot& snapshot);
+    
+    // Spectators heard from recently
+    std::size_t getSpectatorCount() const;
+    
+    // Frames sent, and published ticks the encoder skipped to catch up
+    std::uint64_t getSentFrameCount() const;
+    std::uint64_t getSkippedFrameCount() const;
+    
+    // Datagrams the socket refused to send. A spectator's full receive buffer
+    // usually drops them silently instead, which only that spectator sees
+    std::uint64_t getDroppedDatagramCount() const;
+
+private:
+    struct Frame {
+        FrameSnapshot snapshot;
+        std::uint64_t tick = 0;
+    };
+    
+    struct Spectator {
+        std::uint32_t address;      // IPv4, network byte order
+        std::uint16_t port;         // Network byte order
+        std::chrono::steady_clock::time_point lastHeard;
+    };
+    
+    // Body of the encoder thread
+    void run();
+    
+    // Encoder thread
+    void receiveRequests();
+    void dropSilentSpectators();
+    void sendFrame(const Frame& frame);
+    
+    int m_socket;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    
+    // Publisher
+    TripleBuffer<Frame> m_frames;
+    std::uint64_t m_publishedTicks;
+    
+    // Encoder thread
+    std::vector<Spectator> m_spectators;
+    std::vector<std::uint32_t> m_previous;      // Fields of the last frame sent
+    std::vector<std::uint32_t> m_current;
+    std::vector<std::uint8_t> m_payload;
+    std::vector<std::uint8_t> m_datagram;
+    std::uint32_t m_frameNumber;
+    std::uint64_t m_lastTick;
+    bool m_keyframeWanted;
+    
+    std::atomic<std::size_t> m_spectatorCount;
+    std::atomic<std::uint64_t> m_sentFrames;
+    std::atomic<std::uint64_t> m_skippedFrames;
+    std::atomic<std::uint64_t> m_droppedDatagrams;
+};
+
+// Receives a SpectatorBroadcaster's frames and rebuilds the snapshots
+class SpectatorClient {
+public:
+    SpectatorClient();
+    ~SpectatorClient();
+    
+    SpectatorClient(const SpectatorClient&) = delete;
+    SpectatorClient& operator=(const SpectatorClient&) = delete;
+    
+    // Open a socket and say hello to a broadcaster on a loopback port.
+    // False if there is no socket to be had
+    bool connect(std::uint16_t port);
+    void close();
+    
+    // Take in everything that has arrived and keep the broadcaster posted.
+    // True if at least one new frame was completed, the newest of which is
+    // decoded into snapshot
+    bool poll(FrameSnapshot& snapshot);
+    
+    // Game tick of the newest frame, as counted by the publisher
+    std::uint64_t getTick() const;
+    
+    std::uint64_t getFrameCount() const;
+    
+    // Frames missed or that couldn't be decoded for lack of their base
+    std::uint64_t getLostFrameCount() const;
+    
+    // True if a frame arrived in the last second
+    bool isReceiving() const;
+
+private:
+    // Hello, asking for a keyframe when the chain of deltas is broken
+    void sendHello();
+    
+    // A whole frame has arrived; false if there was no base to apply it to
+    bool applyFrame(bool keyframe, std::uint32_t wordCount, FrameSnapshot& snapshot);
+    
+    int m_socket;
+    std::uint16_t m_port;
+    std::chrono::steady_clock::time_point m_lastHello;
+    std::chrono::steady_clock::time_point m_lastFrameTime;
+    
+    // Frame being reassembled from its chunks
+    std::uint32_t m_assemblyFrame;
+    std::uint32_t m_assemblyChunks;
+    std::vector<std::uint8_t> m_assembly;
+    std::vector<bool> m_chunkReceived;
+    
+    // Decoded fields of the last frame applied
+    std::vector<std::uint32_t> m_words;
+    std::uint32_t m_frameNumber;
+    bool m_haveFrame;
+    bool m_keyframeWanted;
+    
+    std::uint64_t m_tick;
+    std::uint64_t m_frameCount;
+    std::uint64_t m_lostFrames;
+    std::vector<std::uint8_t> m_datagram;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include "FrameArena.hpp"
+#include "FrameSnapshot.hpp"
+#include "FramePacer.hpp"
+#include "Spectator.hpp"
+#include "UI.hpp"
+#include "WorldRenderer.hpp"
+
+// Watches a game broadcasting on a loopback port (Asteroids --spectate,
+// AsteroidsHeadless --spectate or ast_env_spectate) in a window. Each frame
+// takes in whatever has arrived and draws the newest snapshot; nothing is
+// buffered, so the view is as live as the stream.
+class SpectatorViewer {
+public:
+    // Throws std::runtime_error if there is no socket to listen on
+    explicit SpectatorViewer(std::uint16_t port);
+    
+    // Run until the window is closed
+    void run();
+
+private:
+    // Draw the newest snapshot with the HUD and stream status
+    void render();
+    
+    sf::RenderWindow m_window;
+    FramePacer m_framePacer;
+    FrameArena m_frameArena;
+    WorldRenderer m_worldRenderer;
+    UI m_ui;
+    
+    SpectatorClient m_client;
+    FrameSnapshot m_snapshot;
+    std::uint16_t m_port;
+};
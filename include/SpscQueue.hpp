@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-capacity FIFO from one producer thread to one consumer thread,
+// without locks or allocation. Unlike TripleBuffer every value pushed is
+// delivered, in order, as long as the consumer keeps up; a push to a full
+// queue fails instead of overwriting.
+//
+// Each side owns one index and only reads the other's, so the two never
+// write the same cache line.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer: append a value, returns false if the queue is full
+    bool push(const T& value)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_slots[tail & MASK] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer: the oldest value, or nullptr if the queue is empty. Stays
+    // valid until pop()
+    const T* front() const
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[head & MASK];
+    }
+    
+    // Consumer: drop the value front() returned
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    // Either side; only a snapshot while the other side is running
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+    
+    std::array<T, Capacity> m_slots{};
+    alignas(64) std::atomic<std::size_t> m_head{0};   // Next to read, consumer only writes
+    alignas(64) std::atomic<std::size_t> m_tail{0};   // Next to write, producer only writes
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+
+// Time to first frame. STARTUP_SCOPE marks the rest of a scope as a named
+// span of startup work; spans nest, and once the first frame is on screen
+// finish() prints them as a tree under the total time since the process
+// started. Spans that end after the report are not kept, so code shared with
+// the running game (resource loads) can be marked without costing anything
+// past startup but a relaxed load.
+namespace StartupTimer {
+
+using Clock = std::chrono::steady_clock;
+
+// When the process started. On Linux this is when it was created, so the
+// dynamic loader and static initialisation count towards startup; elsewhere
+// it is when this file's statics were initialised
+Clock::time_point getProcessStart();
+
+bool isFinished();
+
+// Add a finished span; ignored once the report has been printed
+void record(const char* name, Clock::time_point start, Clock::time_point end, int depth);
+
+// Print the report, once; later calls do nothing
+void finish();
+
+}
+
+// Times the rest of the enclosing scope until the first frame is shown
+class StartupScope {
+public:
+    explicit StartupScope(const char* name);
+    ~StartupScope();
+    
+    StartupScope(const StartupScope&) = delete;
+    StartupScope& operator=(const StartupScope&) = delete;
+
+private:
+    const char* m_name;
+    StartupTimer::Clock::time_point m_start;
+    int m_depth;
+};
+
+#define STARTUP_SCOPE_CONCAT_INNER(a, b) a##b
+#define STARTUP_SCOPE_CONCAT(a, b) STARTUP_SCOPE_CONCAT_INNER(a, b)
+#define STARTUP_SCOPE(name) StartupScope STARTUP_SCOPE_CONCAT(startupScope, __LINE__)(name)
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Byte copies of simulation state, for keyframes a flight recorder replay can
+// start from instead of the first tick. Classes that own state write their
+// fields in a fixed order with save() and read them back in the same order
+// with load(); plain values and arrays of them go in as their bytes.
+//
+// A StateWriter fills a buffer it is handed and never allocates, so it can
+// run in the middle of a game; once the buffer is full it only counts the
+// bytes it would have needed. A StateReader fails once it would read past
+// the end, leaving the value it was reading untouched, so a truncated or
+// damaged keyframe is turned down instead of read out of bounds.
+class StateWriter {
+public:
+    StateWriter(void* data, std::size_t capacity)
+        : m_data(static_cast<std::uint8_t*>(data))
+        , m_capacity(capacity)
+        , m_size(0)
+    {
+    }
+    
+    template <typename T>
+    void write(const T& value)
+    {
+        writeArray(&value, 1);
+    }
+    
+    template <typename T>
+    void writeArray(const T* values, std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only plain values are written as bytes");
+        std::size_t bytes = count * sizeof(T);
+        if (bytes > 0 && m_size <= m_capacity && bytes <= m_capacity - m_size) {
+            std::memcpy(m_data + m_size, values, bytes);
+        }
+        m_size += bytes;
+    }
+    
+    // The element count, then the elements
+    template <typename T>
+    void writeVector(const std::vector<T>& values)
+    {
+        write(static_cast<std::uint64_t>(values.size()));
+        writeArray(values.data(), values.size());
+    }
+    
+    // Bytes written, or needed if the buffer was too small
+    std::size_t size() const { return m_size; }
+    
+    // False if the buffer was too small for everything written
+    bool isComplete() const { return m_size <= m_capacity; }
+
+private:
+    std::uint8_t* m_data;
+    std::size_t m_capacity;
+    std::size_t m_size;
+};
+
+class StateReader {
+public:
+    StateReader(const void* data, std::size_t size)
+        : m_data(static_cast<const std::uint8_t*>(data))
+        , m_size(size)
+        , m_offset(0)
+        , m_failed(false)
+    {
+    }
+    
+    template <typename T>
+    bool read(T& value)
+    {
+        return readArray(&value, 1);
+    }
+    
+    template <typename T>
+    bool readArray(T* values, std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only plain values are read as bytes");
+        if (m_failed || count > getRemaining() / sizeof(T)) {
+            m_failed = true;
+            return false;
+        }
+        
+        std::size_t bytes = count * sizeof(T);
+        if (bytes > 0) {
+            std::memcpy(values, m_data + m_offset, bytes);
+        }
+        m_offset += bytes;
+        return true;
+    }
+    
+    // Undo writeVector(); the count is checked against the bytes left before
+    // anything is allocated
+    template <typename T>
+    bool readVector(std::vector<T>& values)
+    {
+        std::uint64_t count = 0;
+        if (!read(count) || count > getRemaining() / sizeof(T)) {
+            m_failed = true;
+            return false;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        return readArray(values.data(), values.size());
+    }
+    
+    std::size_t getRemaining() const { return m_size - m_offset; }
+    
+    // False once any read has failed
+    bool isValid() const { return !m_failed; }
+    
+    // Mark the state as damaged, for checks beyond the reader's own
+    void fail() { m_failed = true; }
+
+private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_offset;
+    bool m_failed;
+};
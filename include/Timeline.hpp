@@ -0,0 +1,159 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TimingWheel.hpp"
+
+class Timeline;
+
+// Coroutine run by a Timeline. Its frame comes from the timeline's pool, so
+// a coroutine must take the Timeline it runs on as its first parameter (or
+// its second, after the object, for a member function)
+class TimelineTask {
+public:
+    struct promise_type {
+        Timeline* timeline = nullptr;
+        std::uint32_t slot = 0;
+        std::uint32_t nextWaiter = 0;   // Next task waiting on the same event
+        
+        template <typename... Args>
+        static void* operator new(std::size_t size, Timeline& timeline, Args&...);
+        template <typename Owner, typename... Args>
+        static void* operator new(std::size_t size, Owner&, Timeline& timeline, Args&...);
+        static void operator delete(void* frame, std::size_t size);
+        
+        TimelineTask get_return_object();
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        
+        // Lets the exception out of whichever resume() ran into it
+        void unhandled_exception() { throw; }
+    };
+    
+    using Handle = std::coroutine_handle<promise_type>;
+    
+    TimelineTask(TimelineTask&& other) noexcept;
+    TimelineTask& operator=(TimelineTask&& other) noexcept;
+    ~TimelineTask();
+    
+    TimelineTask(const TimelineTask&) = delete;
+    TimelineTask& operator=(const TimelineTask&) = delete;
+
+private:
+    friend class Timeline;
+    
+    explicit TimelineTask(Handle handle);
+    
+    Handle m_handle;
+};
+
+// Scheduler for timed game logic written as coroutines. A task runs until it
+// waits for a number of ticks or for an event, and picks up again when the
+// tick comes round or the event is signalled:
+//
+//     co_await timeline.delay(120);
+//     co_await timeline.wait(levelCleared);
+//
+// Delays are kept in a TimingWheel and events in lists of their waiters, so
+// advancing a tick only touches the tasks that wake on it, however many are
+// waiting. Frames of finished tasks are pooled and reused by the next ones
+// of the same size, so spawning tasks after warm-up doesn't allocate.
+class Timeline {
+public:
+    using EventId = std::uint32_t;
+    
+    // co_await timeline.delay(ticks)
+    struct Delay {
+        Timeline& timeline;
+        std::uint32_t ticks;
+        
+        bool await_ready() const noexcept { return ticks == 0; }
+        void await_suspend(TimelineTask::Handle handle);
+        void await_resume() const noexcept {}
+    };
+    
+    // co_await timeline.wait(event)
+    struct Wait {
+        Timeline& timeline;
+        EventId event;
+        
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(TimelineTask::Handle handle);
+        void await_resume() const noexcept {}
+    };
+    
+    Timeline();
+    ~Timeline();
+    
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+    
+    void reserve(std::size_t tasks);
+    
+    // New event with nobody waiting on it. Events outlive clear()
+    EventId createEvent();
+    
+    // Take a task over and run it up to its first wait
+    void spawn(TimelineTask task);
+    
+    // Destroy every task and restart the clock at a tick
+    void clear(std::uint32_t tick = 0);
+    
+    // Wake every task waiting on an event. They run on the next advance(),
+    // in the order they started waiting
+    void signal(EventId event);
+    
+    // Move the clock on to a tick and run the tasks that are due by then or
+    // were woken by a signal, until all of them are waiting again
+    void advance(std::uint32_t tick);
+    
+    Delay delay(std::uint32_t ticks);
+    Wait wait(EventId event);
+    
+    std::uint32_t getTick() const;
+    
+    // Tasks spawned and not yet finished
+    std::size_t getTaskCount() const;
+
+private:
+    friend struct TimelineTask::promise_type;
+    
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    
+    struct Waiters {
+        std::uint32_t first = NONE;
+        std::uint32_t last = NONE;
+    };
+    
+    // Coroutine frames, each behind a header naming its timeline and size
+    void* allocateFrame(std::size_t size);
+    static void releaseFrame(void* frame);
+    
+    // Resume a task, and forget it once it has finished
+    void resume(std::uint32_t slot);
+    
+    std::vector<TimelineTask::Handle> m_tasks;     // By slot; null when free
+    std::vector<std::uint32_t> m_freeSlots;
+    std::size_t m_taskCount;
+    
+    TimingWheel m_delays;
+    std::vector<Waiters> m_events;
+    std::vector<std::uint32_t> m_ready;            // Slots to run on the next advance()
+    
+    std::vector<void*> m_freeFrames;
+};
+
+template <typename... Args>
+void* TimelineTask::promise_type::operator new(std::size_t size, Timeline& timeline, Args&...)
+{
+    return timeline.allocateFrame(size);
+}
+
+template <typename Owner, typename... Args>
+void* TimelineTask::promise_type::operator new(std::size_t size, Owner&, Timeline& timeline, Args&...)
+{
+    return timeline.allocateFrame(size);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SlotMap.hpp"
+#include "StateArchive.hpp"
+
+// Hierarchical timing wheel of entity expiries. Each entry is a handle and
+// the absolute tick it is due on; advancing a tick only touches the bucket
+// due on it, so the cost is per expiry instead of per entity per tick.
+//
+// The wheel has LEVELS rings of SLOTS buckets. An entry goes to the lowest
+// level whose bucket range still holds its tick: level 0 buckets are one
+// tick wide, level 1 buckets SLOTS ticks wide, and so on. When the clock
+// reaches the start of a higher-level bucket its entries are spread out
+// over the levels below, so each entry is moved at most LEVELS - 1 times.
+//
+// Entries live in one node pool threaded into per-bucket lists, with freed
+// nodes reused, so a steady number of live timers doesn't allocate. Nothing
+// is ever cancelled: an entity that goes early leaves a stale handle behind,
+// which the owner skips when it comes due.
+class TimingWheel {
+public:
+    static constexpr std::uint32_t SLOT_BITS = 6;
+    static constexpr std::uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr std::uint32_t LEVELS = 4;
+    
+    // Furthest ahead an entry can be scheduled; later ticks are clamped to it
+    static constexpr std::uint32_t MAX_DELAY = (1u << (SLOT_BITS * LEVELS)) - 1;
+    
+    TimingWheel();
+    
+    void reserve(std::size_t timers);
+    
+    // Drop every entry and restart the clock at a tick
+    void clear(std::uint32_t tick = 0);
+    
+    // Have handle come due on an absolute tick. Ticks not after the current
+    // one come due on the next
+    void schedule(SlotHandle handle, std::uint32_t tick);
+    
+    // Move the clock on to a tick, one tick at a time, and call
+    // expire(handle) for every entry that comes due on the way. expire must
+    // not schedule into this wheel
+    template <typename Expire>
+    void advance(std::uint32_t tick, Expire&& expire)
+    {
+        while (m_tick != tick) {
+            m_tick++;
+            cascade();
+            
+            std::uint32_t node = detach(0, m_tick & MASK);
+            while (node != NONE) {
+                std::uint32_t next = m_nodes[node].next;
+                expire(m_nodes[node].handle);
+                release(node);
+                node = next;
+            }
+        }
+    }
+    
+    std::uint32_t getTick() const;
+    
+    // Entries waiting, stale ones included
+    std::size_t size() const;
+    
+    // The clock and every entry, in bucket order, for keyframes of the
+    // simulation. load() returns false if the state is damaged
+    void save(StateWriter& out) const;
+    bool load(StateReader& in);
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr std::uint32_t MASK = SLOTS - 1;
+    
+    struct Node {
+        SlotHandle handle;
+        std::uint32_t tick;
+        std::uint32_t next;
+    };
+    
+    // File a node in the bucket its tick belongs to, from the current tick
+    void file(std::uint32_t node);
+    
+    // Spread out the higher-level buckets that start on the current tick
+    void cascade();
+    
+    // Unlink a bucket's list and return its first node
+    std::uint32_t detach(std::uint32_t level, std::uint32_t slot);
+    
+    void release(std::uint32_t node);
+    
+    std::array<std::uint32_t, LEVELS * SLOTS> m_buckets;   // First node of each bucket
+    std::vector<Node> m_nodes;
+    std::uint32_t m_freeHead;
+    std::uint32_t m_tick;
+    std::size_t m_count;
+};
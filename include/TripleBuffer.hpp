@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one producer thread to one consumer thread
+// without locks or waiting. The producer fills its back buffer and publishes
+// it; the consumer switches to the newest published buffer when it wants
+// one. Values published between two reads are skipped, never queued.
+//
+// Each side owns one buffer outright and the third sits in the middle. Only
+// the middle index is shared, swapped atomically together with a flag that
+// says whether it holds a value the consumer hasn't seen.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer: the buffer to fill next. Its old contents are stale but their
+    // storage can be reused.
+    T& getWriteBuffer()
+    {
+        return m_buffers[m_back];
+    }
+    
+    // Producer: make the write buffer the newest value
+    void publish()
+    {
+        std::uint8_t published = static_cast<std::uint8_t>(m_back | FRESH);
+        m_back = m_middle.exchange(published, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    
+    // Consumer: switch to the newest published value, returns false if
+    // nothing was published since the last switch
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    
+    // Consumer: the value picked up by the last update()
+    const T& getReadBuffer() const
+    {
+        return m_buffers[m_front];
+    }
+
+private:
+    static constexpr std::uint8_t INDEX_MASK = 0x3;
+    static constexpr std::uint8_t FRESH = 0x4;
+    
+    std::array<T, 3> m_buffers{};
+    std::uint8_t m_back = 0;               // Producer only
+    std::atomic<std::uint8_t> m_middle{1};
+    std::uint8_t m_front = 2;              // Consumer only
+};
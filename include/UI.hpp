@@ -1,11 +1,58 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include "AllocationTracker.hpp"
 #include "Constants.hpp"
+#include "FramePacer.hpp"
+#include "GlyphAtlas.hpp"
+#include "InputQueue.hpp"
+#include "QualityGovernor.hpp"
+#include "ResolutionScaler.hpp"
 
+// Memory figures shown next to the frame time statistics
+struct FrameMemoryStats {
+    AllocationTracker::Snapshot frame;    // Heap use of the last frame (zero unless tracking is built in)
+    AllocationTracker::Snapshot total;    // Heap use since startup
+    std::uint64_t framesWithoutHeap = 0;  // Consecutive frames without a heap allocation
+    std::size_t peakResidentBytes = 0;
+    std::size_t arenaPeak = 0;            // Most frame arena bytes used by one frame
+    std::size_t arenaCapacity = 0;
+};
+
+// Playback position shown by the replay viewer
+struct ReplayStatus {
+    std::uint64_t tick = 0;
+    std::uint64_t tickCount = 0;
+    float speed = 1.0f;            // Ticks played per tick of real time
+    float tickTimeMs = 0.0f;       // Recorded simulation time of the shown tick
+    float budgetMs = 0.0f;         // Ticks slower than this are flagged
+    bool paused = false;
+};
+
+// Stream shown by the spectator viewer
+struct SpectatorStatus {
+    std::uint16_t port = 0;
+    std::uint64_t tick = 0;        // Publisher's tick of the shown frame
+    std::uint64_t frames = 0;      // Frames received
+    std::uint64_t lostFrames = 0;
+    bool receiving = false;        // A frame arrived in the last second
+};
+
+// Draws the HUD and menus. Texts and shapes are created once and updated in
+// place, and labels are formatted in the caller's per-frame scratch memory,
+// so drawing an unchanged HUD doesn't touch the heap.
+//
+// Texts are drawn from a glyph atlas that is loaded, along with the texts
+// themselves, the first time anything needs them; constructing a UI costs
+// nothing.
 class UI {
 public:
-    UI();
+    explicit UI(std::pmr::memory_resource& scratch);
     
     // Render the score
     void renderScore(sf::RenderWindow& window, int score);
@@ -24,10 +71,71 @@ public:
     
     // Render pause menu
     void renderPauseMenu(sf::RenderWindow& window);
-
+    
     void renderVelocity(sf::RenderWindow& window, int deltaTime);
+    
+    // Render frame time statistics, effects quality, render scale (if the
+    // world is drawn offscreen), input latency and the frame time histogram
+    void renderFrameStats(sf::RenderWindow& window, const FramePacer& framePacer, const FrameMemoryStats& memory,
+                          const QualityGovernor& quality, const ResolutionScaler* resolution,
+                          const InputLatency& input, std::uint32_t droppedInputs);
+    
+    // Render the replay viewer's position bar and controls
+    void renderReplayStatus(sf::RenderWindow& window, const ReplayStatus& status);
+    
+    // Render the spectator viewer's stream status
+    void renderSpectatorStatus(sf::RenderWindow& window, const SpectatorStatus& status);
+    
+    // Draw calls issued since the last call, then start counting from zero
+    std::uint32_t takeDrawCalls();
 
 private:
-    sf::Font m_font;
-    bool m_fontLoaded;
+    // window.draw, counted
+    void draw(sf::RenderWindow& window, const sf::Drawable& drawable);
+    
+    // Load the glyph atlas and create the texts, the first time only.
+    // False if there is no font to draw them with
+    bool ensureTexts();
+    
+    // Create a text from the glyph atlas
+    AtlasText makeText(std::string_view value, unsigned int size, sf::Vector2f position);
+    
+    // Put a text's origin at its centre
+    static void centerOrigin(AtlasText& text);
+    
+    GlyphAtlas m_atlas;
+    bool m_textsCreated;
+    
+    // Transient strings, rewound by the owner every frame
+    std::pmr::memory_resource& m_scratch;
+    
+    // HUD
+    std::optional<AtlasText> m_scoreText;
+    std::optional<AtlasText> m_livesText;
+    std::optional<AtlasText> m_levelText;
+    std::optional<AtlasText> m_velocityText;
+    sf::ConvexShape m_lifeIcon;
+    
+    // Menus and overlays
+    sf::RectangleShape m_overlay;
+    std::optional<AtlasText> m_gameOverText;
+    std::optional<AtlasText> m_finalScoreText;
+    std::optional<AtlasText> m_restartText;
+    std::optional<AtlasText> m_titleText;
+    std::optional<AtlasText> m_startText;
+    std::optional<AtlasText> m_controlsText;
+    std::optional<AtlasText> m_pauseText;
+    std::optional<AtlasText> m_resumeText;
+    
+    // Frame statistics panel
+    sf::RectangleShape m_statsPanel;
+    sf::RectangleShape m_statsBar;
+    std::optional<AtlasText> m_statsText;
+    
+    // Replay position bar
+    sf::RectangleShape m_replayTrack;
+    sf::RectangleShape m_replayProgress;
+    std::optional<AtlasText> m_replayText;
+    
+    std::uint32_t m_drawCalls;
 };
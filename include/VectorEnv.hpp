@@ -0,0 +1,114 @@
+#pragma once
+
+#include "asteroids_env.h"
+#include "Simulation.hpp"
+#include "SoftwareRenderer.hpp"
+#include "Spectator.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A batch of simulations stepped in lockstep for bot training, behind the
+// C interface in asteroids_env.h. All buffers are sized once at creation.
+class VectorEnv {
+public:
+    explicit VectorEnv(const AstEnvConfig& config);
+    ~VectorEnv();
+    
+    VectorEnv(const VectorEnv&) = delete;
+    VectorEnv& operator=(const VectorEnv&) = delete;
+    
+    std::uint32_t size() const;
+    const float* observations() const;
+    const float* rewards() const;
+    const std::uint8_t* dones() const;
+    
+    // Rendered frames, null unless pixel observations are enabled
+    const std::uint8_t* pixels() const;
+    std::uint32_t pixelSize() const;
+    
+    // Write into caller-owned buffers, null keeps the current one
+    void bindBuffers(float* observations, float* rewards, std::uint8_t* dones);
+    
+    // Start a new episode in every environment
+    void reset();
+    
+    // Apply one action per environment and advance all of them by one tick
+    void step(const std::uint8_t* actions);
+    
+    // Broadcast environment 0 after every reset and step to spectators on a
+    // loopback port, 0 = stop. False if the port can't be opened
+    bool spectate(std::uint16_t port);
+
+private:
+    // One game plus scratch space for building its observation
+    struct Environment {
+        explicit Environment(const SimulationConfig& config);
+        
+        Simulation simulation;
+        int lastScore = 0;
+        std::uint32_t episodeTicks = 0;
+        
+        // Candidates for the nearest-bullet features: squared distance and offset
+        struct Nearby { float distance; sf::Vector2f delta; const Entity* entity; };
+        std::vector<Nearby> nearby;
+        
+        // Nearest asteroids, from the simulation's spatial index
+        std::vector<SpatialHit> nearestAsteroids;
+        
+        // Pixel observations, drawn straight into this environment's slice of m_pixels
+        std::unique_ptr<SoftwareRenderer> renderer;
+        FrameSnapshot snapshot;
+    };
+    
+    enum class Task { Reset, Step };
+    
+    // Run a task over environments [first, last)
+    void runRange(Task task, std::uint32_t first, std::uint32_t last);
+    
+    // Run a task over all environments, split across the workers
+    void runAll(Task task);
+    
+    void resetEnvironment(std::uint32_t index);
+    void stepEnvironment(std::uint32_t index, std::uint8_t action);
+    void writeObservation(Environment& environment, float* out);
+    void writePixels(std::uint32_t index);
+    
+    // Hand environment 0 to the spectators, if any are being broadcast to
+    void publishSpectatorFrame();
+    
+    void workerLoop(std::uint32_t worker);
+    
+    AstEnvConfig m_config;
+    float m_deltaTime;
+    std::vector<std::unique_ptr<Environment>> m_environments;
+    
+    // Owned output buffers and the ones currently written to
+    std::vector<float> m_ownObservations;
+    std::vector<float> m_ownRewards;
+    std::vector<std::uint8_t> m_ownDones;
+    float* m_observations;
+    float* m_rewards;
+    std::uint8_t* m_dones;
+    std::vector<std::uint8_t> m_pixels;
+    std::uint32_t m_pixelSize;
+    
+    // Broadcast of environment 0, fed from the calling thread
+    SpectatorBroadcaster m_spectators;
+    FrameSnapshot m_spectatorSnapshot;
+    
+    // Worker pool; the calling thread runs the first shard itself
+    std::uint32_t m_shards;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+    std::uint64_t m_generation;
+    std::uint32_t m_pending;
+    bool m_stopping;
+    Task m_task;
+    const std::uint8_t* m_actions;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include "FrameSnapshot.hpp"
+
+// Draws the entities of a FrameSnapshot to a render target. One shape per kind of
+// entity is set up once and moved around for each instance, so drawing
+// doesn't depend on the live simulation objects and can run on another
+// thread than the one updating them.
+//
+// In a world bigger than the window the camera follows the player, and
+// whatever is out of its view isn't drawn. Entities are drawn at their copy
+// nearest the camera, so the view scrolls across the wrap without a seam.
+class WorldRenderer {
+public:
+    WorldRenderer();
+    
+    // Draw asteroids, bullets, particles and (outside game over) the player.
+    // Leaves the target's default view set
+    void render(sf::RenderTarget& target, const FrameSnapshot& snapshot);
+    
+    // Part of the target the world is drawn into, as fractions of its size;
+    // the whole target by default
+    void setViewport(const sf::FloatRect& viewport);
+    
+    // Draw calls issued since the last call, then start counting from zero
+    std::uint32_t takeDrawCalls();
+
+private:
+    // Centre the camera on the player along each axis the world is longer
+    // than the view, and in the middle of the world along the others
+    void placeCamera(sf::RenderTarget& target, const FrameSnapshot& snapshot);
+    
+    // Where to draw something at (x, y) that reaches margin beyond it, or
+    // false if it's out of view
+    bool toView(float x, float y, float margin, sf::Vector2f& position) const;
+    
+    void renderPlayer(sf::RenderTarget& target, const SnapshotPlayer& player);
+    
+    // target.draw, counted
+    void draw(sf::RenderTarget& target, const sf::Drawable& drawable);
+    
+    sf::ConvexShape m_asteroidShape;
+    sf::CircleShape m_bulletShape;
+    sf::RectangleShape m_particleShape;
+    sf::ConvexShape m_shipShape;
+    sf::ConvexShape m_flameShape;
+    
+    sf::View m_camera;
+    sf::FloatRect m_viewport;
+    sf::Vector2f m_worldSize;
+    
+    std::uint32_t m_drawCalls;
+};
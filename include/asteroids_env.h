@@ -0,0 +1,102 @@
+#ifndef ASTEROIDS_ENV_H
+#define ASTEROIDS_ENV_H
+
+/*
+ * C interface to a batch of headless Asteroids games for training bots.
+ *
+ * All environments step together: one ast_env_step call applies one action
+ * per environment and advances every game by one tick. Observations, rewards
+ * and done flags are written into flat buffers that stay at the same address
+ * for the lifetime of the batch, so callers can wrap them once (for example
+ * as numpy arrays) and read them after every step without copying.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define AST_ENV_API __declspec(dllexport)
+#else
+#define AST_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Observation layout per environment, all values roughly in [-1, 1] */
+#define AST_ENV_PLAYER_FEATURES 9     /* x, y, vx, vy, dir_x, dir_y, invulnerable, can_fire, lives */
+#define AST_ENV_MAX_ASTEROIDS 24      /* nearest asteroids, closest first */
+#define AST_ENV_ASTEROID_FEATURES 6   /* present, dx, dy, vx, vy, radius */
+#define AST_ENV_MAX_BULLETS 8         /* nearest bullets, closest first */
+#define AST_ENV_BULLET_FEATURES 3     /* present, dx, dy */
+#define AST_ENV_OBSERVATION_SIZE                                  \
+    (AST_ENV_PLAYER_FEATURES                                      \
+     + AST_ENV_MAX_ASTEROIDS * AST_ENV_ASTEROID_FEATURES          \
+     + AST_ENV_MAX_BULLETS * AST_ENV_BULLET_FEATURES)
+
+/* Action bits, combined per environment */
+#define AST_ACTION_THRUST 0x01u
+#define AST_ACTION_LEFT   0x02u
+#define AST_ACTION_RIGHT  0x04u
+#define AST_ACTION_FIRE   0x08u
+
+typedef struct AstEnvConfig {
+    uint32_t num_envs;           /* environments in the batch */
+    uint32_t num_threads;        /* worker threads, 0 or 1 = step on the calling thread */
+    uint32_t seed;               /* base seed, each environment derives its own */
+    float world_width;           /* 0 = window size */
+    float world_height;          /* 0 = window size */
+    float tick_rate;             /* simulated ticks per second, 0 = 60 */
+    uint32_t max_episode_ticks;  /* truncate episodes after this many ticks, 0 = never */
+    uint32_t pixel_width;        /* rendered pixel observations, 0 = off */
+    uint32_t pixel_height;
+    uint32_t pixel_grayscale;    /* nonzero = 1 byte per pixel, else RGBA */
+} AstEnvConfig;
+
+typedef struct AstEnv AstEnv;
+
+/* Fill config with defaults */
+AST_ENV_API void ast_env_default_config(AstEnvConfig* config);
+
+/* Create a batch of environments, returns NULL on failure */
+AST_ENV_API AstEnv* ast_env_create(const AstEnvConfig* config);
+AST_ENV_API void ast_env_destroy(AstEnv* env);
+
+AST_ENV_API uint32_t ast_env_num_envs(const AstEnv* env);
+AST_ENV_API uint32_t ast_env_observation_size(void);
+
+/* Buffers owned by the batch: num_envs * AST_ENV_OBSERVATION_SIZE floats,
+ * num_envs rewards and num_envs done flags */
+AST_ENV_API const float* ast_env_observations(const AstEnv* env);
+AST_ENV_API const float* ast_env_rewards(const AstEnv* env);
+AST_ENV_API const uint8_t* ast_env_dones(const AstEnv* env);
+
+/* Rendered frames, num_envs * ast_env_pixel_size bytes, row-major per
+ * environment; NULL when pixel observations are off. Updated with the
+ * feature observations on every reset and step. */
+AST_ENV_API const uint8_t* ast_env_pixels(const AstEnv* env);
+AST_ENV_API uint32_t ast_env_pixel_size(const AstEnv* env);
+
+/* Write into caller-owned buffers instead (any may be NULL to keep the
+ * batch's own). The memory must stay valid until replaced or destroyed. */
+AST_ENV_API void ast_env_bind_buffers(AstEnv* env, float* observations, float* rewards, uint8_t* dones);
+
+/* Broadcast environment 0 after every reset and step to spectators on a
+ * loopback UDP port (watch with: Asteroids --watch PORT); 0 stops. Frames
+ * are encoded on a thread of their own and skipped, never waited for, when
+ * it falls behind. Returns 1 on success, 0 if the port can't be opened. */
+AST_ENV_API int ast_env_spectate(AstEnv* env, uint32_t port);
+
+/* Start a new episode in every environment and write initial observations */
+AST_ENV_API void ast_env_reset(AstEnv* env);
+
+/* Apply actions[num_envs] and advance every environment by one tick.
+ * Reward is the score gained this tick. Environments that finish an episode
+ * set done and start a new one; their observation is of the new episode. */
+AST_ENV_API void ast_env_step(AstEnv* env, const uint8_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ASTEROIDS_ENV_H */
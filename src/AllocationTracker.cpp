@@ -0,0 +1,190 @@
+#include "AllocationTracker.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr std::size_t TAG_COUNT = static_cast<std::size_t>(AllocationTag::Count);
+
+struct AtomicCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+};
+
+AtomicCounters g_tags[TAG_COUNT];
+std::atomic<std::uint64_t> g_liveBytes{0};
+std::atomic<std::uint64_t> g_peakLiveBytes{0};
+
+thread_local AllocationTag t_tag = AllocationTag::Other;
+thread_local std::uint64_t t_allocations = 0;
+
+}
+
+AllocationTracker::Counters AllocationTracker::Snapshot::total() const
+{
+    Counters sum;
+    for (const Counters& counters : tags) {
+        sum.allocations += counters.allocations;
+        sum.bytes += counters.bytes;
+    }
+    return sum;
+}
+
+const char* AllocationTracker::getTagName(AllocationTag tag)
+{
+    switch (tag) {
+        case AllocationTag::Other: return "other";
+        case AllocationTag::Update: return "update";
+        case AllocationTag::Collision: return "collision";
+        case AllocationTag::Render: return "render";
+        case AllocationTag::Audio: return "audio";
+        case AllocationTag::UI: return "ui";
+        case AllocationTag::Count: break;
+    }
+    return "?";
+}
+
+AllocationTracker::Snapshot AllocationTracker::capture()
+{
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < TAG_COUNT; ++i) {
+        snapshot.tags[i].allocations = g_tags[i].allocations.load(std::memory_order_relaxed);
+        snapshot.tags[i].bytes = g_tags[i].bytes.load(std::memory_order_relaxed);
+    }
+    snapshot.liveBytes = g_liveBytes.load(std::memory_order_relaxed);
+    snapshot.peakLiveBytes = g_peakLiveBytes.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+std::uint64_t AllocationTracker::getThreadAllocationCount()
+{
+    return t_allocations;
+}
+
+std::size_t AllocationTracker::getPeakResidentBytes()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss);         // bytes
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#else
+    return 0;
+#endif
+}
+
+AllocationTag AllocationTracker::getThreadTag()
+{
+    return t_tag;
+}
+
+void AllocationTracker::setThreadTag(AllocationTag tag)
+{
+    t_tag = tag;
+}
+
+#if defined(ASTEROIDS_TRACK_ALLOCATIONS)
+
+// Replacements for the global allocation functions. The array and nothrow
+// forms of the standard library forward to these.
+//
+// Every block starts with a header recording its size and tag, so frees are
+// charged correctly even when the unsized delete is called.
+
+namespace {
+
+struct alignas(16) Header {
+    std::uint64_t size;
+    std::uint32_t offset;  // From the start of the malloc'd block to the user pointer
+    std::uint32_t tag;
+};
+
+void* trackedAllocate(std::size_t size, std::size_t alignment)
+{
+    std::size_t offset = alignment > sizeof(Header) ? alignment : sizeof(Header);
+    std::size_t total = offset + (size ? size : 1);
+    
+    void* block;
+    if (alignment <= alignof(std::max_align_t)) {
+        block = std::malloc(total);
+    } else {
+        block = std::aligned_alloc(alignment, (total + alignment - 1) / alignment * alignment);
+    }
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    
+    char* user = static_cast<char*>(block) + offset;
+    Header* header = reinterpret_cast<Header*>(user) - 1;
+    header->size = size;
+    header->offset = static_cast<std::uint32_t>(offset);
+    header->tag = static_cast<std::uint32_t>(t_tag);
+    
+    AtomicCounters& counters = g_tags[header->tag];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    t_allocations++;
+    
+    std::uint64_t live = g_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = g_peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        // A failed exchange reloads peak, try again while we're still higher
+    }
+    
+    return user;
+}
+
+void trackedFree(void* pointer)
+{
+    if (!pointer) {
+        return;
+    }
+    
+    Header* header = static_cast<Header*>(pointer) - 1;
+    g_liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(static_cast<char*>(pointer) - header->offset);
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    return trackedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return trackedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+#endif
@@ -1,69 +1,50 @@
 #include "Asteroid.hpp"
+#include "StateArchive.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <random>
 
-Asteroid::Asteroid(sf::Vector2f position, AsteroidSize size)
-    : Entity(position, 0.0f)
+Asteroid::Asteroid(sf::Vector2f position, AsteroidSize size, std::mt19937& rng)
+    : Entity(position, getRadiusFor(size))
+    , m_vertices()
+    , m_vertexCount(0)
     , m_size(size)
 {
     m_type = EntityType::Asteroid;
     
-    // Set radius based on asteroid size
-    switch (m_size) {
-        case AsteroidSize::Large:
-            m_radius = ASTEROID_LARGE_RADIUS;
-            break;
-        case AsteroidSize::Medium:
-            m_radius = ASTEROID_MEDIUM_RADIUS;
-            break;
-        case AsteroidSize::Small:
-            m_radius = ASTEROID_SMALL_RADIUS;
-            break;
-    }
-    
     // Random number generation
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_real_distribution<float> speedDist(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX);
     std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159f);
     std::uniform_real_distribution<float> rotSpeedDist(ASTEROID_ROTATION_SPEED_MIN, ASTEROID_ROTATION_SPEED_MAX);
     
     // Random direction and speed
-    float angle = angleDist(gen);
-    float speed = speedDist(gen);
+    float angle = angleDist(rng);
+    float speed = speedDist(rng);
     m_velocity = sf::Vector2f(std::cos(angle) * speed, std::sin(angle) * speed);
     
     // Random rotation speed (positive or negative)
-    m_rotationSpeed = rotSpeedDist(gen);
-    if (gen() % 2 == 0) {
+    m_rotationSpeed = rotSpeedDist(rng);
+    if (rng() % 2 == 0) {
         m_rotationSpeed = -m_rotationSpeed;
     }
     
-    generateShape();
+    generateOutline(rng);
 }
 
-void Asteroid::update(float deltaTime)
+Asteroid::Asteroid(sf::Vector2f position, sf::Vector2f velocity, float rotation, float rotationSpeed,
+                   AsteroidSize size, const sf::Vector2f* vertices, std::size_t vertexCount)
+    : Entity(position, getRadiusFor(size))
+    , m_vertices()
+    , m_vertexCount(std::min(vertexCount, m_vertices.size()))
+    , m_size(size)
+    , m_rotationSpeed(rotationSpeed)
 {
-    move(deltaTime);
-    
-    // Rotate the asteroid
-    m_rotation += m_rotationSpeed * deltaTime;
+    m_type = EntityType::Asteroid;
+    m_velocity = velocity;
+    m_rotation = rotation;
     
-    // Keep rotation in [0, 360) range
-    while (m_rotation < 0.0f) {
-        m_rotation += 360.0f;
-    }
-    while (m_rotation >= 360.0f) {
-        m_rotation -= 360.0f;
-    }
-}
-
-void Asteroid::render(sf::RenderWindow& window)
-{
-    m_shape.setPosition(m_position);
-    // Convert m_rotation (a float in degrees) into an sf::Angle using sf::degrees()
-    m_shape.setRotation(sf::degrees(m_rotation));
-    window.draw(m_shape);
+    std::copy(vertices, vertices + m_vertexCount, m_vertices.begin());
 }
 
 AsteroidSize Asteroid::getSize() const
@@ -85,65 +66,114 @@ int Asteroid::getPoints() const
     }
 }
 
-void Asteroid::generateShape()
+float Asteroid::getRotationSpeed() const
+{
+    return m_rotationSpeed;
+}
+
+std::size_t Asteroid::getVertexCount() const
+{
+    return m_vertexCount;
+}
+
+sf::Vector2f Asteroid::getVertex(std::size_t index) const
+{
+    return m_vertices[index];
+}
+
+void Asteroid::save(StateWriter& out) const
+{
+    std::uint8_t vertexCount = static_cast<std::uint8_t>(getVertexCount());
+    out.write(m_size);
+    out.write(m_rotationSpeed);
+    out.write(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        out.write(getVertex(i));
+    }
+    saveMotion(out);
+}
+
+Asteroid Asteroid::load(StateReader& in)
+{
+    AsteroidSize size = AsteroidSize::Large;
+    float rotationSpeed = 0.0f;
+    std::uint8_t vertexCount = 0;
+    std::array<sf::Vector2f, ASTEROID_VERTICES_MAX> vertices{};
+    in.read(size);
+    in.read(rotationSpeed);
+    if (in.read(vertexCount) && vertexCount > ASTEROID_VERTICES_MAX) {
+        in.fail();
+        vertexCount = 0;
+    }
+    in.readArray(vertices.data(), vertexCount);
+    
+    Asteroid asteroid(sf::Vector2f(), sf::Vector2f(), 0.0f, rotationSpeed, size, vertices.data(), vertexCount);
+    asteroid.loadMotion(in);
+    return asteroid;
+}
+
+float Asteroid::getRadiusFor(AsteroidSize size)
+{
+    switch (size) {
+        case AsteroidSize::Large:
+            return ASTEROID_LARGE_RADIUS;
+        case AsteroidSize::Medium:
+            return ASTEROID_MEDIUM_RADIUS;
+        case AsteroidSize::Small:
+            return ASTEROID_SMALL_RADIUS;
+        default:
+            return 0.0f;
+    }
+}
+
+void Asteroid::generateOutline(std::mt19937& rng)
 {
     // Random number generation
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<int> verticesDist(ASTEROID_VERTICES_MIN, ASTEROID_VERTICES_MAX);
     std::uniform_real_distribution<float> radiusVariationDist(0.5f, 1.5f);
     
     // Decide number of vertices
-    int numVertices = verticesDist(gen);
-    m_shape.setPointCount(numVertices);
+    int numVertices = verticesDist(rng);
+    m_vertexCount = static_cast<std::size_t>(numVertices);
     
     // Generate irregular polygon with random radius variations
     for (int i = 0; i < numVertices; ++i) {
         float angle = i * 2.0f * 3.14159f / numVertices;
-        float radiusVariation = radiusVariationDist(gen);
+        float radiusVariation = radiusVariationDist(rng);
         float vertexRadius = m_radius * radiusVariation;
         
         float x = std::cos(angle) * vertexRadius;
         float y = std::sin(angle) * vertexRadius;
         
-        m_shape.setPoint(i, sf::Vector2f(x, y));
+        m_vertices[i] = sf::Vector2f(x, y);
     }
-    
-    m_shape.setFillColor(sf::Color::Transparent);
-    m_shape.setOutlineColor(sf::Color::White);
-    m_shape.setOutlineThickness(1.0f);
-    // Use a single sf::Vector2f as the origin
-    m_shape.setOrigin(sf::Vector2f(0.0f, 0.0f));
 }
 
-Asteroid Asteroid::createRandom(const sf::Vector2f& playerPosition)
+Asteroid Asteroid::createRandom(const sf::Vector2f& playerPosition, const sf::Vector2f& worldSize, std::mt19937& rng)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
-    // Random position along the edge of the screen
+    // Random position along the edge of the world
     std::uniform_int_distribution<int> edgeDist(0, 3); // 0: top, 1: right, 2: bottom, 3: left
     std::uniform_real_distribution<float> positionDist;
     
     sf::Vector2f position;
-    int edge = edgeDist(gen);
+    int edge = edgeDist(rng);
     
     switch (edge) {
         case 0: // Top edge
-            positionDist = std::uniform_real_distribution<float>(0.0f, static_cast<float>(WINDOW_WIDTH));
-            position = sf::Vector2f(positionDist(gen), 0.0f);
+            positionDist = std::uniform_real_distribution<float>(0.0f, worldSize.x);
+            position = sf::Vector2f(positionDist(rng), 0.0f);
             break;
         case 1: // Right edge
-            positionDist = std::uniform_real_distribution<float>(0.0f, static_cast<float>(WINDOW_HEIGHT));
-            position = sf::Vector2f(static_cast<float>(WINDOW_WIDTH), positionDist(gen));
+            positionDist = std::uniform_real_distribution<float>(0.0f, worldSize.y);
+            position = sf::Vector2f(worldSize.x, positionDist(rng));
             break;
         case 2: // Bottom edge
-            positionDist = std::uniform_real_distribution<float>(0.0f, static_cast<float>(WINDOW_WIDTH));
-            position = sf::Vector2f(positionDist(gen), static_cast<float>(WINDOW_HEIGHT));
+            positionDist = std::uniform_real_distribution<float>(0.0f, worldSize.x);
+            position = sf::Vector2f(positionDist(rng), worldSize.y);
             break;
         case 3: // Left edge
-            positionDist = std::uniform_real_distribution<float>(0.0f, static_cast<float>(WINDOW_HEIGHT));
-            position = sf::Vector2f(0.0f, positionDist(gen));
+            positionDist = std::uniform_real_distribution<float>(0.0f, worldSize.y);
+            position = sf::Vector2f(0.0f, positionDist(rng));
             break;
     }
     
@@ -163,5 +193,26 @@ Asteroid Asteroid::createRandom(const sf::Vector2f& playerPosition)
     }
     
     // Create a large asteroid
-    return Asteroid(position, AsteroidSize::Large);
+    return Asteroid(position, AsteroidSize::Large, rng);
+}
+
+Asteroid Asteroid::createScattered(const sf::Vector2f& playerPosition, const sf::Vector2f& worldSize,
+                                   float minDistance, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> xDist(0.0f, worldSize.x);
+    std::uniform_real_distribution<float> yDist(0.0f, worldSize.y);
+    
+    // Draw again while too close; the player's clear circle is a tiny part
+    // of any world big enough to scatter over, so this rarely repeats
+    sf::Vector2f position;
+    float distanceToPlayer = 0.0f;
+    do {
+        position = sf::Vector2f(xDist(rng), yDist(rng));
+        sf::Vector2f delta = position - playerPosition;
+        delta.x -= worldSize.x * std::round(delta.x / worldSize.x);
+        delta.y -= worldSize.y * std::round(delta.y / worldSize.y);
+        distanceToPlayer = std::hypot(delta.x, delta.y);
+    } while (distanceToPlayer < minDistance);
+    
+    return Asteroid(position, AsteroidSize::Large, rng);
 }
@@ -1,7 +1,27 @@
 #include "AudioManager.hpp"
+#include "AllocationTracker.hpp"
+#include "FlightRecorder.hpp"
+#include "Profiler.hpp"
 #include "ResourceManager.hpp"
-#include <iostream>
 #include <algorithm>
+#include <cmath>
+
+namespace {
+
+// File of each SoundId, in order
+constexpr const char* SOUND_FILES[] = {
+    "fire.wav",
+    "explosion_small.wav",
+    "explosion_medium.wav",
+    "explosion_large.wav",
+    "explosion.wav",
+    "thrust.wav",
+};
+
+static_assert(sizeof(SOUND_FILES) / sizeof(SOUND_FILES[0]) == static_cast<std::size_t>(SoundId::Count),
+              "Every SoundId needs a file");
+
+}
 
 AudioManager& AudioManager::getInstance()
 {
@@ -10,41 +30,194 @@ AudioManager& AudioManager::getInstance()
 }
 
 AudioManager::AudioManager()
+    : m_running(false)
+    , m_activeSoundCount(0)
+    , m_droppedCommands(0)
+    , m_queuedCounts{}
 {
+    // Sounds point into ResourceManager's buffers, so it has to outlive us;
+    // statics are destroyed in reverse order of construction
+    ResourceManager::getInstance();
+    
     // Reserve space for active sounds
     m_activeSounds.reserve(MAX_SOUNDS);
 }
 
-void AudioManager::playSound(const std::string& name)
+AudioManager::~AudioManager()
 {
-    // Get the sound buffer
-    sf::SoundBuffer& buffer = ResourceManager::getInstance().getSoundBuffer(name);
-    
-    // Clean up finished sounds
-    update();
-    
-    // If we've reached the maximum number of sounds, return
-    if (m_activeSounds.size() >= MAX_SOUNDS) {
+    stop();
+}
+
+void AudioManager::start()
+{
+    if (m_thread.joinable()) {
         return;
     }
+    m_running.store(true);
+    m_thread = std::thread(&AudioManager::run, this);
+}
+
+void AudioManager::stop()
+{
+    m_running.store(false);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
     
-    // Create and play the sound using the new constructor that accepts a buffer
-    auto sound = std::make_unique<sf::Sound>(buffer);
-    sound->play();
+    m_activeSounds.clear();
+    for (std::optional<sf::Sound>& loop : m_loops) {
+        loop.reset();
+    }
+    m_activeSoundCount.store(0, std::memory_order_relaxed);
+}
+
+void AudioManager::preloadSounds()
+{
+    push(CommandType::Preload);
+}
+
+void AudioManager::playSound(SoundId sound, float volume)
+{
+    push(CommandType::Play, sound, volume);
+}
+
+void AudioManager::queueSound(SoundId sound)
+{
+    m_queuedCounts[static_cast<std::size_t>(sound)]++;
+}
+
+void AudioManager::flushQueuedSounds()
+{
+    for (std::size_t i = 0; i < SOUND_COUNT; ++i) {
+        if (m_queuedCounts[i] == 0) {
+            continue;
+        }
+        
+        // N identical sounds at once are louder than one, but far from N times louder
+        float volume = SOUND_EFFECT_VOLUME * std::sqrt(static_cast<float>(m_queuedCounts[i]));
+        playSound(static_cast<SoundId>(i), std::min(volume, 100.0f));
+        m_queuedCounts[i] = 0;
+    }
+}
+
+void AudioManager::playLoop(SoundId sound)
+{
+    push(CommandType::PlayLoop, sound);
+}
+
+void AudioManager::pauseLoop(SoundId sound)
+{
+    push(CommandType::PauseLoop, sound);
+}
+
+void AudioManager::stopLoop(SoundId sound)
+{
+    push(CommandType::StopLoop, sound);
+}
+
+void AudioManager::setGain(float volume)
+{
+    push(CommandType::SetGain, SoundId::Count, volume);
+}
+
+std::size_t AudioManager::getActiveSoundCount() const
+{
+    return m_activeSoundCount.load(std::memory_order_relaxed);
+}
+
+std::uint32_t AudioManager::getDroppedCommandCount() const
+{
+    return m_droppedCommands.load(std::memory_order_relaxed);
+}
+
+void AudioManager::push(CommandType type, SoundId sound, float volume)
+{
+    if (!m_commands.push({type, sound, volume})) {
+        m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AudioManager::run()
+{
+    Profiler::setThreadName("audio");
+    FlightRecorder::installThreadStack();
+    AllocationScope allocationScope(AllocationTag::Audio);
     
-    // Add to active sounds
-    m_activeSounds.push_back(std::move(sound));
+    while (m_running.load(std::memory_order_relaxed)) {
+        while (const Command* command = m_commands.front()) {
+            execute(*command);
+            m_commands.pop();
+        }
+        
+        removeFinishedSounds();
+        
+        // A sound starts at most this late; cheaper than waking the thread
+        // from the producer, which would need a lock there
+        std::this_thread::sleep_for(IDLE_WAIT);
+    }
 }
 
-void AudioManager::initializeSounds()
+void AudioManager::execute(const Command& command)
 {
-    // Ensure ResourceManager has loaded the sound resources
-    ResourceManager::getInstance().loadResources();
+    PROFILE_ZONE("AudioManager::execute");
+    
+    std::size_t index = static_cast<std::size_t>(command.sound);
+    switch (command.type) {
+        case CommandType::Preload:
+            for (std::size_t i = 0; i < SOUND_COUNT; ++i) {
+                getBuffer(static_cast<SoundId>(i));
+            }
+            break;
+        
+        case CommandType::Play: {
+            sf::SoundBuffer& buffer = getBuffer(command.sound);
+            
+            // Make room among the finished ones; past the limit the sound is skipped
+            removeFinishedSounds();
+            if (m_activeSounds.size() >= MAX_SOUNDS) {
+                break;
+            }
+            
+            auto sound = std::make_unique<sf::Sound>(buffer);
+            sound->setVolume(command.volume);
+            sound->play();
+            m_activeSounds.push_back(std::move(sound));
+            break;
+        }
+        
+        case CommandType::PlayLoop:
+            // Created on first use, looping continuously
+            if (!m_loops[index]) {
+                m_loops[index].emplace(getBuffer(command.sound));
+                m_loops[index]->setLooping(true);
+            }
+            
+            // Resumes from where it left off if paused
+            if (m_loops[index]->getStatus() != sf::Sound::Status::Playing) {
+                m_loops[index]->play();
+            }
+            break;
+        
+        case CommandType::PauseLoop:
+            if (m_loops[index] && m_loops[index]->getStatus() == sf::Sound::Status::Playing) {
+                m_loops[index]->pause();
+            }
+            break;
+        
+        case CommandType::StopLoop:
+            if (m_loops[index]) {
+                m_loops[index]->stop();
+            }
+            break;
+        
+        case CommandType::SetGain:
+            sf::Listener::setGlobalVolume(std::clamp(command.volume, 0.0f, 100.0f));
+            break;
+    }
 }
 
-void AudioManager::update()
+void AudioManager::removeFinishedSounds()
 {
-    // Remove finished sounds
     m_activeSounds.erase(
         std::remove_if(
             m_activeSounds.begin(),
@@ -55,4 +228,14 @@ void AudioManager::update()
         ),
         m_activeSounds.end()
     );
+    
+    std::size_t loops = std::count_if(m_loops.begin(), m_loops.end(), [](const std::optional<sf::Sound>& loop) {
+        return loop && loop->getStatus() == sf::Sound::Status::Playing;
+    });
+    m_activeSoundCount.store(static_cast<std::uint32_t>(m_activeSounds.size() + loops), std::memory_order_relaxed);
+}
+
+sf::SoundBuffer& AudioManager::getBuffer(SoundId sound)
+{
+    return ResourceManager::getInstance().getSoundBuffer(SOUND_FILES[static_cast<std::size_t>(sound)]);
 }
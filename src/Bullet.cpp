@@ -1,33 +1,25 @@
 #include "Bullet.hpp"
+#include "StateArchive.hpp"
 #include <cmath>
 
 Bullet::Bullet(sf::Vector2f position, sf::Vector2f direction)
     : Entity(position, 2.0f)
-    , m_lifetime(BULLET_LIFETIME)
+    , m_expiryTick(0)
 {
     m_type = EntityType::Bullet;
     m_velocity = direction * BULLET_SPEED;
-    
-    m_shape.setRadius(m_radius);
-    m_shape.setFillColor(sf::Color::White);
-    m_shape.setOrigin(sf::Vector2f(m_radius, m_radius));
 }
 
-void Bullet::update(float deltaTime)
+void Bullet::save(StateWriter& out) const
 {
-    move(deltaTime);
-    
-    // Decrease lifetime
-    m_lifetime -= deltaTime;
-    
-    // Set inactive when lifetime expires
-    if (m_lifetime <= 0.0f) {
-        setInactive();
-    }
+    out.write(m_expiryTick);
+    saveMotion(out);
 }
 
-void Bullet::render(sf::RenderWindow& window)
+Bullet Bullet::load(StateReader& in)
 {
-    m_shape.setPosition(m_position);
-    window.draw(m_shape);
+    Bullet bullet({0.0f, 0.0f}, {0.0f, 0.0f});
+    in.read(bullet.m_expiryTick);
+    bullet.loadMotion(in);
+    return bullet;
 }
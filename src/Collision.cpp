@@ -1,48 +1,79 @@
 #include "Collision.hpp"
-#include "AudioManager.hpp"
+#include "Profiler.hpp"
 #include <random>
-#include <iostream>
+#include <cmath>
 
-void Collision::checkCollisions(
+CollisionStats Collision::checkCollisions(
     Player& player,
-    std::vector<std::unique_ptr<Bullet>>& bullets,
-    std::vector<std::unique_ptr<Asteroid>>& asteroids,
-    std::vector<std::unique_ptr<Particle>>& particles,
-    int& score
+    SlotMap<Bullet>& bullets,
+    SlotMap<Asteroid>& asteroids,
+    const SpatialIndex& asteroidIndex,
+    SpatialQueryBatch& queries,
+    int& score,
+    const sf::Vector2f& spawnPosition,
+    std::mt19937& rng,
+    GameEventQueue& events,
+    EntityCommandBuffer& commands
 ) {
-    // Check bullet-asteroid collisions
-    for (auto& bullet : bullets) {
-        if (!bullet->isActive()) continue;
+    PROFILE_ZONE("Collision::checkCollisions");
+    
+    CollisionStats stats;
+    
+    // Look up the asteroids overlapping every bullet and the player in one
+    // batch; bullet b's query is ticket b, the player's (if it can be hit)
+    // comes last
+    queries.clear();
+    for (const Bullet& bullet : bullets) {
+        queries.addCircle(bullet.getPosition(), bullet.getRadius());
+    }
+    bool playerVulnerable = !player.isInvulnerable();
+    SpatialQueryBatch::Ticket playerQuery = 0;
+    if (playerVulnerable) {
+        playerQuery = queries.addCircle(player.getPosition(), player.getRadius());
+    }
+    queries.run(asteroidIndex);
+    stats.pairsTested = static_cast<std::uint32_t>(queries.getTestedCount());
+    
+    // Check bullet-asteroid collisions; a bullet hits the closest asteroid
+    // it overlaps that no earlier bullet destroyed
+    for (std::size_t b = 0; b < bullets.size(); ++b) {
+        Bullet& bullet = bullets[b];
+        if (!bullet.isActive()) continue;
         
-        for (auto& asteroid : asteroids) {
-            if (!asteroid->isActive()) continue;
+        for (const SpatialHit& hit : queries.getHits(b)) {
+            Asteroid* asteroid = asteroids.get(hit.handle);
+            if (!asteroid || !asteroid->isActive()) continue;
             
-            if (bullet->collidesWith(*asteroid)) {
-                handleBulletAsteroidCollision(*bullet, *asteroid, asteroids, particles, score);
-                break; // A bullet can only hit one asteroid
-            }
+            stats.hits++;
+            handleBulletAsteroidCollision(bullet, *asteroid, score, events);
+            splitAsteroid(*asteroid, rng, commands);
+            commands.despawnBullet(bullets.handleAt(b));
+            commands.despawnAsteroid(hit.handle);
+            break; // A bullet can only hit one asteroid
         }
     }
     
     // Check player-asteroid collisions (only if player is not invulnerable)
-    if (!player.isInvulnerable()) {
-        for (auto& asteroid : asteroids) {
-            if (!asteroid->isActive()) continue;
+    if (playerVulnerable) {
+        for (const SpatialHit& hit : queries.getHits(playerQuery)) {
+            Asteroid* asteroid = asteroids.get(hit.handle);
+            if (!asteroid || !asteroid->isActive()) continue;
             
-            if (player.collidesWith(*asteroid)) {
-                handlePlayerAsteroidCollision(player, *asteroid, particles);
-                break; // Only handle one collision per frame for player
-            }
+            stats.hits++;
+            handlePlayerAsteroidCollision(player, *asteroid, spawnPosition, events);
+            commands.despawnAsteroid(hit.handle);
+            break; // Only handle one collision per frame for player
         }
     }
+    
+    return stats;
 }
 
 void Collision::handleBulletAsteroidCollision(
     Bullet& bullet,
     Asteroid& asteroid,
-    std::vector<std::unique_ptr<Asteroid>>& asteroids,
-    std::vector<std::unique_ptr<Particle>>& particles,
-    int& score
+    int& score,
+    GameEventQueue& events
 ) {
     // Deactivate the bullet
     bullet.setInactive();
@@ -50,90 +81,55 @@ void Collision::handleBulletAsteroidCollision(
     // Add score
     score += asteroid.getPoints();
     
-    // Create smaller asteroids if not already the smallest size
-    if (asteroid.getSize() != AsteroidSize::Small) {
-        AsteroidSize newSize = (asteroid.getSize() == AsteroidSize::Large) 
-            ? AsteroidSize::Medium 
-            : AsteroidSize::Small;
-        
-        // Create two smaller asteroids
-        for (int i = 0; i < 2; ++i) {
-            // Random direction offset
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159f);
-            
-            float angle = angleDist(gen);
-            sf::Vector2f offset(std::cos(angle) * 10.0f, std::sin(angle) * 10.0f);
-            
-            asteroids.push_back(std::make_unique<Asteroid>(
-                asteroid.getPosition() + offset, 
-                newSize
-            ));
-        }
+    // Report the kill
+    events.push(GameEventType::AsteroidDestroyed, asteroid.getPosition(), asteroid.getSize());
+    
+    // Deactivate the asteroid
+    asteroid.setInactive();
+}
+
+void Collision::splitAsteroid(
+    const Asteroid& asteroid,
+    std::mt19937& rng,
+    EntityCommandBuffer& commands
+) {
+    // The smallest asteroids just disappear
+    if (asteroid.getSize() == AsteroidSize::Small) {
+        return;
     }
     
-    // Create explosion particles
-    createExplosionParticles(asteroid.getPosition(), particles);
+    AsteroidSize newSize = (asteroid.getSize() == AsteroidSize::Large) 
+        ? AsteroidSize::Medium 
+        : AsteroidSize::Small;
     
-    // Play explosion sound depending on asteroid size
-    if (asteroid.getSize() == AsteroidSize::Small){
-        std::cout << "SMALL collision detected" << std::endl;
-        AudioManager::getInstance().playSound("explosion_small.wav");
-    }
-    else if (asteroid.getSize() == AsteroidSize::Medium){
-        std::cout << "MEDIUM collision detected" << std::endl;
-        AudioManager::getInstance().playSound("explosion_medium.wav");
-    }
-    else {
-        std::cout << "LARGE collision detected" << std::endl;
-        AudioManager::getInstance().playSound("explosion_medium.wav");
+    // Create two smaller asteroids
+    for (int i = 0; i < 2; ++i) {
+        // Random direction offset
+        std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159f);
+        
+        float angle = angleDist(rng);
+        sf::Vector2f offset(std::cos(angle) * 10.0f, std::sin(angle) * 10.0f);
+        
+        commands.spawnAsteroid(asteroid.getPosition() + offset, newSize);
     }
-    
-    // Deactivate the asteroid
-    asteroid.setInactive();
 }
 
 void Collision::handlePlayerAsteroidCollision(
     Player& player,
     Asteroid& asteroid,
-    std::vector<std::unique_ptr<Particle>>& particles
+    const sf::Vector2f& spawnPosition,
+    GameEventQueue& events
 ) {
     // Player is hit
     player.hit();
     player.decreaseLives();
     
-    // Create explosion particles at player position
-    createExplosionParticles(player.getPosition(), particles, sf::Color::Red);
-    
-    // Play explosion sound
-    AudioManager::getInstance().playSound("explosion.wav");
+    // Report the hit (where the player was, for the explosion)
+    events.push(GameEventType::PlayerHit, player.getPosition());
     
     // Deactivate the asteroid that hit the player
     asteroid.setInactive();
     
     // Reset player position (with invulnerability)
-    player.reset();
-}
-
-
-void Collision::createExplosionParticles(
-    sf::Vector2f position,
-    std::vector<std::unique_ptr<Particle>>& particles,
-    sf::Color color,
-    int count
-) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159f);
-    std::uniform_real_distribution<float> speedDist(PARTICLE_SPEED_MIN, PARTICLE_SPEED_MAX);
-    
-    for (int i = 0; i < count; ++i) {
-        float angle = angleDist(gen);
-        float speed = speedDist(gen);
-        
-        sf::Vector2f velocity(std::cos(angle) * speed, std::sin(angle) * speed);
-        
-        particles.push_back(std::make_unique<Particle>(position, velocity, color));
-    }
+    player.reset(spawnPosition);
 }
@@ -1,4 +1,6 @@
 #include "Entity.hpp"
+#include "MotionKernel.hpp"
+#include "StateArchive.hpp"
 #include <cmath>
 
 Entity::Entity(sf::Vector2f position, float radius)
@@ -11,35 +13,15 @@ Entity::Entity(sf::Vector2f position, float radius)
 {
 }
 
-bool Entity::isActive() const
-{
-    return m_active;
-}
-
-void Entity::setInactive()
-{
-    m_active = false;
-}
-
-sf::Vector2f Entity::getPosition() const
-{
-    return m_position;
-}
-
-float Entity::getRadius() const
-{
-    return m_radius;
-}
-
 EntityType Entity::getType() const
 {
     return m_type;
 }
 
-void Entity::move(float deltaTime)
+void Entity::move(float deltaTime, const sf::Vector2f& worldSize)
 {
     m_position += m_velocity * deltaTime;
-    wrapAroundScreen();
+    wrapAroundScreen(worldSize);
 }
 
 bool Entity::collidesWith(const Entity& other) const
@@ -52,17 +34,23 @@ bool Entity::collidesWith(const Entity& other) const
     return distance < (m_radius + other.m_radius);
 }
 
-void Entity::wrapAroundScreen()
+void Entity::wrapAroundScreen(const sf::Vector2f& worldSize)
 {
-    if (m_position.x < 0) {
-        m_position.x = WINDOW_WIDTH;
-    } else if (m_position.x > WINDOW_WIDTH) {
-        m_position.x = 0;
-    }
-    
-    if (m_position.y < 0) {
-        m_position.y = WINDOW_HEIGHT;
-    } else if (m_position.y > WINDOW_HEIGHT) {
-        m_position.y = 0;
-    }
+    // Same arithmetic as the batch kernels, so both agree to the bit
+    m_position.x = MotionKernel::wrap(m_position.x, worldSize.x);
+    m_position.y = MotionKernel::wrap(m_position.y, worldSize.y);
+}
+
+void Entity::saveMotion(StateWriter& out) const
+{
+    out.write(m_position);
+    out.write(m_velocity);
+    out.write(m_rotation);
+}
+
+void Entity::loadMotion(StateReader& in)
+{
+    in.read(m_position);
+    in.read(m_velocity);
+    in.read(m_rotation);
 }
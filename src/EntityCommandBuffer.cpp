@@ -0,0 +1,131 @@
+#include "EntityCommandBuffer.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+
+namespace {
+
+// Lifetime tick an entity spawned now and living for some seconds expires on
+std::uint32_t getExpiryTick(const TimingWheel& wheel, float lifetime)
+{
+    return wheel.getTick() + static_cast<std::uint32_t>(std::ceil(lifetime * LIFETIME_TICKS_PER_SECOND));
+}
+
+// Remove every entity behind the handles; stale handles are skipped
+template <typename T>
+void eraseAll(SlotMap<T>& map, const std::vector<SlotHandle>& handles)
+{
+    for (const SlotHandle& handle : handles) {
+        map.erase(handle);
+    }
+}
+
+// At most every live entity can be despawned in one tick, so keep room for
+// that and the tick everything dies at once doesn't allocate
+template <typename T>
+void reserveDespawns(std::vector<SlotHandle>& handles, const SlotMap<T>& map)
+{
+    if (handles.capacity() < map.size()) {
+        handles.reserve(map.size());
+    }
+}
+
+}
+
+void EntityCommandBuffer::reserve(std::size_t asteroids, std::size_t bullets, std::size_t particles)
+{
+    m_asteroidSpawns.reserve(asteroids);
+    m_bulletSpawns.reserve(bullets);
+    m_particleSpawns.reserve(particles);
+    m_asteroidDespawns.reserve(asteroids);
+    m_bulletDespawns.reserve(bullets);
+    m_particleDespawns.reserve(particles);
+}
+
+void EntityCommandBuffer::spawnAsteroid(sf::Vector2f position, AsteroidSize size)
+{
+    m_asteroidSpawns.push_back({position, size});
+}
+
+void EntityCommandBuffer::spawnBullet(sf::Vector2f position, sf::Vector2f direction)
+{
+    m_bulletSpawns.push_back({position, direction});
+}
+
+void EntityCommandBuffer::spawnParticle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, float lifetimeScale)
+{
+    m_particleSpawns.push_back({position, velocity, color, lifetimeScale});
+}
+
+void EntityCommandBuffer::despawnAsteroid(SlotHandle handle)
+{
+    m_asteroidDespawns.push_back(handle);
+}
+
+void EntityCommandBuffer::despawnBullet(SlotHandle handle)
+{
+    m_bulletDespawns.push_back(handle);
+}
+
+void EntityCommandBuffer::despawnParticle(SlotHandle handle)
+{
+    m_particleDespawns.push_back(handle);
+}
+
+void EntityCommandBuffer::apply(SlotMap<Asteroid>& asteroids, SlotMap<Bullet>& bullets, SlotMap<Particle>& particles,
+                                std::mt19937& rng, std::mt19937& effectsRng,
+                                TimingWheel& bulletExpiry, TimingWheel& particleExpiry)
+{
+    PROFILE_ZONE("EntityCommandBuffer::apply");
+    
+    // Despawns first, so spawns can take the slots they free
+    eraseAll(asteroids, m_asteroidDespawns);
+    eraseAll(bullets, m_bulletDespawns);
+    eraseAll(particles, m_particleDespawns);
+    
+    for (const AsteroidSpawn& spawn : m_asteroidSpawns) {
+        asteroids.emplace(spawn.position, spawn.size, rng);
+    }
+    for (const BulletSpawn& spawn : m_bulletSpawns) {
+        SlotHandle handle = bullets.emplace(spawn.position, spawn.direction);
+        Bullet& bullet = *bullets.get(handle);
+        bullet.setExpiryTick(getExpiryTick(bulletExpiry, BULLET_LIFETIME));
+        bulletExpiry.schedule(handle, bullet.getExpiryTick());
+    }
+    for (const ParticleSpawn& spawn : m_particleSpawns) {
+        SlotHandle handle = particles.emplace(spawn.position, spawn.velocity, spawn.color, effectsRng, spawn.lifetimeScale);
+        Particle& particle = *particles.get(handle);
+        particle.setExpiryTick(getExpiryTick(particleExpiry, particle.getLifetime()));
+        particleExpiry.schedule(handle, particle.getExpiryTick());
+    }
+    
+    clear();
+    
+    reserveDespawns(m_asteroidDespawns, asteroids);
+    reserveDespawns(m_bulletDespawns, bullets);
+    reserveDespawns(m_particleDespawns, particles);
+}
+
+void EntityCommandBuffer::clear()
+{
+    m_asteroidSpawns.clear();
+    m_bulletSpawns.clear();
+    m_particleSpawns.clear();
+    m_asteroidDespawns.clear();
+    m_bulletDespawns.clear();
+    m_particleDespawns.clear();
+}
+
+bool EntityCommandBuffer::empty() const
+{
+    return getSpawnCount() == 0 && getDespawnCount() == 0;
+}
+
+std::size_t EntityCommandBuffer::getSpawnCount() const
+{
+    return m_asteroidSpawns.size() + m_bulletSpawns.size() + m_particleSpawns.size();
+}
+
+std::size_t EntityCommandBuffer::getDespawnCount() const
+{
+    return m_asteroidDespawns.size() + m_bulletDespawns.size() + m_particleDespawns.size();
+}
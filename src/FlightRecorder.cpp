@@ -0,0 +1,427 @@
+#include "FlightRecorder.hpp"
+#include "Profiler.hpp"
+#include "Simulation.hpp"
+#include "StateArchive.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#define FLIGHT_RECORDER_POSIX
+#endif
+
+namespace {
+
+constexpr std::uint32_t DUMP_MAGIC = 0x52464641u;  // "AFFR"
+constexpr std::uint32_t DUMP_VERSION = 3;
+constexpr std::size_t REASON_SIZE = 128;
+
+struct DumpHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t seed;
+    float worldWidth;
+    float worldHeight;
+    std::uint64_t tickCount;        // Records following the header
+    std::uint64_t keyframeCount;    // Keyframes following the records
+    std::uint64_t droppedKeyframes; // Saves that found no memory for the state
+    char reason[REASON_SIZE];
+};
+
+// In front of each keyframe's state, which is followed by the slot's
+// sequence again: the keyframe is whole if both are the same and even
+struct KeyframeHeader {
+    std::uint64_t tick;
+    std::uint64_t size;             // Bytes of state, 0 if there is none
+    std::uint32_t sequence;
+    std::uint32_t padding;
+};
+
+// Input bits of packInput()
+enum InputBit : std::uint8_t {
+    INPUT_THRUST = 1u << 0,
+    INPUT_ROTATE_LEFT = 1u << 1,
+    INPUT_ROTATE_RIGHT = 1u << 2,
+    INPUT_FIRE = 1u << 3
+};
+
+// Static so a signal handler finds it without following any pointer that
+// might be what broke
+std::array<FlightRecorder::TickRecord, FlightRecorder::CAPACITY> g_ring;
+std::atomic<std::uint64_t> g_recorded{0};   // Ticks recorded since begin()
+std::atomic<bool> g_begun{false};
+std::uint32_t g_seed = 0;
+float g_worldWidth = 0.0f;
+float g_worldHeight = 0.0f;
+char g_path[64] = "";
+std::atomic<std::uint64_t> g_droppedKeyframes{0};
+
+// Written like a Seqlock: the sequence is odd while the state is being
+// saved, so a dump racing a save can tell its copy is torn. The buffer a
+// slot outgrew is kept until it grows again, so a dump that picked it up
+// just before never reads freed memory
+struct KeyframeSlot {
+    std::atomic<std::uint32_t> sequence{0};
+    std::uint64_t tick = 0;
+    std::uint64_t size = 0;
+    std::size_t capacity = 0;
+    std::atomic<const std::uint8_t*> state{nullptr};
+    std::unique_ptr<std::uint8_t[]> buffer;
+    std::unique_ptr<std::uint8_t[]> retired;
+};
+
+std::array<KeyframeSlot, FlightRecorder::KEYFRAME_SLOTS> g_keyframes;
+
+// A slot's sequence, tick and size as they are now, with no state while
+// it is being saved
+KeyframeHeader readKeyframeHeader(const KeyframeSlot& slot)
+{
+    KeyframeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.sequence = slot.sequence.load(std::memory_order_acquire);
+    if (!(header.sequence & 1u)) {
+        header.tick = slot.tick;
+        header.size = std::min<std::uint64_t>(slot.size, slot.capacity);
+    }
+    return header;
+}
+
+// Give a slot a buffer of this many bytes; false if there's no memory for it
+bool growKeyframeSlot(KeyframeSlot& slot, std::size_t capacity)
+{
+    std::uint8_t* buffer = new (std::nothrow) std::uint8_t[capacity];
+    if (!buffer) {
+        return false;
+    }
+    slot.retired = std::move(slot.buffer);
+    slot.buffer.reset(buffer);
+    slot.capacity = capacity;
+    slot.state.store(buffer, std::memory_order_release);
+    return true;
+}
+
+#if defined(FLIGHT_RECORDER_POSIX)
+// Write all of a buffer, retrying short writes
+bool writeAll(int fd, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+// Room to handle a SIGSEGV caused by running out of stack. Each thread needs
+// its own; it is given back to the system when the thread ends
+constexpr std::size_t SIGNAL_STACK_SIZE = 64 * 1024;
+
+struct ThreadSignalStack {
+    std::unique_ptr<char[]> memory;
+    
+    ~ThreadSignalStack()
+    {
+        if (memory) {
+            stack_t disable;
+            std::memset(&disable, 0, sizeof(disable));
+            disable.ss_flags = SS_DISABLE;
+            ::sigaltstack(&disable, nullptr);
+        }
+    }
+};
+
+thread_local ThreadSignalStack t_signalStack;
+
+const char* getSignalName(int signal)
+{
+    switch (signal) {
+        case SIGSEGV: return "SIGSEGV";
+        case SIGABRT: return "SIGABRT";
+        case SIGFPE: return "SIGFPE";
+        case SIGILL: return "SIGILL";
+        case SIGBUS: return "SIGBUS";
+        default: return "signal";
+    }
+}
+
+void onFatalSignal(int signal)
+{
+    // Only async-signal-safe calls from here on
+    const char* name = getSignalName(signal);
+    if (FlightRecorder::dump(name)) {
+        const char message[] = "Flight recorder dumped to ";
+        writeAll(STDERR_FILENO, message, sizeof(message) - 1);
+        writeAll(STDERR_FILENO, g_path, std::strlen(g_path));
+        writeAll(STDERR_FILENO, "\n", 1);
+    }
+    
+    // The handler was reset on entry, so this ends the process the way the
+    // signal would have (core dump included)
+    ::raise(signal);
+}
+#endif
+
+}
+
+namespace FlightRecorder {
+
+void begin(std::uint32_t seed, float worldWidth, float worldHeight)
+{
+    g_seed = seed;
+    g_worldWidth = worldWidth;
+    g_worldHeight = worldHeight;
+    g_recorded.store(0, std::memory_order_relaxed);
+    g_droppedKeyframes.store(0, std::memory_order_relaxed);
+    for (KeyframeSlot& slot : g_keyframes) {
+        slot.size = 0;
+        if (slot.capacity < KEYFRAME_BYTES) {
+            growKeyframeSlot(slot, KEYFRAME_BYTES);
+        }
+    }
+    
+    long pid = 0;
+#if defined(FLIGHT_RECORDER_POSIX)
+    pid = static_cast<long>(::getpid());
+#endif
+    std::snprintf(g_path, sizeof(g_path), "crash-%lld-%ld.flight", static_cast<long long>(std::time(nullptr)), pid);
+    g_begun.store(true, std::memory_order_release);
+}
+
+void record(const TickRecord& record)
+{
+    std::uint64_t index = g_recorded.load(std::memory_order_relaxed);
+    TickRecord& slot = g_ring[index % CAPACITY];
+    slot = record;
+    slot.tick = index + 1;
+    
+    // A dump only reads records published here, so at worst it sees the
+    // slot being overwritten as its old or a half-written new tick
+    g_recorded.store(index + 1, std::memory_order_release);
+}
+
+void recordKeyframe(const Simulation& simulation)
+{
+    std::uint64_t tick = g_recorded.load(std::memory_order_relaxed);
+    if (tick == 0 || tick % KEYFRAME_INTERVAL != 0) {
+        return;
+    }
+    
+    PROFILE_ZONE("FlightRecorder::recordKeyframe");
+    
+    KeyframeSlot& slot = g_keyframes[(tick / KEYFRAME_INTERVAL) % KEYFRAME_SLOTS];
+    std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    StateWriter out(slot.buffer.get(), slot.capacity);
+    simulation.saveState(out);
+    
+    // A state that outgrew the slot is saved again into a buffer with a
+    // quarter to spare, which the following keyframes then fit in
+    if (!out.isComplete() && growKeyframeSlot(slot, out.size() + out.size() / 4)) {
+        out = StateWriter(slot.buffer.get(), slot.capacity);
+        simulation.saveState(out);
+    }
+    if (!out.isComplete()) {
+        g_droppedKeyframes.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot.tick = tick;
+    slot.size = out.isComplete() ? out.size() : 0;
+    
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool dump(const char* reason)
+{
+    if (!g_begun.load(std::memory_order_acquire)) {
+        return false;
+    }
+    
+    std::uint64_t recorded = g_recorded.load(std::memory_order_acquire);
+    
+    // Oldest first: once the ring has wrapped, from the next slot to be
+    // overwritten to the end, then from the start up to that slot
+    std::size_t firstCount = static_cast<std::size_t>(recorded);
+    std::size_t secondCount = 0;
+    if (recorded > CAPACITY) {
+        secondCount = static_cast<std::size_t>(recorded % CAPACITY);
+        firstCount = CAPACITY - secondCount;
+    }
+    const TickRecord* first = g_ring.data() + (recorded > CAPACITY ? secondCount : 0);
+    
+    DumpHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = DUMP_MAGIC;
+    header.version = DUMP_VERSION;
+    header.recordSize = sizeof(TickRecord);
+    header.seed = g_seed;
+    header.worldWidth = g_worldWidth;
+    header.worldHeight = g_worldHeight;
+    header.tickCount = firstCount + secondCount;
+    header.keyframeCount = KEYFRAME_SLOTS;
+    header.droppedKeyframes = g_droppedKeyframes.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; reason && reason[i] != '\0' && i + 1 < REASON_SIZE; ++i) {
+        header.reason[i] = reason[i];
+    }
+
+#if defined(FLIGHT_RECORDER_POSIX)
+    int fd = ::open(g_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = writeAll(fd, &header, sizeof(header)) &&
+                   writeAll(fd, first, firstCount * sizeof(TickRecord)) &&
+                   writeAll(fd, g_ring.data(), secondCount * sizeof(TickRecord));
+    for (const KeyframeSlot& slot : g_keyframes) {
+        KeyframeHeader keyframe = readKeyframeHeader(slot);
+        written = written && writeAll(fd, &keyframe, sizeof(keyframe)) &&
+                  writeAll(fd, slot.state.load(std::memory_order_acquire), static_cast<std::size_t>(keyframe.size));
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint32_t after = slot.sequence.load(std::memory_order_relaxed);
+        written = written && writeAll(fd, &after, sizeof(after));
+    }
+    return ::close(fd) == 0 && written;
+#else
+    std::FILE* file = std::fopen(g_path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(first, sizeof(TickRecord), firstCount, file) == firstCount &&
+                   std::fwrite(g_ring.data(), sizeof(TickRecord), secondCount, file) == secondCount;
+    for (const KeyframeSlot& slot : g_keyframes) {
+        KeyframeHeader keyframe = readKeyframeHeader(slot);
+        written = written && std::fwrite(&keyframe, sizeof(keyframe), 1, file) == 1 &&
+                  std::fwrite(slot.state.load(std::memory_order_acquire), 1,
+                              static_cast<std::size_t>(keyframe.size), file) == keyframe.size;
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint32_t after = slot.sequence.load(std::memory_order_relaxed);
+        written = written && std::fwrite(&after, sizeof(after), 1, file) == 1;
+    }
+    return std::fclose(file) == 0 && written;
+#endif
+}
+
+const char* getDumpPath()
+{
+    return g_path;
+}
+
+void installSignalHandlers()
+{
+#if defined(FLIGHT_RECORDER_POSIX)
+    installThreadStack();
+    
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onFatalSignal;
+    action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    
+    for (int signal : {SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS}) {
+        ::sigaction(signal, &action, nullptr);
+    }
+#endif
+}
+
+void installThreadStack()
+{
+#if defined(FLIGHT_RECORDER_POSIX)
+    if (t_signalStack.memory) {
+        return;
+    }
+    
+    t_signalStack.memory.reset(new char[SIGNAL_STACK_SIZE]);
+    stack_t stack;
+    std::memset(&stack, 0, sizeof(stack));
+    stack.ss_sp = t_signalStack.memory.get();
+    stack.ss_size = SIGNAL_STACK_SIZE;
+    ::sigaltstack(&stack, nullptr);
+#endif
+}
+
+bool load(const std::string& path, Dump& dump)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const std::uint64_t fileSize = file ? static_cast<std::uint64_t>(file.tellg()) : 0;
+    file.seekg(0);
+    
+    DumpHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != DUMP_MAGIC || header.version != DUMP_VERSION ||
+        header.recordSize != sizeof(TickRecord) || header.tickCount > CAPACITY) {
+        return false;
+    }
+    
+    dump.seed = header.seed;
+    dump.worldWidth = header.worldWidth;
+    dump.worldHeight = header.worldHeight;
+    dump.droppedKeyframes = header.droppedKeyframes;
+    dump.reason.assign(header.reason, std::find(header.reason, header.reason + REASON_SIZE, '\0'));
+    dump.ticks.resize(static_cast<std::size_t>(header.tickCount));
+    if (!file.read(reinterpret_cast<char*>(dump.ticks.data()),
+                   static_cast<std::streamsize>(dump.ticks.size() * sizeof(TickRecord)))) {
+        return false;
+    }
+    
+    // Keyframes a save was still writing, or that were never written, are dropped
+    dump.keyframes.clear();
+    for (std::uint64_t i = 0; i < header.keyframeCount && i < KEYFRAME_SLOTS; ++i) {
+        KeyframeHeader keyframe;
+        std::uint32_t after = 0;
+        std::vector<std::uint8_t> state;
+        if (!file.read(reinterpret_cast<char*>(&keyframe), sizeof(keyframe)) ||
+            keyframe.size > fileSize - static_cast<std::uint64_t>(file.tellg())) {
+            return false;
+        }
+        state.resize(static_cast<std::size_t>(keyframe.size));
+        if (!file.read(reinterpret_cast<char*>(state.data()), static_cast<std::streamsize>(state.size())) ||
+            !file.read(reinterpret_cast<char*>(&after), sizeof(after))) {
+            return false;
+        }
+        if (keyframe.size > 0 && keyframe.sequence == after && !(after & 1u)) {
+            dump.keyframes.push_back({keyframe.tick, std::move(state)});
+        }
+    }
+    std::sort(dump.keyframes.begin(), dump.keyframes.end(), [](const Keyframe& a, const Keyframe& b) {
+        return a.tick < b.tick;
+    });
+    return true;
+}
+
+std::uint8_t packInput(const PlayerInput& input)
+{
+    return static_cast<std::uint8_t>((input.thrust ? INPUT_THRUST : 0) |
+                                     (input.rotateLeft ? INPUT_ROTATE_LEFT : 0) |
+                                     (input.rotateRight ? INPUT_ROTATE_RIGHT : 0) |
+                                     (input.fire ? INPUT_FIRE : 0));
+}
+
+PlayerInput unpackInput(std::uint8_t bits)
+{
+    PlayerInput input;
+    input.thrust = (bits & INPUT_THRUST) != 0;
+    input.rotateLeft = (bits & INPUT_ROTATE_LEFT) != 0;
+    input.rotateRight = (bits & INPUT_ROTATE_RIGHT) != 0;
+    input.fire = (bits & INPUT_FIRE) != 0;
+    return input;
+}
+
+}
@@ -0,0 +1,91 @@
+#include "FrameArena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+FrameArena::FrameArena(std::size_t capacity)
+    : m_buffer(new std::byte[capacity])
+    , m_capacity(capacity)
+    , m_offset(0)
+    , m_peak(0)
+    , m_overflowBytes(0)
+    , m_overflowCount(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for (const Overflow& block : m_overflow) {
+        ::operator delete(block.pointer, std::align_val_t(block.alignment));
+    }
+}
+
+void FrameArena::reset()
+{
+    std::size_t used = getUsed();
+    m_peak = std::max(m_peak, used);
+    
+    for (const Overflow& block : m_overflow) {
+        ::operator delete(block.pointer, std::align_val_t(block.alignment));
+    }
+    
+    // Grow so the frame that overflowed would have fit
+    if (!m_overflow.empty()) {
+        m_capacity = std::max(m_capacity * 2, used);
+        m_buffer.reset(new std::byte[m_capacity]);
+        m_overflow.clear();
+    }
+    
+    m_offset = 0;
+    m_overflowBytes = 0;
+}
+
+std::size_t FrameArena::getUsed() const
+{
+    return m_offset + m_overflowBytes;
+}
+
+std::size_t FrameArena::getCapacity() const
+{
+    return m_capacity;
+}
+
+std::size_t FrameArena::getPeak() const
+{
+    return std::max(m_peak, getUsed());
+}
+
+std::size_t FrameArena::getOverflowCount() const
+{
+    return m_overflowCount;
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    // Align relative to the real address, the buffer itself is only new[]-aligned
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(m_buffer.get());
+    std::uintptr_t start = (base + m_offset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    std::size_t end = static_cast<std::size_t>(start - base) + bytes;
+    
+    if (end <= m_capacity) {
+        m_offset = end;
+        return reinterpret_cast<void*>(start);
+    }
+    
+    // Out of space this frame, fall back to the heap until the next reset
+    void* pointer = ::operator new(bytes, std::align_val_t(alignment));
+    m_overflow.push_back({pointer, alignment});
+    m_overflowBytes += bytes;
+    m_overflowCount++;
+    return pointer;
+}
+
+void FrameArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+    // Memory is reclaimed by reset()
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
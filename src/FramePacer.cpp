@@ -0,0 +1,231 @@
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+using Microseconds = std::chrono::duration<float, std::micro>;
+
+// Sleep overshoot never assumed below this, covers scheduler wake-up noise
+constexpr float MIN_SPIN_US = 200.0f;
+
+// How quickly the smoothed overshoot follows new measurements, and how fast
+// an old peak is forgotten (per sleep)
+constexpr float OVERSHOOT_SMOOTHING = 0.1f;
+constexpr float OVERSHOOT_PEAK_DECAY = 0.995f;
+
+constexpr int CALIBRATION_SLEEPS = 12;
+
+}
+
+FramePacer::FramePacer(float targetRate)
+    : m_period(Clock::duration::zero())
+    , m_workTime(Clock::duration::zero())
+    , m_started(false)
+    , m_overshootAverage(MIN_SPIN_US)
+    , m_overshootPeak(MIN_SPIN_US)
+    , m_spinThreshold(std::chrono::microseconds(2000))
+    , m_history{}
+    , m_historyNext(0)
+    , m_historyCount(0)
+    , m_sum(0)
+    , m_sumSquares(0)
+    , m_histogram{}
+{
+    setTargetRate(targetRate);
+    m_sorted.reserve(HISTORY_SIZE);
+}
+
+void FramePacer::setTargetRate(float targetRate)
+{
+    if (targetRate > 0.0f) {
+        m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0f / targetRate));
+    } else {
+        m_period = Clock::duration::zero();
+    }
+    m_deadline = Clock::now() + m_period;
+}
+
+float FramePacer::getTargetRate() const
+{
+    if (m_period == Clock::duration::zero()) {
+        return 0.0f;
+    }
+    return 1.0f / std::chrono::duration<float>(m_period).count();
+}
+
+void FramePacer::calibrate()
+{
+    const auto request = std::chrono::milliseconds(1);
+    
+    for (int i = 0; i < CALIBRATION_SLEEPS; ++i) {
+        auto before = Clock::now();
+        std::this_thread::sleep_for(request);
+        recordOvershoot(Clock::now() - before - request);
+    }
+}
+
+float FramePacer::waitForNextFrame()
+{
+    auto now = Clock::now();
+    
+    if (!m_started) {
+        m_started = true;
+        m_lastFrame = now;
+        m_deadline = now + m_period;
+        return 0.0f;
+    }
+    
+    m_workTime = now - m_lastFrame;
+    
+    if (m_period != Clock::duration::zero()) {
+        if (now - m_deadline > m_period) {
+            // More than a whole frame behind: start a new schedule instead of
+            // rushing out catch-up frames
+            m_deadline = now;
+        } else {
+            waitUntil(m_deadline);
+        }
+        m_deadline += m_period;
+        now = Clock::now();
+    }
+    
+    auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastFrame);
+    m_lastFrame = now;
+    recordFrame(static_cast<std::uint32_t>(std::max<std::int64_t>(frameTime.count(), 0)));
+    
+    return std::chrono::duration<float>(frameTime).count();
+}
+
+void FramePacer::reset()
+{
+    m_started = false;
+    m_workTime = Clock::duration::zero();
+    m_history.fill(0);
+    m_historyNext = 0;
+    m_historyCount = 0;
+    m_sum = 0;
+    m_sumSquares = 0;
+    m_histogram.fill(0);
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline)
+{
+    auto now = Clock::now();
+    
+    // Coarse part: sleep, leaving the expected overshoot as margin
+    if (deadline - now > m_spinThreshold) {
+        auto request = deadline - now - m_spinThreshold;
+        std::this_thread::sleep_for(request);
+        
+        auto woke = Clock::now();
+        recordOvershoot(woke - now - request);
+        now = woke;
+    }
+    
+    // Fine part: spin, giving up the time slice between checks
+    while (now < deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+}
+
+void FramePacer::recordOvershoot(Clock::duration overshoot)
+{
+    float overshootUs = std::max(Microseconds(overshoot).count(), 0.0f);
+    
+    m_overshootAverage += (overshootUs - m_overshootAverage) * OVERSHOOT_SMOOTHING;
+    m_overshootPeak = std::max(overshootUs, m_overshootPeak * OVERSHOOT_PEAK_DECAY);
+    
+    // Spin long enough to absorb the worst recent wake-up, but never the whole frame
+    float thresholdUs = std::max({m_overshootPeak, m_overshootAverage * 2.0f, MIN_SPIN_US});
+    auto threshold = std::chrono::duration_cast<Clock::duration>(Microseconds(thresholdUs));
+    if (m_period != Clock::duration::zero()) {
+        threshold = std::min(threshold, m_period);
+    }
+    m_spinThreshold = threshold;
+}
+
+void FramePacer::recordFrame(std::uint32_t frameTimeUs)
+{
+    auto binOf = [](std::uint32_t us) {
+        return std::min<std::size_t>(us / HISTOGRAM_BIN_US, HISTOGRAM_BINS - 1);
+    };
+    
+    // Drop the sample about to be overwritten
+    if (m_historyCount == HISTORY_SIZE) {
+        std::uint32_t old = m_history[m_historyNext];
+        m_sum -= old;
+        m_sumSquares -= static_cast<std::uint64_t>(old) * old;
+        m_histogram[binOf(old)]--;
+    } else {
+        m_historyCount++;
+    }
+    
+    m_history[m_historyNext] = frameTimeUs;
+    m_historyNext = (m_historyNext + 1) % HISTORY_SIZE;
+    m_sum += frameTimeUs;
+    m_sumSquares += static_cast<std::uint64_t>(frameTimeUs) * frameTimeUs;
+    m_histogram[binOf(frameTimeUs)]++;
+}
+
+std::size_t FramePacer::getSampleCount() const
+{
+    return m_historyCount;
+}
+
+float FramePacer::getMeanFrameTime() const
+{
+    if (m_historyCount == 0) return 0.0f;
+    return static_cast<float>(static_cast<double>(m_sum) / m_historyCount / 1000.0);
+}
+
+float FramePacer::getJitter() const
+{
+    if (m_historyCount < 2) return 0.0f;
+    
+    double mean = static_cast<double>(m_sum) / m_historyCount;
+    double variance = static_cast<double>(m_sumSquares) / m_historyCount - mean * mean;
+    return static_cast<float>(std::sqrt(std::max(variance, 0.0)) / 1000.0);
+}
+
+float FramePacer::getPercentile(float percent) const
+{
+    if (m_historyCount == 0) return 0.0f;
+    
+    m_sorted.assign(m_history.begin(), m_history.begin() + m_historyCount);
+    
+    float clamped = std::min(std::max(percent, 0.0f), 100.0f);
+    std::size_t rank = static_cast<std::size_t>(std::ceil(clamped / 100.0f * m_historyCount));
+    rank = std::min(std::max<std::size_t>(rank, 1), m_historyCount) - 1;
+    
+    std::nth_element(m_sorted.begin(), m_sorted.begin() + rank, m_sorted.end());
+    return m_sorted[rank] / 1000.0f;
+}
+
+float FramePacer::getWorstFrameTime() const
+{
+    if (m_historyCount == 0) return 0.0f;
+    return *std::max_element(m_history.begin(), m_history.begin() + m_historyCount) / 1000.0f;
+}
+
+float FramePacer::getWorkTime() const
+{
+    return std::chrono::duration<float, std::milli>(m_workTime).count();
+}
+
+const std::array<std::uint32_t, FramePacer::HISTOGRAM_BINS>& FramePacer::getHistogram() const
+{
+    return m_histogram;
+}
+
+float FramePacer::getSleepOvershoot() const
+{
+    return m_overshootAverage / 1000.0f;
+}
+
+float FramePacer::getSpinThreshold() const
+{
+    return std::chrono::duration<float, std::milli>(m_spinThreshold).count();
+}
@@ -1,333 +1,639 @@
 #include "Game.hpp"
 #include "ResourceManager.hpp"
 #include "AudioManager.hpp"
-#include "Collision.hpp"
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+#include "StartupTimer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
 #include <iostream>
+#include <random>
+#include <string>
 #include <variant>
 
-Game::Game()
-    : m_window(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), WINDOW_TITLE)
-    , m_deltaTime(0.0f)
-    , m_gameState(GameState::MainMenu)
-    , m_score(0)
-    , m_level(1)
-    , m_levelStartTimer(0.0f)
-    , m_player()
-    , m_ui()
-    , m_spacePressed(false)
-    , m_pPressed(false)
+namespace {
+
+// Clamped to what a flight recorder tick has room for
+std::uint16_t toFlightMicroseconds(FramePacer::Clock::duration duration)
 {
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return static_cast<std::uint16_t>(std::clamp<long long>(microseconds, 0, 0xFFFF));
 }
 
-void Game::init()
+SimulationConfig makeConfig(const sf::Vector2f& worldSize)
 {
-    // Set up window
-    m_window.setFramerateLimit(60);
-    
-    // Initialize resources
-    ResourceManager::getInstance().loadResources();
-    AudioManager::getInstance().initializeSounds();
+    SimulationConfig config;
+    config.worldSize = worldSize;
+    config.seed = std::random_device()();
+    return config;
+}
+
+}
+
+const std::array<Game::KeyBinding, 9> Game::KEY_BINDINGS = {{
+    {sf::Keyboard::Key::Up, KEY_THRUST},
+    {sf::Keyboard::Key::W, KEY_THRUST},
+    {sf::Keyboard::Key::Left, KEY_ROTATE_LEFT},
+    {sf::Keyboard::Key::A, KEY_ROTATE_LEFT},
+    {sf::Keyboard::Key::Right, KEY_ROTATE_RIGHT},
+    {sf::Keyboard::Key::D, KEY_ROTATE_RIGHT},
+    {sf::Keyboard::Key::Space, KEY_SPACE},      // Fire bullet or start game
+    {sf::Keyboard::Key::P, KEY_PAUSE},
+    {sf::Keyboard::Key::F5, KEY_RECORD},        // Start and stop a replay recording
+}};
+
+Game::Game(const GameConfig& config)
+    : m_framePacer(TARGET_FRAME_RATE)
+    , m_deltaTime(0.0f)
+    , m_resolutionScaler(1000.0f / TARGET_FRAME_RATE, config.minResolutionScale, config.maxResolutionScale)
+    , m_qualityGovernor(1000.0f / TARGET_FRAME_RATE)
+    , m_effectsLevel(1.0f)
+    , m_simulationWorkTime(0.0f)
+    , m_frameCount(0)
+    , m_tickCount(0)
+    , m_frameArena(64 * 1024)
+    , m_simulation(makeConfig(config.worldSize))
+    , m_simulationPacer(TARGET_FRAME_RATE)
+    , m_flightTick()
+    , m_simulationRunning(false)
+    , m_ui(m_frameArena)
+    , m_thrustSoundPlaying(false)
+    , m_boundKeysDown(0)
+    , m_inputKeysDown(0)
+    , m_lastPressTime(0)
+    , m_lastShownPressTime(0)
+    , m_showFrameStats(false)
+    , m_traceStart(0)
+    , m_traceCount(0)
+{
+    // Created here rather than in the initializer list so startup can time it
+    {
+        STARTUP_SCOPE("Create window");
+        m_window.create(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), WINDOW_TITLE);
+    }
     
-    // Reset the player
-    m_player.reset();
+    // Every tick from here on can be dumped and replayed from this seed
+    FlightRecorder::begin(m_simulation.getSeed(), config.worldSize.x, config.worldSize.y);
     
-    // Clear entities
-    m_asteroids.clear();
-    m_bullets.clear();
-    m_particles.clear();
+    // Optional: the game runs the same without spectators
+    if (config.spectatePort != 0) {
+        if (m_spectators.start(config.spectatePort)) {
+            std::cout << "Broadcasting to spectators on port " << config.spectatePort << std::endl;
+        } else {
+            std::cerr << "Failed to open spectator port " << config.spectatePort << std::endl;
+        }
+    }
     
-    // Initialize first level
-    initLevel();
+    // Smoothed, so a world drawn at less than full size is filtered rather
+    // than blocky when stretched over the window
+    STARTUP_SCOPE("Create world target");
+    if (m_worldTarget.resize(m_window.getSize())) {
+        m_worldTarget.setSmooth(true);
+        m_worldSprite.emplace(m_worldTarget.getTexture());
+    } else {
+        std::cerr << "Failed to create the world render target, drawing at full resolution" << std::endl;
+    }
+}
+
+Game::~Game()
+{
+    stopSimulation();
+}
+
+void Game::init()
+{
+    // Fonts and sounds load on first use, and the frame pacers calibrate
+    // after the first frame (main) or on their own thread (simulation), so
+    // nothing here stands between startup and the first frame but the
+    // metrics page
+    STARTUP_SCOPE("Game::init");
+    
+    // Optional: the game runs the same without a metrics page
+    if (m_metrics.open()) {
+        std::cout << "Live metrics at " << m_metrics.getName() << std::endl;
+    }
 }
 
 void Game::run()
 {
+    Profiler::setThreadName("main");
     init();
+    AudioManager::getInstance().start();
+    startSimulation();
+    
+    // Ends once the first frame has been handed to the display
+    std::optional<StartupScope> firstFrame(std::in_place, "First frame");
     
-    // Game loop
+    // Render loop, the simulation steps on its own thread meanwhile
     while (m_window.isOpen()) {
-        // Calculate delta time
-        m_deltaTime = m_clock.restart().asSeconds();
+        // Wait for the next frame and get the time since the last one
+        m_deltaTime = m_framePacer.waitForNextFrame();
+        PROFILE_ZONE("Game::run frame");
         
-        // Cap delta time to avoid physics issues
-        if (m_deltaTime > 0.1f) {
-            m_deltaTime = 0.1f;
+        // The two controllers see the same slow frames, so they take turns
+        // instead of both stepping down at once: effects drop first and
+        // resolution only once they are at the floor, and on the way back
+        // resolution recovers before effects rise again
+        bool effectsAtFloor = m_qualityGovernor.getLevel() <= EFFECTS_QUALITY_MIN;
+        bool resolutionFull = !m_worldSprite || m_resolutionScaler.getScale() >= m_resolutionScaler.getMaxScale();
+        
+        // Both threads share the budget; whichever is busier sets the pace
+        float workTime = std::max(m_framePacer.getWorkTime(), m_simulationWorkTime.load(std::memory_order_relaxed));
+        m_qualityGovernor.recordFrame(workTime, resolutionFull);
+        m_effectsLevel.store(m_qualityGovernor.getLevel(), std::memory_order_relaxed);
+        
+        // Resolution only makes the main thread's share of the work cheaper
+        if (m_worldSprite) {
+            m_resolutionScaler.recordFrame(m_framePacer.getWorkTime(), effectsAtFloor);
         }
         
-        // Handle events
+        std::string spikeTrace = Profiler::endFrame(workTime);
+        if (!spikeTrace.empty()) {
+            std::cout << "Saved frame spike trace to " << spikeTrace << std::endl;
+        }
+        
+        // Handle events; keys are stamped with the time they're read
         while (auto event = m_window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
                 m_window.close();
+            } else if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+                handleKey(key->code, true, InputQueue::now());
+            } else if (const auto* key = event->getIf<sf::Event::KeyReleased>()) {
+                handleKey(key->code, false, InputQueue::now());
+            } else if (event->is<sf::Event::FocusLost>()) {
+                // The releases will go to another window
+                setBoundKeys(0, InputQueue::now());
             }
         }
-
-
-        handleInput();
-        update(m_deltaTime);
+        
         render();
+        endFrame();
+        
+        if (firstFrame) {
+            firstFrame.reset();
+            StartupTimer::finish();
+            
+            // Frame rate is paced by m_framePacer, tune its sleeps to this
+            // machine now that there is something on screen
+            m_framePacer.calibrate();
+        }
+        
+        // The simulation thread only stops early if it failed
+        if (!m_simulationRunning.load(std::memory_order_relaxed)) {
+            m_window.close();
+        }
+    }
+    
+    stopSimulation();
+    m_spectators.stop();
+    AudioManager::getInstance().stop();
+    if (m_replayWriter.isOpen()) {
+        toggleReplayRecording();
+    }
+    if (m_simulationError) {
+        std::rethrow_exception(m_simulationError);
     }
+    
+    printAllocationReport();
 }
 
-void Game::handleInput()
+void Game::startSimulation()
 {
-    // Space key (fire bullet or start game)
-    bool spacePressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Space);
-    
-    if (spacePressed && !m_spacePressed) {
-        if (m_gameState == GameState::Playing) {
-            createBullet();
-            AudioManager::getInstance().playSound("fire.wav");
-        } else if (m_gameState == GameState::MainMenu || m_gameState == GameState::GameOver) {
-            resetGame();
-            m_gameState = GameState::Playing;
-        }
-    }
+    // Have something to draw before the first step is published
+    m_simulation.capture(m_snapshots.getWriteBuffer());
+    m_snapshots.publish();
     
-    m_spacePressed = spacePressed;
+    m_simulationRunning.store(true);
+    m_simulationThread = std::thread(&Game::runSimulation, this);
+}
+
+void Game::stopSimulation()
+{
+    m_simulationRunning.store(false);
+    if (m_simulationThread.joinable()) {
+        m_simulationThread.join();
+    }
+}
+
+void Game::runSimulation()
+{
+    Profiler::setThreadName("simulation");
+    FlightRecorder::installThreadStack();
     
-    // P key (pause/unpause)
-    bool pPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::P);
+    // Tune this thread's sleeps while the main thread gets the first frame out
+    m_simulationPacer.calibrate();
     
-    if (pPressed && !m_pPressed) {
-        if (m_gameState == GameState::Playing) {
-            m_gameState = GameState::Paused;
-        } else if (m_gameState == GameState::Paused) {
-            m_gameState = GameState::Playing;
+    try {
+        while (m_simulationRunning.load(std::memory_order_relaxed)) {
+            // Cap delta time to avoid physics issues
+            float deltaTime = std::min(m_simulationPacer.waitForNextFrame(), 0.1f);
+            m_simulationWorkTime.store(m_simulationPacer.getWorkTime(), std::memory_order_relaxed);
+            
+            float effectsLevel = m_effectsLevel.load(std::memory_order_relaxed);
+            m_simulation.setEffectsQuality(EffectsQuality::fromLevel(effectsLevel));
+            
+            FramePacer::Clock::time_point updateStart = FramePacer::Clock::now();
+            m_flightTick = FlightRecorder::TickRecord();
+            update(deltaTime);
+            
+            FramePacer::Clock::time_point captureStart = FramePacer::Clock::now();
+            FrameSnapshot& snapshot = m_snapshots.getWriteBuffer();
+            m_simulation.capture(snapshot);
+            snapshot.inputTime = m_lastPressTime;
+            if (m_replayWriter.isOpen()) {
+                m_replayWriter.write(snapshot, m_simulationPacer.getWorkTime());
+            }
+            if (m_spectators.isRunning()) {
+                m_spectators.publish(snapshot);
+            }
+            
+            FramePacer::Clock::time_point publishStart = FramePacer::Clock::now();
+            m_snapshots.publish();
+            publishSimulationMetrics();
+            
+            m_flightTick.deltaTime = deltaTime;
+            m_flightTick.effectsLevel = effectsLevel;
+            m_flightTick.updateUs = toFlightMicroseconds(captureStart - updateStart);
+            m_flightTick.captureUs = toFlightMicroseconds(publishStart - captureStart);
+            m_flightTick.publishUs = toFlightMicroseconds(FramePacer::Clock::now() - publishStart);
+            recordFlightTick();
         }
+    } catch (...) {
+        m_simulationError = std::current_exception();
+        m_simulationRunning.store(false);
     }
-    
-    m_pPressed = pPressed;
 }
 
-void Game::update(float deltaTime)
+void Game::handleKey(sf::Keyboard::Key key, bool pressed, std::uint64_t time)
 {
-    // Don't update if paused or in menu
-    if (m_gameState != GameState::Playing) {
-        return;
+    std::uint32_t boundKeysDown = m_boundKeysDown;
+    for (std::size_t i = 0; i < KEY_BINDINGS.size(); ++i) {
+        if (KEY_BINDINGS[i].key == key) {
+            boundKeysDown = pressed ? (boundKeysDown | (1u << i)) : (boundKeysDown & ~(1u << i));
+        }
     }
+    setBoundKeys(boundKeysDown, time);
     
-    // Update level start timer
-    if (m_levelStartTimer > 0.0f) {
-        m_levelStartTimer -= deltaTime;
+    if (!pressed) {
         return;
     }
     
-    // Check if all asteroids are destroyed to start next level
-    bool allAsteroidsDestroyed = true;
-    for (const auto& asteroid : m_asteroids) {
-        if (asteroid->isActive()) {
-            allAsteroidsDestroyed = false;
+    switch (key) {
+        // Frame time overlay
+        case sf::Keyboard::Key::F3:
+            m_showFrameStats = !m_showFrameStats;
             break;
+        
+        // Start recording a trace, or save it when pressed again
+        case sf::Keyboard::Key::F9:
+            toggleTraceRecording();
+            break;
+        
+        // Toggle saving the seconds around every frame over budget
+        case sf::Keyboard::Key::F10: {
+            bool enabled = !Profiler::isSpikeCaptureEnabled();
+            Profiler::setSpikeCapture(enabled, 1000.0f / TARGET_FRAME_RATE);
+            std::cout << "Frame spike capture " << (enabled ? "on" : "off") << std::endl;
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+void Game::setBoundKeys(std::uint32_t boundKeysDown, std::uint64_t time)
+{
+    std::uint32_t inputKeysDown = 0;
+    for (std::size_t i = 0; i < KEY_BINDINGS.size(); ++i) {
+        if (boundKeysDown & (1u << i)) {
+            inputKeysDown |= KEY_BINDINGS[i].inputKey;
         }
     }
     
-    if (allAsteroidsDestroyed) {
-        m_level++;
-        initLevel();
+    // Only real changes: key repeats, and W going down while Up is already
+    // held, send nothing
+    m_input.push(inputKeysDown & ~m_inputKeysDown, true, time);
+    m_input.push(m_inputKeysDown & ~inputKeysDown, false, time);
+    
+    m_boundKeysDown = boundKeysDown;
+    m_inputKeysDown = inputKeysDown;
+}
+
+void Game::toggleTraceRecording()
+{
+    if (!Profiler::isRecording()) {
+        m_traceStart = Profiler::now();
+        Profiler::setRecording(true);
+        std::cout << "Recording trace (F9 to save)" << std::endl;
         return;
     }
     
-    // Update player
-    m_player.update(deltaTime);
+    // Spike capture needs recording, so it stops too
+    Profiler::setSpikeCapture(false);
+    Profiler::setRecording(false);
+    
+    std::string path = "trace-" + std::to_string(++m_traceCount) + ".json";
+    long zones = Profiler::writeTrace(path, m_traceStart);
+    if (zones < 0) {
+        std::cerr << "Failed to write trace " << path << std::endl;
+    } else {
+        std::cout << "Saved " << zones << " zones to " << path << std::endl;
+    }
+}
+
+PlayerInput Game::consumeInput()
+{
+    InputFrame keys = m_input.drain(InputQueue::now());
+    if (keys.pressed != 0) {
+        m_lastPressTime = keys.lastPressTime;
+    }
     
-    // Update bullets
-    for (auto& bullet : m_bullets) {
-        if (bullet->isActive()) {
-            bullet->update(deltaTime);
+    // A tap that went down and up between two ticks still acts for one tick
+    std::uint32_t held = keys.held | keys.pressed;
+    std::uint32_t pressed = keys.pressed;
+    
+    PlayerInput input;
+    input.thrust = (held & KEY_THRUST) != 0;
+    input.rotateLeft = (held & KEY_ROTATE_LEFT) != 0;
+    input.rotateRight = (held & KEY_ROTATE_RIGHT) != 0;
+    
+    if (pressed & KEY_SPACE) {
+        GameState state = m_simulation.getState();
+        if (state == GameState::Playing) {
+            input.fire = true;
+        } else if (state == GameState::MainMenu || state == GameState::GameOver) {
+            // The menu doesn't make a sound, so sounds wait until a game starts
+            AudioManager::getInstance().preloadSounds();
+            m_simulation.startGame();
+            m_flightTick.actions |= FlightRecorder::ACTION_START_GAME;
         }
     }
     
-    // Update asteroids
-    for (auto& asteroid : m_asteroids) {
-        if (asteroid->isActive()) {
-            asteroid->update(deltaTime);
+    if (pressed & KEY_PAUSE) {
+        m_simulation.togglePause();
+        m_flightTick.actions |= FlightRecorder::ACTION_TOGGLE_PAUSE;
+    }
+    
+    if (pressed & KEY_RECORD) {
+        toggleReplayRecording();
+    }
+    
+    m_flightTick.input = FlightRecorder::packInput(input);
+    return input;
+}
+
+void Game::toggleReplayRecording()
+{
+    if (m_replayWriter.isOpen()) {
+        std::uint64_t ticks = m_replayWriter.getTickCount();
+        if (m_replayWriter.close()) {
+            std::cout << "Saved " << ticks << " ticks to " << m_replayWriter.getPath() << std::endl;
+        } else {
+            std::cerr << "Failed to write replay " << m_replayWriter.getPath() << std::endl;
         }
+        return;
     }
     
-    // Update particles
-    for (auto& particle : m_particles) {
-        if (particle->isActive()) {
-            particle->update(deltaTime);
+    std::string path = "replay-" + std::to_string(std::time(nullptr)) + ".asr";
+    if (m_replayWriter.open(path)) {
+        std::cout << "Recording replay to " << path << " (F5 to stop)" << std::endl;
+    } else {
+        std::cerr << "Failed to create replay " << path << std::endl;
+    }
+}
+
+void Game::update(float deltaTime)
+{
+    PROFILE_ZONE("Game::update");
+    
+    m_simulation.update(consumeInput(), deltaTime);
+    
+    // Only queues commands for the audio thread
+    playEventSounds();
+    updateThrustSound();
+}
+
+void Game::playEventSounds()
+{
+    AudioManager& audio = AudioManager::getInstance();
+    
+    for (const GameEvent& event : m_simulation.getEvents().getEvents()) {
+        switch (event.type) {
+            case GameEventType::BulletFired:
+                audio.queueSound(SoundId::Fire);
+                break;
+            
+            case GameEventType::AsteroidDestroyed:
+                // Explosion sound depends on asteroid size
+                if (event.asteroidSize == AsteroidSize::Small) {
+                    audio.queueSound(SoundId::ExplosionSmall);
+                } else {
+                    audio.queueSound(SoundId::ExplosionMedium);
+                }
+                break;
+            
+            case GameEventType::PlayerHit:
+                audio.queueSound(SoundId::ExplosionSmall);
+                audio.queueSound(SoundId::Explosion);
+                break;
         }
     }
     
-    // Check collisions
-    Collision::checkCollisions(m_player, m_bullets, m_asteroids, m_particles, m_score);
+    // One play per distinct sound, however many asteroids blew up this tick
+    audio.flushQueuedSounds();
+}
+
+void Game::updateThrustSound()
+{
+    bool thrusting = m_simulation.getState() == GameState::Playing &&
+                     m_simulation.getPlayer().isThrusting();
+    if (thrusting == m_thrustSoundPlaying) {
+        return;
+    }
+    
+    // Paused rather than stopped, so it resumes where it left off
+    if (thrusting) {
+        AudioManager::getInstance().playLoop(SoundId::Thrust);
+    } else {
+        AudioManager::getInstance().pauseLoop(SoundId::Thrust);
+    }
+    m_thrustSoundPlaying = thrusting;
+}
+
+void Game::endFrame()
+{
+    m_memoryStats.arenaPeak = m_frameArena.getPeak();
+    m_frameArena.reset();
+    m_memoryStats.arenaCapacity = m_frameArena.getCapacity();
+    
+    // Heap use since the previous endFrame, per subsystem
+    AllocationTracker::Snapshot total = AllocationTracker::capture();
+    for (std::size_t i = 0; i < total.tags.size(); ++i) {
+        m_memoryStats.frame.tags[i].allocations = total.tags[i].allocations - m_memoryStats.total.tags[i].allocations;
+        m_memoryStats.frame.tags[i].bytes = total.tags[i].bytes - m_memoryStats.total.tags[i].bytes;
+    }
+    m_memoryStats.total = total;
     
-    // Clean up inactive entities
-    cleanupEntities();
+    bool allocated = m_memoryStats.frame.total().allocations > 0;
+    m_memoryStats.framesWithoutHeap = allocated ? 0 : m_memoryStats.framesWithoutHeap + 1;
     
-    // Check for game over
-    if (m_player.getLives() <= 0) {
-        m_gameState = GameState::GameOver;
+    // getrusage is a system call, only ask while the overlay shows it
+    if (AllocationTracker::isEnabled() && m_showFrameStats) {
+        m_memoryStats.peakResidentBytes = AllocationTracker::getPeakResidentBytes();
+    }
+}
+
+void Game::printAllocationReport() const
+{
+    if (!AllocationTracker::isEnabled()) {
+        return;
     }
     
-    // Update audio manager to clean up finished sounds
-    AudioManager::getInstance().update();
+    AllocationTracker::Snapshot total = AllocationTracker::capture();
+    std::cout << "Heap allocations by subsystem:" << std::endl;
+    for (std::size_t i = 0; i < total.tags.size(); ++i) {
+        std::cout << "  " << AllocationTracker::getTagName(static_cast<AllocationTag>(i)) << ": "
+                  << total.tags[i].allocations << " allocations, "
+                  << total.tags[i].bytes << " bytes" << std::endl;
+    }
+    std::cout << "Peak heap: " << total.peakLiveBytes << " bytes" << std::endl;
+    std::cout << "Peak resident size: " << AllocationTracker::getPeakResidentBytes() << " bytes" << std::endl;
 }
 
 void Game::render()
 {
+    PROFILE_ZONE("Game::render");
+    AllocationScope allocationScope(AllocationTag::Render);
+    
+    // Pick up the newest step; if none was published the last one is drawn again
+    m_snapshots.update();
+    const FrameSnapshot& snapshot = m_snapshots.getReadBuffer();
+    
     m_window.clear(sf::Color::Black);
     
-    switch (m_gameState) {
+    switch (snapshot.state) {
         case GameState::MainMenu:
             m_ui.renderMainMenu(m_window);
             break;
-            
+        
         case GameState::Playing:
         case GameState::Paused:
-            // Render asteroids
-            for (const auto& asteroid : m_asteroids) {
-                if (asteroid->isActive()) {
-                    asteroid->render(m_window);
-                }
-            }
-            
-            // Render bullets
-            for (const auto& bullet : m_bullets) {
-                if (bullet->isActive()) {
-                    bullet->render(m_window);
-                }
-            }
+        case GameState::GameOver:
+            renderWorld(snapshot);
             
-            // Render particles
-            for (const auto& particle : m_particles) {
-                if (particle->isActive()) {
-                    particle->render(m_window);
-                }
+            if (snapshot.state == GameState::GameOver) {
+                m_ui.renderGameOver(m_window, snapshot.score);
+                break;
             }
             
-            // Render player
-            m_player.render(m_window);
-            
             // Render UI
-            m_ui.renderScore(m_window, m_score);
-            m_ui.renderLives(m_window, m_player.getLives());
-            m_ui.renderLevel(m_window, m_level);
+            m_ui.renderScore(m_window, snapshot.score);
+            m_ui.renderLives(m_window, snapshot.lives);
+            m_ui.renderLevel(m_window, snapshot.level);
             m_ui.renderVelocity(m_window, m_deltaTime);
             
             // Render pause menu if paused
-            if (m_gameState == GameState::Paused) {
+            if (snapshot.state == GameState::Paused) {
                 m_ui.renderPauseMenu(m_window);
             }
             break;
-            
-        case GameState::GameOver:
-            // Still render the game in the background
-            for (const auto& asteroid : m_asteroids) {
-                if (asteroid->isActive()) {
-                    asteroid->render(m_window);
-                }
-            }
-            
-            for (const auto& bullet : m_bullets) {
-                if (bullet->isActive()) {
-                    bullet->render(m_window);
-                }
-            }
-            
-            for (const auto& particle : m_particles) {
-                if (particle->isActive()) {
-                    particle->render(m_window);
-                }
-            }
-            
-            m_ui.renderGameOver(m_window, m_score);
-            break;
+    }
+    
+    if (m_showFrameStats) {
+        m_ui.renderFrameStats(m_window, m_framePacer, m_memoryStats, m_qualityGovernor,
+                              m_worldSprite ? &m_resolutionScaler : nullptr, m_inputLatency,
+                              m_input.getDroppedCount());
     }
     
     m_window.display();
+    recordInputLatency(snapshot);
+    
+    publishRenderMetrics(m_worldRenderer.takeDrawCalls() + m_ui.takeDrawCalls());
 }
 
-void Game::initLevel()
+void Game::renderWorld(const FrameSnapshot& snapshot)
 {
-    // Clear old asteroids
-    m_asteroids.clear();
-    
-    // Number of asteroids based on level
-    int numAsteroids = 4 + (m_level - 1) * 2;
-    numAsteroids = std::min(numAsteroids, 12); // Cap at 12 asteroids
-    
-    // Create asteroids
-    for (int i = 0; i < numAsteroids; ++i) {
-        m_asteroids.push_back(std::make_unique<Asteroid>(
-            Asteroid::createRandom(m_player.getPosition())
-        ));
+    if (!m_worldSprite) {
+        m_worldRenderer.render(m_window, snapshot);
+        return;
     }
     
-    // Set up level start timer
-    m_levelStartTimer = 2.0f;
+    // Only the top-left scale x scale of the target is drawn and shown
+    float scale = m_resolutionScaler.getScale();
+    sf::Vector2u size = m_worldTarget.getSize();
+    sf::Vector2i scaledSize(static_cast<int>(std::lround(size.x * scale)), static_cast<int>(std::lround(size.y * scale)));
+    
+    m_worldTarget.clear(sf::Color::Black);
+    m_worldRenderer.setViewport(sf::FloatRect({0.0f, 0.0f}, {scale, scale}));
+    m_worldRenderer.render(m_worldTarget, snapshot);
+    m_worldTarget.display();
+    
+    {
+        PROFILE_ZONE("Game::renderWorld upscale");
+        m_worldSprite->setTextureRect(sf::IntRect({0, 0}, scaledSize));
+        m_worldSprite->setScale(sf::Vector2f(static_cast<float>(size.x) / scaledSize.x,
+                                             static_cast<float>(size.y) / scaledSize.y));
+        m_window.draw(*m_worldSprite);
+    }
 }
 
-void Game::createBullet()
+void Game::recordFlightTick()
 {
-    if (!m_player.canFire()) {
-        return;
-    }
-    
-    // Get player position and direction
-    sf::Vector2f position = m_player.getPosition();
-    sf::Vector2f direction = m_player.getDirection();
-    
-    // Offset the bullet position to start at the nose of the ship
-    position += direction * 20.0f;
-    
-    // Create the bullet
-    m_bullets.push_back(std::make_unique<Bullet>(position, direction));
-    
-    // Reset player's fire cooldown
-    m_player.updateFireCooldown(FIRE_COOLDOWN);
+    m_flightTick.asteroids = static_cast<std::uint32_t>(m_simulation.getAsteroids().size());
+    m_flightTick.sleepingAsteroids = static_cast<std::uint32_t>(m_simulation.getSleepingAsteroidCount());
+    m_flightTick.bullets = static_cast<std::uint32_t>(m_simulation.getBullets().size());
+    m_flightTick.particles = static_cast<std::uint32_t>(m_simulation.getParticles().size());
+    m_flightTick.score = m_simulation.getScore();
+    m_flightTick.state = static_cast<std::uint8_t>(m_simulation.getState());
+    m_flightTick.lives = static_cast<std::uint8_t>(std::max(m_simulation.getPlayer().getLives(), 0));
+    FlightRecorder::record(m_flightTick);
+    FlightRecorder::recordKeyframe(m_simulation);
 }
 
-void Game::cleanupEntities()
+void Game::publishSimulationMetrics()
 {
-    // Remove inactive bullets
-    m_bullets.erase(
-        std::remove_if(
-            m_bullets.begin(),
-            m_bullets.end(),
-            [](const std::unique_ptr<Bullet>& bullet) {
-                return !bullet->isActive();
-            }
-        ),
-        m_bullets.end()
-    );
-    
-    // Remove inactive asteroids
-    m_asteroids.erase(
-        std::remove_if(
-            m_asteroids.begin(),
-            m_asteroids.end(),
-            [](const std::unique_ptr<Asteroid>& asteroid) {
-                return !asteroid->isActive();
-            }
-        ),
-        m_asteroids.end()
-    );
-    
-    // Remove inactive particles
-    m_particles.erase(
-        std::remove_if(
-            m_particles.begin(),
-            m_particles.end(),
-            [](const std::unique_ptr<Particle>& particle) {
-                return !particle->isActive();
-            }
-        ),
-        m_particles.end()
-    );
+    const CollisionStats& collisions = m_simulation.getCollisionStats();
+    
+    SimulationMetrics metrics;
+    metrics.tick = ++m_tickCount;
+    metrics.state = static_cast<std::int32_t>(m_simulation.getState());
+    metrics.score = m_simulation.getScore();
+    metrics.level = m_simulation.getLevel();
+    metrics.asteroids = static_cast<std::uint32_t>(m_simulation.getAsteroids().size());
+    metrics.sleepingAsteroids = static_cast<std::uint32_t>(m_simulation.getSleepingAsteroidCount());
+    metrics.bullets = static_cast<std::uint32_t>(m_simulation.getBullets().size());
+    metrics.particles = static_cast<std::uint32_t>(m_simulation.getParticles().size());
+    metrics.collisionPairsTested = collisions.pairsTested;
+    metrics.collisionHits = collisions.hits;
+    metrics.activeSounds = static_cast<std::uint32_t>(AudioManager::getInstance().getActiveSoundCount());
+    metrics.tickTimeMs = m_simulationPacer.getWorkTime();
+    metrics.effectsLevel = m_simulation.getEffectsQuality().level;
+    m_metrics.publishSimulation(metrics);
+}
+
+void Game::publishRenderMetrics(std::uint32_t drawCalls)
+{
+    RenderMetrics metrics;
+    metrics.frame = ++m_frameCount;
+    metrics.drawCalls = drawCalls;
+    metrics.frameTimeMs = m_deltaTime * 1000.0f;
+    metrics.workTimeMs = m_framePacer.getWorkTime();
+    metrics.jitterMs = m_framePacer.getJitter();
+    metrics.resolutionScale = m_worldSprite ? m_resolutionScaler.getScale() : 1.0f;
+    metrics.inputLatencyMs = m_inputLatency.getLast();
+    m_metrics.publishRender(metrics);
 }
 
-void Game::resetGame()
+void Game::recordInputLatency(const FrameSnapshot& snapshot)
 {
-    m_score = 0;
-    m_level = 1;
-    m_player.reset();
-    m_player.setLives(3);
-    m_bullets.clear();
-    m_asteroids.clear();
-    m_particles.clear();
-    
-    initLevel();
+    if (snapshot.inputTime == m_lastShownPressTime) {
+        return;
+    }
+    
+    // Only the newest press of those applied since the last frame shown is
+    // measured; display() has returned, so the frame is with the display
+    m_lastShownPressTime = snapshot.inputTime;
+    m_inputLatency.record(static_cast<float>(InputQueue::now() - snapshot.inputTime) / 1000000.0f);
 }
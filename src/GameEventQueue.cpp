@@ -0,0 +1,32 @@
+#include "GameEventQueue.hpp"
+
+GameEventQueue::GameEventQueue()
+{
+    // Enough for a busy tick without reallocating
+    m_events.reserve(64);
+}
+
+void GameEventQueue::push(GameEventType type, const sf::Vector2f& position, AsteroidSize asteroidSize)
+{
+    m_events.push_back({type, position, asteroidSize});
+}
+
+void GameEventQueue::clear()
+{
+    m_events.clear();
+}
+
+bool GameEventQueue::empty() const
+{
+    return m_events.empty();
+}
+
+std::size_t GameEventQueue::size() const
+{
+    return m_events.size();
+}
+
+const std::vector<GameEvent>& GameEventQueue::getEvents() const
+{
+    return m_events;
+}
@@ -0,0 +1,481 @@
+#include "GlyphAtlas.hpp"
+#include "Profiler.hpp"
+#include "ResourceManager.hpp"
+#include "StartupTimer.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace {
+
+constexpr std::uint32_t CACHE_MAGIC = 0x41475341u;    // "ASGA"
+constexpr std::uint32_t CACHE_VERSION = 1;
+
+// Pages are packed in rows across a texture this wide
+constexpr unsigned int ATLAS_WIDTH = 1024;
+
+// sf::Text draws each glyph quad this far past its bounds and texture rectangle
+constexpr float GLYPH_PADDING = 1.f;
+
+// Limits on what a cache file may claim, so a damaged one is rejected rather
+// than sizing buffers from garbage
+constexpr std::uint32_t MAX_ATLAS_HEIGHT = 8192;
+constexpr std::uint32_t MAX_PAGES = 64;
+
+struct CacheHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t fontBytes;
+    std::int64_t fontTime;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t pageCount;
+    std::uint32_t reserved;
+};
+
+struct CachePage {
+    std::uint32_t characterSize;
+    float lineSpacing;
+    std::uint32_t kerningCount;
+    std::uint32_t reserved;
+};
+
+std::uint32_t makePair(char32_t first, char32_t second)
+{
+    return static_cast<std::uint32_t>(first) << 8 | static_cast<std::uint32_t>(second);
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::Page::getGlyph(char32_t character) const
+{
+    if (character < FIRST_CHARACTER || character > LAST_CHARACTER) {
+        character = U'?';
+    }
+    return glyphs[character - FIRST_CHARACTER];
+}
+
+float GlyphAtlas::Page::getKerning(char32_t first, char32_t second) const
+{
+    if (kerning.empty() || first > LAST_CHARACTER || second > LAST_CHARACTER) {
+        return 0.f;
+    }
+    
+    std::uint32_t pair = makePair(first, second);
+    auto it = std::lower_bound(kerning.begin(), kerning.end(), pair,
+                               [](const Kerning& entry, std::uint32_t value) { return entry.pair < value; });
+    return it != kerning.end() && it->pair == pair ? it->offset : 0.f;
+}
+
+GlyphAtlas::GlyphAtlas()
+    : m_loaded(false)
+    , m_cached(false)
+{
+}
+
+bool GlyphAtlas::load(const std::string& fontFilename, const std::vector<unsigned int>& sizes, const std::string& cachePath)
+{
+    PROFILE_ZONE("GlyphAtlas::load");
+    STARTUP_SCOPE("Glyph atlas");
+    
+    m_loaded = false;
+    m_cached = false;
+    
+    // The cache belongs to one version of the font file
+    std::error_code error;
+    std::filesystem::path fontPath = ResourceManager::getFontPath(fontFilename);
+    std::uint64_t fontBytes = std::filesystem::file_size(fontPath, error);
+    if (error) {
+        std::cerr << "Failed to find font: " << fontPath.string() << std::endl;
+        return false;
+    }
+    auto writeTime = std::filesystem::last_write_time(fontPath, error);
+    std::int64_t fontTime = error ? 0 : static_cast<std::int64_t>(writeTime.time_since_epoch().count());
+    
+    if (readCache(cachePath, fontBytes, fontTime, sizes)) {
+        m_cached = true;
+    } else {
+        if (!rasterise(fontFilename, sizes)) {
+            return false;
+        }
+        
+        // A missing cache only costs the next start the rasterising again
+        if (!writeCache(cachePath, fontBytes, fontTime)) {
+            std::cerr << "Failed to write glyph cache: " << cachePath << std::endl;
+        }
+    }
+    
+    m_loaded = createTexture();
+    return m_loaded;
+}
+
+bool GlyphAtlas::isLoaded() const
+{
+    return m_loaded;
+}
+
+bool GlyphAtlas::wasCached() const
+{
+    return m_cached;
+}
+
+const sf::Texture& GlyphAtlas::getTexture() const
+{
+    return m_texture;
+}
+
+const GlyphAtlas::Page* GlyphAtlas::getPage(unsigned int characterSize) const
+{
+    for (const Page& page : m_pages) {
+        if (page.characterSize == characterSize) {
+            return &page;
+        }
+    }
+    return nullptr;
+}
+
+bool GlyphAtlas::readCache(const std::string& path, std::uint64_t fontBytes, std::int64_t fontTime,
+                           const std::vector<unsigned int>& sizes)
+{
+    STARTUP_SCOPE("Read glyph cache");
+    
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    
+    CacheHeader header;
+    if (!readValue(in, header) ||
+        header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.fontBytes != fontBytes || header.fontTime != fontTime ||
+        header.width != ATLAS_WIDTH || header.height > MAX_ATLAS_HEIGHT ||
+        header.pageCount != sizes.size() || header.pageCount > MAX_PAGES) {
+        return false;
+    }
+    
+    std::vector<Page> pages(header.pageCount);
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+        CachePage cachePage;
+        if (!readValue(in, cachePage) ||
+            cachePage.characterSize != sizes[i] ||
+            cachePage.kerningCount > CHARACTER_COUNT * CHARACTER_COUNT) {
+            return false;
+        }
+        
+        Page& page = pages[i];
+        page.characterSize = cachePage.characterSize;
+        page.lineSpacing = cachePage.lineSpacing;
+        page.kerning.resize(cachePage.kerningCount);
+        
+        in.read(reinterpret_cast<char*>(page.glyphs.data()), sizeof(Glyph) * page.glyphs.size());
+        in.read(reinterpret_cast<char*>(page.kerning.data()), sizeof(Kerning) * page.kerning.size());
+        if (!in) return false;
+    }
+    
+    std::vector<std::uint8_t> alpha(static_cast<std::size_t>(header.width) * header.height);
+    if (!in.read(reinterpret_cast<char*>(alpha.data()), alpha.size())) {
+        return false;
+    }
+    
+    m_pages = std::move(pages);
+    m_alpha = std::move(alpha);
+    m_size = sf::Vector2u(header.width, header.height);
+    return true;
+}
+
+bool GlyphAtlas::rasterise(const std::string& fontFilename, const std::vector<unsigned int>& sizes)
+{
+    STARTUP_SCOPE("Rasterise glyphs");
+    
+    const sf::Font& font = ResourceManager::getInstance().getFont(fontFilename);
+    
+    // Where each glyph's pixels are on the font's own page for its size
+    struct Source {
+        std::size_t page;
+        std::size_t glyph;
+        sf::IntRect rect;
+    };
+    std::vector<Source> sources;
+    
+    m_pages.assign(sizes.size(), Page());
+    for (std::size_t p = 0; p < sizes.size(); ++p) {
+        Page& page = m_pages[p];
+        page.characterSize = sizes[p];
+        page.lineSpacing = font.getLineSpacing(page.characterSize);
+        
+        for (std::size_t i = 0; i < CHARACTER_COUNT; ++i) {
+            const sf::Glyph& glyph = font.getGlyph(FIRST_CHARACTER + static_cast<char32_t>(i), page.characterSize, false);
+            page.glyphs[i] = Glyph{glyph.advance,
+                                   glyph.bounds.position.x, glyph.bounds.position.y,
+                                   glyph.bounds.size.x, glyph.bounds.size.y,
+                                   0, 0, glyph.textureRect.size.x, glyph.textureRect.size.y};
+            if (glyph.textureRect.size.x > 0 && glyph.textureRect.size.y > 0) {
+                sources.push_back(Source{p, i, glyph.textureRect});
+            }
+        }
+        
+        // Pairs are generated in order, so the list comes out sorted
+        for (char32_t first = FIRST_CHARACTER; first <= LAST_CHARACTER; ++first) {
+            for (char32_t second = FIRST_CHARACTER; second <= LAST_CHARACTER; ++second) {
+                float offset = font.getKerning(first, second, page.characterSize);
+                if (offset != 0.f) {
+                    page.kerning.push_back(Kerning{makePair(first, second), offset});
+                }
+            }
+        }
+    }
+    
+    // Shelf packing, tallest glyphs first; each glyph keeps a clear border of
+    // GLYPH_PADDING so the quads sf::Text would draw never pick up a neighbour
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) {
+        return a.rect.size.y > b.rect.size.y;
+    });
+    
+    const int border = static_cast<int>(GLYPH_PADDING);
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    for (const Source& source : sources) {
+        int cellWidth = source.rect.size.x + 2 * border;
+        int cellHeight = source.rect.size.y + 2 * border;
+        if (cellWidth > static_cast<int>(ATLAS_WIDTH)) {
+            std::cerr << "Glyph too wide for the atlas at size " << sizes[source.page] << std::endl;
+            return false;
+        }
+        if (x + cellWidth > static_cast<int>(ATLAS_WIDTH)) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        
+        Glyph& glyph = m_pages[source.page].glyphs[source.glyph];
+        glyph.x = x + border;
+        glyph.y = y + border;
+        
+        x += cellWidth;
+        rowHeight = std::max(rowHeight, cellHeight);
+    }
+    
+    m_size = sf::Vector2u(ATLAS_WIDTH, static_cast<unsigned int>(std::max(y + rowHeight, 1)));
+    if (m_size.y > MAX_ATLAS_HEIGHT) {
+        std::cerr << "Glyph atlas too large: " << m_size.y << " rows" << std::endl;
+        return false;
+    }
+    m_alpha.assign(static_cast<std::size_t>(m_size.x) * m_size.y, 0);
+    
+    // Copy the coverage out of the font's textures, one readback per size
+    for (std::size_t p = 0; p < m_pages.size(); ++p) {
+        sf::Image image = font.getTexture(m_pages[p].characterSize).copyToImage();
+        const std::uint8_t* pixels = image.getPixelsPtr();
+        const unsigned int imageWidth = image.getSize().x;
+        
+        for (const Source& source : sources) {
+            if (source.page != p) continue;
+            
+            const Glyph& glyph = m_pages[p].glyphs[source.glyph];
+            for (int row = 0; row < source.rect.size.y; ++row) {
+                const std::uint8_t* from = pixels + (static_cast<std::size_t>(source.rect.position.y + row) * imageWidth +
+                                                     source.rect.position.x) * 4;
+                std::uint8_t* to = m_alpha.data() + static_cast<std::size_t>(glyph.y + row) * m_size.x + glyph.x;
+                for (int column = 0; column < source.rect.size.x; ++column) {
+                    to[column] = from[column * 4 + 3];
+                }
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool GlyphAtlas::writeCache(const std::string& path, std::uint64_t fontBytes, std::int64_t fontTime) const
+{
+    std::error_code error;
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), error);
+    }
+    
+    // Written aside and renamed, so an interrupted write never leaves a
+    // cache that looks valid
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        
+        CacheHeader header{CACHE_MAGIC, CACHE_VERSION, fontBytes, fontTime,
+                           m_size.x, m_size.y, static_cast<std::uint32_t>(m_pages.size()), 0};
+        writeValue(out, header);
+        
+        for (const Page& page : m_pages) {
+            CachePage cachePage{page.characterSize, page.lineSpacing, static_cast<std::uint32_t>(page.kerning.size()), 0};
+            writeValue(out, cachePage);
+            out.write(reinterpret_cast<const char*>(page.glyphs.data()), sizeof(Glyph) * page.glyphs.size());
+            out.write(reinterpret_cast<const char*>(page.kerning.data()), sizeof(Kerning) * page.kerning.size());
+        }
+        
+        out.write(reinterpret_cast<const char*>(m_alpha.data()), static_cast<std::streamsize>(m_alpha.size()));
+        if (!out.flush()) {
+            out.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+bool GlyphAtlas::createTexture()
+{
+    STARTUP_SCOPE("Upload glyph atlas");
+    
+    std::vector<std::uint8_t> pixels(m_alpha.size() * 4);
+    for (std::size_t i = 0; i < m_alpha.size(); ++i) {
+        pixels[i * 4 + 0] = 255;
+        pixels[i * 4 + 1] = 255;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = m_alpha[i];
+    }
+    
+    if (!m_texture.resize(m_size)) {
+        std::cerr << "Failed to create glyph atlas texture" << std::endl;
+        return false;
+    }
+    m_texture.update(pixels.data());
+    m_texture.setSmooth(true);
+    return true;
+}
+
+AtlasText::AtlasText(const GlyphAtlas& atlas, std::string_view value, unsigned int characterSize)
+    : m_atlas(&atlas)
+    , m_page(atlas.getPage(characterSize))
+    , m_string(value)
+    , m_fillColor(sf::Color::White)
+{
+    updateGeometry();
+}
+
+void AtlasText::setString(std::string_view value)
+{
+    if (value == m_string) return;
+    
+    // assign() keeps the string's capacity, and so does the vertex array
+    m_string.assign(value.data(), value.size());
+    updateGeometry();
+}
+
+void AtlasText::setFillColor(sf::Color color)
+{
+    if (color == m_fillColor) return;
+    
+    m_fillColor = color;
+    for (sf::Vertex& vertex : m_vertices) {
+        vertex.color = color;
+    }
+}
+
+sf::FloatRect AtlasText::getLocalBounds() const
+{
+    return m_bounds;
+}
+
+void AtlasText::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (m_vertices.empty()) return;
+    
+    states.transform *= getTransform();
+    states.texture = &m_atlas->getTexture();
+    target.draw(m_vertices.data(), m_vertices.size(), sf::PrimitiveType::Triangles, states);
+}
+
+void AtlasText::updateGeometry()
+{
+    m_vertices.clear();
+    m_bounds = sf::FloatRect();
+    if (!m_page) return;
+    
+    // Same layout as sf::Text: the first baseline sits one character size
+    // down, whitespace only moves the pen, and bounds cover the glyphs
+    const float size = static_cast<float>(m_page->characterSize);
+    const float whitespaceWidth = m_page->getGlyph(U' ').advance;
+    
+    float x = 0.f;
+    float y = size;
+    float minX = size;
+    float minY = size;
+    float maxX = 0.f;
+    float maxY = 0.f;
+    char32_t previous = 0;
+    
+    for (char c : m_string) {
+        char32_t current = static_cast<unsigned char>(c);
+        if (current == U'\r') continue;
+        
+        x += m_page->getKerning(previous, current);
+        previous = current;
+        
+        if (current == U' ' || current == U'\n' || current == U'\t') {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            
+            if (current == U' ') {
+                x += whitespaceWidth;
+            } else if (current == U'\t') {
+                x += whitespaceWidth * 4.f;
+            } else {
+                y += m_page->lineSpacing;
+                x = 0.f;
+            }
+            
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            continue;
+        }
+        
+        const GlyphAtlas::Glyph& glyph = m_page->getGlyph(current);
+        
+        const float left = x + glyph.left - GLYPH_PADDING;
+        const float top = y + glyph.top - GLYPH_PADDING;
+        const float right = x + glyph.left + glyph.width + GLYPH_PADDING;
+        const float bottom = y + glyph.top + glyph.height + GLYPH_PADDING;
+        
+        const float u1 = static_cast<float>(glyph.x) - GLYPH_PADDING;
+        const float v1 = static_cast<float>(glyph.y) - GLYPH_PADDING;
+        const float u2 = static_cast<float>(glyph.x + glyph.w) + GLYPH_PADDING;
+        const float v2 = static_cast<float>(glyph.y + glyph.h) + GLYPH_PADDING;
+        
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(left, top), m_fillColor, sf::Vector2f(u1, v1)});
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(right, top), m_fillColor, sf::Vector2f(u2, v1)});
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(left, bottom), m_fillColor, sf::Vector2f(u1, v2)});
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(left, bottom), m_fillColor, sf::Vector2f(u1, v2)});
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(right, top), m_fillColor, sf::Vector2f(u2, v1)});
+        m_vertices.push_back(sf::Vertex{sf::Vector2f(right, bottom), m_fillColor, sf::Vector2f(u2, v2)});
+        
+        minX = std::min(minX, x + glyph.left);
+        maxX = std::max(maxX, x + glyph.left + glyph.width);
+        minY = std::min(minY, y + glyph.top);
+        maxY = std::max(maxY, y + glyph.top + glyph.height);
+        
+        x += glyph.advance;
+    }
+    
+    if (!m_string.empty()) {
+        m_bounds = sf::FloatRect(sf::Vector2f(minX, minY), sf::Vector2f(maxX - minX, maxY - minY));
+    }
+}
@@ -0,0 +1,327 @@
+#include "HeadlessHost.hpp"
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// One game plus the state of the bot playing it
+struct Instance {
+    explicit Instance(const SimulationConfig& config)
+        : simulation(config)
+        , rng(config.seed ^ 0x9e3779b9u)
+    {
+        nearest.reserve(64);
+    }
+    
+    Simulation simulation;
+    std::mt19937 rng;
+    bool firePressed = false;
+    std::vector<SpatialHit> nearest;     // Scratch for the bot's target lookup
+};
+
+void pinCurrentThread(unsigned int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    // macOS has no hard affinity API; leave placement to the scheduler
+    (void)cpu;
+#endif
+}
+
+// What a tick may change without being "busy" for the allocation check
+struct TickShape {
+    GameState state;
+    int level;
+    std::size_t entities;
+};
+
+TickShape shapeOf(const Simulation& simulation)
+{
+    return {simulation.getState(), simulation.getLevel(),
+            simulation.getAsteroids().size() + simulation.getBullets().size() + simulation.getParticles().size()};
+}
+
+// Simple scripted bot: turn towards the nearest asteroid, shoot when lined up
+// and thrust now and then so the ship keeps moving around the world
+PlayerInput botInput(Instance& instance)
+{
+    const Simulation& simulation = instance.simulation;
+    const Player& player = simulation.getPlayer();
+    PlayerInput input;
+    
+    // Nearest asteroid, across the wrap
+    instance.nearest.clear();
+    simulation.getAsteroidIndex().queryNearest(player.getPosition(), 1, instance.nearest);
+    if (!instance.nearest.empty()) {
+        sf::Vector2f targetDelta = instance.nearest[0].delta;
+        float length = instance.nearest[0].distance;
+        sf::Vector2f direction = player.getDirection();
+        float cross = direction.x * targetDelta.y - direction.y * targetDelta.x;
+        float dot = direction.x * targetDelta.x + direction.y * targetDelta.y;
+        
+        input.rotateLeft = cross < 0.0f;
+        input.rotateRight = cross > 0.0f;
+        
+        // Fire on alternate ticks so every shot is a fresh press
+        bool aligned = length > 0.0f && dot / length > 0.95f;
+        input.fire = aligned && !instance.firePressed;
+        instance.firePressed = input.fire;
+    }
+    
+    std::uniform_int_distribution<int> thrustDist(0, 9);
+    input.thrust = thrustDist(instance.rng) == 0;
+    return input;
+}
+
+}
+
+HeadlessHost::HeadlessHost(const HeadlessHostConfig& config)
+    : m_config(config)
+    , m_stats(config.instanceCount)
+    , m_wallSeconds(0.0)
+{
+    if (m_config.threadCount == 0) {
+        m_config.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_config.threadCount = std::min(m_config.threadCount, std::max(1u, m_config.instanceCount));
+}
+
+void HeadlessHost::run()
+{
+    if (!m_config.recordPath.empty() && !m_replay.open(m_config.recordPath)) {
+        throw std::runtime_error("Failed to open replay file: " + m_config.recordPath);
+    }
+    if (m_config.spectatePort != 0 && !m_spectators.start(m_config.spectatePort)) {
+        throw std::runtime_error("Failed to open spectator port " + std::to_string(m_config.spectatePort));
+    }
+    
+    auto start = Clock::now();
+    
+    // Split instances into contiguous, near-equal ranges per worker
+    std::vector<std::thread> workers;
+    workers.reserve(m_config.threadCount);
+    unsigned int perWorker = m_config.instanceCount / m_config.threadCount;
+    unsigned int remainder = m_config.instanceCount % m_config.threadCount;
+    unsigned int first = 0;
+    
+    for (unsigned int worker = 0; worker < m_config.threadCount; ++worker) {
+        unsigned int count = perWorker + (worker < remainder ? 1 : 0);
+        workers.emplace_back(&HeadlessHost::runWorker, this, worker, first, first + count);
+        first += count;
+    }
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    m_spectators.stop();
+    if (m_replay.isOpen() && !m_replay.close()) {
+        throw std::runtime_error("Failed to write replay file: " + m_config.recordPath);
+    }
+    
+    m_wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void HeadlessHost::runWorker(unsigned int worker, unsigned int first, unsigned int last)
+{
+    Profiler::setThreadName("worker");
+    
+    if (m_config.pinThreads) {
+        unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+        pinCurrentThread(worker % cpus);
+    }
+    
+    // Create the instances on this thread so their memory is local to it
+    std::vector<std::unique_ptr<Instance>> instances;
+    instances.reserve(last - first);
+    for (unsigned int i = first; i < last; ++i) {
+        SimulationConfig config = m_config.simulation;
+        config.seed = m_config.simulation.seed + i * 7919u;
+        instances.push_back(std::make_unique<Instance>(config));
+        instances.back()->simulation.startGame();
+        m_stats[i].worker = worker;
+    }
+    
+    const float deltaTime = 1.0f / m_config.tickRate;
+    
+    // One renderer per worker, shared by its instances
+    std::unique_ptr<SoftwareRenderer> renderer;
+    FrameSnapshot snapshot;
+    if (m_config.captureInterval > 0) {
+        renderer = std::make_unique<SoftwareRenderer>(m_config.captureWidth, m_config.captureHeight, m_config.captureFormat);
+    }
+    
+    // Step all instances in lockstep, one tick at a time
+    for (unsigned int tick = 0; tick < m_config.ticks; ++tick) {
+        bool capture = renderer && tick % m_config.captureInterval == 0;
+        
+        for (unsigned int i = first; i < last; ++i) {
+            Instance& instance = *instances[i - first];
+            InstanceStats& stats = m_stats[i];
+            
+            PlayerInput input = botInput(instance);
+            
+            TickShape before = shapeOf(instance.simulation);
+            std::uint64_t allocationsBefore = AllocationTracker::getThreadAllocationCount();
+            
+            auto tickStart = Clock::now();
+            instance.simulation.update(input, deltaTime);
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - tickStart).count();
+            
+            // A steady tick must not touch the heap
+            if (m_config.checkAllocations && tick >= m_config.warmupTicks) {
+                TickShape after = shapeOf(instance.simulation);
+                bool steady = instance.simulation.getEvents().empty() &&
+                              before.state == GameState::Playing && after.state == before.state &&
+                              after.level == before.level && after.entities <= before.entities;
+                if (steady) {
+                    stats.steadyTicks++;
+                    if (AllocationTracker::getThreadAllocationCount() != allocationsBefore) {
+                        if (stats.allocatingTicks == 0) {
+                            stats.firstAllocatingTick = tick;
+                        }
+                        stats.allocatingTicks++;
+                    }
+                }
+            }
+            
+            // Only the worker that owns instance 0 touches the replay and
+            // the broadcast
+            if (i == 0 && (m_replay.isOpen() || m_spectators.isRunning())) {
+                instance.simulation.capture(snapshot);
+                if (m_replay.isOpen()) {
+                    m_replay.write(snapshot, static_cast<float>(elapsed) / 1.0e6f);
+                }
+                if (m_spectators.isRunning()) {
+                    m_spectators.publish(snapshot);
+                }
+            }
+            
+            stats.ticks++;
+            stats.totalNanoseconds += static_cast<std::uint64_t>(elapsed);
+            stats.maxNanoseconds = std::max(stats.maxNanoseconds, static_cast<std::uint64_t>(elapsed));
+            
+            // Capture before restarting so game over frames are kept
+            if (capture) {
+                char filename[64];
+                std::snprintf(filename, sizeof(filename), "/instance_%04u_tick_%06u.%s", i, tick,
+                              m_config.captureFormat == PixelFormat::Gray8 ? "pgm" : "ppm");
+                instance.simulation.capture(snapshot);
+                renderer->render(snapshot);
+                renderer->saveToFile(m_config.captureDirectory + filename);
+            }
+            
+            // Start over when the bot loses
+            if (instance.simulation.getState() == GameState::GameOver) {
+                stats.gamesPlayed++;
+                stats.bestScore = std::max(stats.bestScore, instance.simulation.getScore());
+                instance.simulation.startGame();
+            }
+        }
+    }
+    
+    for (unsigned int i = first; i < last; ++i) {
+        m_stats[i].bestScore = std::max(m_stats[i].bestScore, instances[i - first]->simulation.getScore());
+    }
+}
+
+const std::vector<InstanceStats>& HeadlessHost::getStats() const
+{
+    return m_stats;
+}
+
+bool HeadlessHost::passedAllocationCheck() const
+{
+    for (const auto& stats : m_stats) {
+        if (stats.allocatingTicks > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HeadlessHost::printReport(std::ostream& out, bool verbose) const
+{
+    std::uint64_t totalTicks = 0;
+    std::uint64_t totalNanoseconds = 0;
+    std::uint64_t worstNanoseconds = 0;
+    
+    for (const auto& stats : m_stats) {
+        totalTicks += stats.ticks;
+        totalNanoseconds += stats.totalNanoseconds;
+        worstNanoseconds = std::max(worstNanoseconds, stats.maxNanoseconds);
+    }
+    
+    out << std::fixed << std::setprecision(2);
+    out << "Instances: " << m_config.instanceCount << " on " << m_config.threadCount << " threads\n";
+    out << "Ticks per instance: " << m_config.ticks << "\n";
+    out << "Wall time: " << m_wallSeconds << " s\n";
+    if (m_wallSeconds > 0.0) {
+        out << "Throughput: " << totalTicks / m_wallSeconds << " ticks/s\n";
+    }
+    if (totalTicks > 0) {
+        out << "Mean tick cost: " << totalNanoseconds / 1000.0 / totalTicks << " us\n";
+    }
+    out << "Worst tick cost: " << worstNanoseconds / 1000.0 << " us\n";
+    
+    if (m_config.spectatePort != 0) {
+        out << "Spectator frames sent: " << m_spectators.getSentFrameCount() << ", ticks skipped: "
+            << m_spectators.getSkippedFrameCount() << ", datagrams dropped: "
+            << m_spectators.getDroppedDatagramCount() << "\n";
+    }
+    
+    if (m_config.checkAllocations) {
+        std::uint64_t steadyTicks = 0;
+        std::uint64_t allocatingTicks = 0;
+        for (const auto& stats : m_stats) {
+            steadyTicks += stats.steadyTicks;
+            allocatingTicks += stats.allocatingTicks;
+        }
+        
+        AllocationTracker::Snapshot heap = AllocationTracker::capture();
+        out << "Steady ticks checked: " << steadyTicks << ", allocating: " << allocatingTicks << "\n";
+        out << "Peak heap: " << heap.peakLiveBytes / 1024 << " KiB, peak resident size: "
+            << AllocationTracker::getPeakResidentBytes() / (1024 * 1024) << " MiB\n";
+        for (std::size_t i = 0; i < m_stats.size(); ++i) {
+            if (m_stats[i].allocatingTicks > 0) {
+                out << "  instance " << i << " first allocated on steady tick " << m_stats[i].firstAllocatingTick << "\n";
+            }
+        }
+    }
+    
+    if (!verbose) {
+        return;
+    }
+    
+    out << "\ninstance worker   mean_us    max_us  games       best\n";
+    for (std::size_t i = 0; i < m_stats.size(); ++i) {
+        const InstanceStats& stats = m_stats[i];
+        double mean = stats.ticks ? stats.totalNanoseconds / 1000.0 / stats.ticks : 0.0;
+        out << std::setw(8) << i
+            << std::setw(7) << stats.worker
+            << std::setw(10) << mean
+            << std::setw(10) << stats.maxNanoseconds / 1000.0
+            << std::setw(7) << stats.gamesPlayed
+            << std::setw(11) << stats.bestScore << "\n";
+    }
+}
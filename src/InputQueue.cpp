@@ -0,0 +1,82 @@
+#include "InputQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+std::uint64_t InputQueue::now()
+{
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+void InputQueue::push(std::uint32_t keys, bool pressed, std::uint64_t time)
+{
+    if (keys == 0) {
+        return;
+    }
+    if (!m_events.push({time, keys, pressed})) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+InputFrame InputQueue::drain(std::uint64_t time)
+{
+    InputFrame frame;
+    
+    // Events read after the tick started wait for the next one
+    while (const InputEvent* event = m_events.front()) {
+        if (event->time > time) {
+            break;
+        }
+        
+        if (event->pressed) {
+            m_held |= event->keys;
+            frame.pressed |= event->keys;
+            frame.lastPressTime = event->time;
+        } else {
+            m_held &= ~event->keys;
+        }
+        m_events.pop();
+    }
+    
+    frame.held = m_held;
+    return frame;
+}
+
+std::uint32_t InputQueue::getDroppedCount() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void InputLatency::record(float latencyMs)
+{
+    m_history[m_next] = latencyMs;
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    m_count = std::min(m_count + 1, HISTORY_SIZE);
+}
+
+float InputLatency::getLast() const
+{
+    return m_count > 0 ? m_history[(m_next + HISTORY_SIZE - 1) % HISTORY_SIZE] : 0.0f;
+}
+
+float InputLatency::getMean() const
+{
+    if (m_count == 0) {
+        return 0.0f;
+    }
+    return std::accumulate(m_history.begin(), m_history.begin() + m_count, 0.0f) / m_count;
+}
+
+float InputLatency::getWorst() const
+{
+    if (m_count == 0) {
+        return 0.0f;
+    }
+    return *std::max_element(m_history.begin(), m_history.begin() + m_count);
+}
+
+std::size_t InputLatency::getSampleCount() const
+{
+    return m_count;
+}
@@ -0,0 +1,88 @@
+#include "LoadBand.hpp"
+
+namespace {
+
+// How quickly the smoothed load follows the per-frame load
+constexpr float LOAD_SMOOTHING = 0.15f;
+
+// A single slow frame (a hitch, a window drag) is not a trend
+constexpr int FRAMES_OVER_TO_DROP = 3;
+
+// About a second at 60 Hz of comfortable frames before each step up
+constexpr int FRAMES_UNDER_TO_RAISE = 60;
+
+}
+
+LoadBand::LoadBand(float budgetMs, int cooldownFrames)
+    : m_budget(budgetMs)
+    , m_cooldown(cooldownFrames)
+{
+    reset();
+}
+
+void LoadBand::setBudget(float budgetMs)
+{
+    m_budget = budgetMs;
+}
+
+float LoadBand::getBudget() const
+{
+    return m_budget;
+}
+
+LoadBand::Step LoadBand::recordFrame(float workMs, bool canStepDown, bool canStepUp)
+{
+    if (m_budget <= 0.0f) {
+        return Step::None;
+    }
+    
+    m_load += (workMs / m_budget - m_load) * LOAD_SMOOTHING;
+    
+    if (m_cooldownFrames > 0) {
+        m_cooldownFrames--;
+        return Step::None;
+    }
+    
+    // Count how long the load has been out of the band on either side
+    m_overFrames = (m_load > HIGH_LOAD) ? m_overFrames + 1 : 0;
+    m_underFrames = (m_load < LOW_LOAD) ? m_underFrames + 1 : 0;
+    
+    if (m_overFrames >= FRAMES_OVER_TO_DROP && canStepDown) {
+        m_downs++;
+        m_overFrames = 0;
+        m_cooldownFrames = m_cooldown;
+        return Step::Down;
+    }
+    if (m_underFrames >= FRAMES_UNDER_TO_RAISE && canStepUp) {
+        m_ups++;
+        m_underFrames = 0;
+        m_cooldownFrames = m_cooldown;
+        return Step::Up;
+    }
+    return Step::None;
+}
+
+void LoadBand::reset()
+{
+    m_load = 0.0f;
+    m_overFrames = 0;
+    m_underFrames = 0;
+    m_cooldownFrames = 0;
+    m_downs = 0;
+    m_ups = 0;
+}
+
+float LoadBand::getLoad() const
+{
+    return m_load;
+}
+
+std::uint32_t LoadBand::getDownCount() const
+{
+    return m_downs;
+}
+
+std::uint32_t LoadBand::getUpCount() const
+{
+    return m_ups;
+}
@@ -0,0 +1,229 @@
+#include "MetricsPage.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define METRICS_PAGE_SHM
+#endif
+
+namespace {
+
+constexpr const char* SEGMENT_PREFIX = "asteroids-metrics-";
+
+}
+
+namespace Metrics {
+
+std::string getSegmentName(std::int32_t pid)
+{
+    return "/" + std::string(SEGMENT_PREFIX) + std::to_string(pid);
+}
+
+std::vector<std::string> findSegments()
+{
+    std::vector<std::pair<long, std::string>> found;
+
+#if defined(METRICS_PAGE_SHM)
+    if (DIR* directory = opendir("/dev/shm")) {
+        std::string prefix(SEGMENT_PREFIX);
+        while (dirent* entry = readdir(directory)) {
+            std::string name(entry->d_name);
+            if (name.compare(0, prefix.size(), prefix) == 0) {
+                found.emplace_back(std::atol(name.c_str() + prefix.size()), "/" + name);
+            }
+        }
+        closedir(directory);
+    }
+#endif
+
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    
+    std::vector<std::string> names;
+    for (const auto& entry : found) {
+        names.push_back(entry.second);
+    }
+    return names;
+}
+
+}
+
+MetricsPublisher::MetricsPublisher()
+    : m_page(nullptr)
+{
+}
+
+MetricsPublisher::~MetricsPublisher()
+{
+    close();
+}
+
+bool MetricsPublisher::open()
+{
+#if defined(METRICS_PAGE_SHM)
+    if (m_page) {
+        return true;
+    }
+    
+    std::int32_t pid = static_cast<std::int32_t>(getpid());
+    std::string name = Metrics::getSegmentName(pid);
+    
+    // A leftover from a crashed process that had the same pid is replaced
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    
+    if (ftruncate(fd, sizeof(MetricsPage)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    
+    void* memory = mmap(nullptr, sizeof(MetricsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    
+    // The new segment is zero-filled, so the magic reads as zero until it is stored
+    m_page = new (memory) MetricsPage{};
+    m_page->version = METRICS_PAGE_VERSION;
+    m_page->size = sizeof(MetricsPage);
+    m_page->pid = pid;
+    m_page->magic.store(METRICS_PAGE_MAGIC, std::memory_order_release);
+    m_name = name;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MetricsPublisher::close()
+{
+#if defined(METRICS_PAGE_SHM)
+    if (!m_page) {
+        return;
+    }
+    
+    m_page->~MetricsPage();
+    munmap(m_page, sizeof(MetricsPage));
+    shm_unlink(m_name.c_str());
+    m_page = nullptr;
+    m_name.clear();
+#endif
+}
+
+bool MetricsPublisher::isOpen() const
+{
+    return m_page != nullptr;
+}
+
+const std::string& MetricsPublisher::getName() const
+{
+    return m_name;
+}
+
+void MetricsPublisher::publishSimulation(const SimulationMetrics& metrics)
+{
+    if (m_page) {
+        m_page->simulation.write(metrics);
+    }
+}
+
+void MetricsPublisher::publishRender(const RenderMetrics& metrics)
+{
+    if (m_page) {
+        m_page->render.write(metrics);
+    }
+}
+
+MetricsReader::MetricsReader()
+    : m_page(nullptr)
+{
+}
+
+MetricsReader::~MetricsReader()
+{
+    close();
+}
+
+bool MetricsReader::open(const std::string& name)
+{
+    close();
+
+#if defined(METRICS_PAGE_SHM)
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // A segment the game hasn't sized yet (or something else under the
+    // name) is shorter than a page, and touching the mapping past its end
+    // would raise SIGBUS
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(MetricsPage))) {
+        ::close(fd);
+        return false;
+    }
+    
+    // Read-only mapping: nothing the reader does can reach the game
+    void* memory = mmap(nullptr, sizeof(MetricsPage), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    
+    const MetricsPage* page = static_cast<const MetricsPage*>(memory);
+    if (page->magic.load(std::memory_order_acquire) != METRICS_PAGE_MAGIC ||
+        page->version != METRICS_PAGE_VERSION || page->size != sizeof(MetricsPage)) {
+        munmap(memory, sizeof(MetricsPage));
+        return false;
+    }
+    
+    m_page = page;
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void MetricsReader::close()
+{
+#if defined(METRICS_PAGE_SHM)
+    if (m_page) {
+        munmap(const_cast<MetricsPage*>(m_page), sizeof(MetricsPage));
+        m_page = nullptr;
+    }
+#endif
+}
+
+bool MetricsReader::isOpen() const
+{
+    return m_page != nullptr;
+}
+
+std::int32_t MetricsReader::getPid() const
+{
+    return m_page ? m_page->pid : 0;
+}
+
+SimulationMetrics MetricsReader::readSimulation() const
+{
+    return m_page ? m_page->simulation.read() : SimulationMetrics();
+}
+
+RenderMetrics MetricsReader::readRender() const
+{
+    return m_page ? m_page->render.read() : RenderMetrics();
+}
@@ -0,0 +1,223 @@
+#include "MotionKernel.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MOTION_KERNEL_SSE2
+#endif
+
+// Floats of this magnitude or more have no fractional part
+static constexpr float EXACT_INTEGER_LIMIT = 8388608.0f;
+
+namespace MotionKernel {
+
+float wrap(float value, float size)
+{
+    // value - size * floor(value / size), with floor built from truncation the
+    // way the vector path has to. The conditional adds of zero mirror the
+    // masked adds there, so even the sign of zero comes out the same.
+    float quotient = value / size;
+    float whole = quotient;
+    if (std::fabs(quotient) < EXACT_INTEGER_LIMIT) {
+        whole = static_cast<float>(static_cast<std::int32_t>(quotient));
+    }
+    whole -= (whole > quotient) ? 1.0f : 0.0f;
+    
+    float result = value - size * whole;
+    
+    // The product can round the result onto the far edge of the range
+    result -= (result >= size) ? size : 0.0f;
+    result += (result < 0.0f) ? size : 0.0f;
+    return result;
+}
+
+namespace scalar {
+
+void integrate(float* x, float* y, const float* velocityX, const float* velocityY,
+               std::size_t count, float deltaTime, float width, float height)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        x[i] = wrap(x[i] + velocityX[i] * deltaTime, width);
+        y[i] = wrap(y[i] + velocityY[i] * deltaTime, height);
+    }
+}
+
+void advanceAngles(float* angles, const float* speeds, std::size_t count, float deltaTime)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        angles[i] = wrap(angles[i] + speeds[i] * deltaTime, 360.0f);
+    }
+}
+
+}
+
+#if defined(MOTION_KERNEL_SSE2)
+
+namespace {
+
+constexpr std::size_t WIDTH = 4;
+
+// Four lanes of wrap(), step for step
+inline __m128 wrap4(__m128 value, __m128 size)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 limit = _mm_set1_ps(EXACT_INTEGER_LIMIT);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    
+    __m128 quotient = _mm_div_ps(value, size);
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(quotient));
+    __m128 small = _mm_cmplt_ps(_mm_and_ps(quotient, absMask), limit);
+    __m128 whole = _mm_or_ps(_mm_and_ps(small, truncated), _mm_andnot_ps(small, quotient));
+    whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, quotient), one));
+    
+    __m128 result = _mm_sub_ps(value, _mm_mul_ps(size, whole));
+    result = _mm_sub_ps(result, _mm_and_ps(_mm_cmpge_ps(result, size), size));
+    result = _mm_add_ps(result, _mm_and_ps(_mm_cmplt_ps(result, zero), size));
+    return result;
+}
+
+}
+
+void integrate(float* x, float* y, const float* velocityX, const float* velocityY,
+               std::size_t count, float deltaTime, float width, float height)
+{
+    const __m128 step = _mm_set1_ps(deltaTime);
+    const __m128 widths = _mm_set1_ps(width);
+    const __m128 heights = _mm_set1_ps(height);
+    
+    std::size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        __m128 newX = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(velocityX + i), step));
+        __m128 newY = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(velocityY + i), step));
+        _mm_storeu_ps(x + i, wrap4(newX, widths));
+        _mm_storeu_ps(y + i, wrap4(newY, heights));
+    }
+    
+    scalar::integrate(x + i, y + i, velocityX + i, velocityY + i, count - i, deltaTime, width, height);
+}
+
+void advanceAngles(float* angles, const float* speeds, std::size_t count, float deltaTime)
+{
+    const __m128 step = _mm_set1_ps(deltaTime);
+    const __m128 fullTurn = _mm_set1_ps(360.0f);
+    
+    std::size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        __m128 angle = _mm_add_ps(_mm_loadu_ps(angles + i), _mm_mul_ps(_mm_loadu_ps(speeds + i), step));
+        _mm_storeu_ps(angles + i, wrap4(angle, fullTurn));
+    }
+    
+    scalar::advanceAngles(angles + i, speeds + i, count - i, deltaTime);
+}
+
+bool isVectorized()
+{
+    return true;
+}
+
+std::size_t getWidth()
+{
+    return WIDTH;
+}
+
+#else
+
+// No SIMD on this target, the scalar kernels are the batch kernels
+
+void integrate(float* x, float* y, const float* velocityX, const float* velocityY,
+               std::size_t count, float deltaTime, float width, float height)
+{
+    scalar::integrate(x, y, velocityX, velocityY, count, deltaTime, width, height);
+}
+
+void advanceAngles(float* angles, const float* speeds, std::size_t count, float deltaTime)
+{
+    scalar::advanceAngles(angles, speeds, count, deltaTime);
+}
+
+bool isVectorized()
+{
+    return false;
+}
+
+std::size_t getWidth()
+{
+    return 1;
+}
+
+#endif
+
+namespace {
+
+std::size_t countMismatches(const std::vector<float>& a, const std::vector<float>& b)
+{
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::memcmp(&a[i], &b[i], sizeof(float)) != 0) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+}
+
+std::size_t verify(unsigned int seed, std::size_t count)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> velocity(-800.0f, 800.0f);
+    std::uniform_real_distribution<float> spin(-720.0f, 720.0f);
+    std::uniform_real_distribution<float> deltaTime(0.0f, 0.1f);
+    
+    // Mostly ordinary positions, with edges, signed zeros and far outliers mixed in
+    const float width = 1024.0f + std::floor(unit(rng) * 1024.0f);
+    const float height = 768.0f + std::floor(unit(rng) * 768.0f);
+    auto position = [&](float size) {
+        switch (rng() % 8) {
+            case 0: return 0.0f;
+            case 1: return -0.0f;
+            case 2: return size;
+            case 3: return std::nextafter(size, 0.0f);
+            case 4: return (unit(rng) - 0.5f) * 2.0e9f;
+            default: return unit(rng) * size;
+        }
+    };
+    
+    std::vector<float> x(count), y(count), velocityX(count), velocityY(count);
+    std::vector<float> angles(count), speeds(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        x[i] = position(width);
+        y[i] = position(height);
+        velocityX[i] = velocity(rng);
+        velocityY[i] = velocity(rng);
+        angles[i] = position(360.0f);
+        speeds[i] = spin(rng);
+    }
+    
+    std::size_t mismatches = 0;
+    
+    // Several steps, so wrapped results are fed back in
+    for (int step = 0; step < 8; ++step) {
+        float dt = deltaTime(rng);
+        
+        std::vector<float> batchX = x, batchY = y, batchAngles = angles;
+        integrate(batchX.data(), batchY.data(), velocityX.data(), velocityY.data(), count, dt, width, height);
+        advanceAngles(batchAngles.data(), speeds.data(), count, dt);
+        
+        scalar::integrate(x.data(), y.data(), velocityX.data(), velocityY.data(), count, dt, width, height);
+        scalar::advanceAngles(angles.data(), speeds.data(), count, dt);
+        
+        mismatches += countMismatches(batchX, x) + countMismatches(batchY, y) +
+                      countMismatches(batchAngles, angles);
+    }
+    
+    return mismatches;
+}
+
+}
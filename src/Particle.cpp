@@ -1,48 +1,53 @@
 #include "Particle.hpp"
+#include "StateArchive.hpp"
+#include <algorithm>
 #include <random>
 
-Particle::Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color)
+Particle::Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, std::mt19937& rng,
+                   float lifetimeScale)
+    : Particle(position, velocity, color,
+               std::uniform_real_distribution<float>(PARTICLE_LIFETIME_MIN, PARTICLE_LIFETIME_MAX)(rng) * lifetimeScale)
+{
+}
+
+Particle::Particle(sf::Vector2f position, sf::Vector2f velocity, sf::Color color, float lifetime)
     : Entity(position, 1.0f)
+    , m_lifetime(lifetime)
+    , m_expiryTick(0)
     , m_color(color)
 {
     m_type = EntityType::Particle;
     m_velocity = velocity;
-    
-    // Random number generation
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> lifetimeDist(PARTICLE_LIFETIME_MIN, PARTICLE_LIFETIME_MAX);
-    
-    m_maxLifetime = lifetimeDist(gen);
-    m_lifetime = m_maxLifetime;
-    
-    m_shape.setSize(sf::Vector2f(2.0f, 2.0f));
-    m_shape.setFillColor(m_color);
-    m_shape.setOrigin(sf::Vector2f(1.0f, 1.0f));
 }
 
-void Particle::update(float deltaTime)
+sf::Color Particle::getColor(float tick) const
 {
-    move(deltaTime);
-    
-    // Decrease lifetime
-    m_lifetime -= deltaTime;
-    
-    // Set inactive when lifetime expires
-    if (m_lifetime <= 0.0f) {
-        setInactive();
-        return;
-    }
-    
     // Fade out over lifetime
-    float alpha = (m_lifetime / m_maxLifetime) * 255.0f;
+    float left = (static_cast<float>(m_expiryTick) - tick) / LIFETIME_TICKS_PER_SECOND;
     sf::Color color = m_color;
-    color.a = static_cast<std::uint8_t>(alpha);
-    m_shape.setFillColor(color);
+    color.a = static_cast<std::uint8_t>(std::clamp(left / m_lifetime, 0.0f, 1.0f) * 255.0f);
+    return color;
+}
+
+void Particle::save(StateWriter& out) const
+{
+    out.write(m_lifetime);
+    out.write(m_expiryTick);
+    out.write(m_color);
+    saveMotion(out);
 }
 
-void Particle::render(sf::RenderWindow& window)
+Particle Particle::load(StateReader& in)
 {
-    m_shape.setPosition(m_position);
-    window.draw(m_shape);
+    float lifetime = 0.0f;
+    std::uint32_t expiryTick = 0;
+    sf::Color color;
+    in.read(lifetime);
+    in.read(expiryTick);
+    in.read(color);
+    
+    Particle particle(sf::Vector2f(), sf::Vector2f(), color, lifetime);
+    particle.m_expiryTick = expiryTick;
+    particle.loadMotion(in);
+    return particle;
 }
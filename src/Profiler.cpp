@@ -0,0 +1,240 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Zones kept per thread; at a few hundred zones per frame this is well over
+// a minute of history
+constexpr std::size_t EVENTS_PER_THREAD = 1u << 16;
+
+struct Event {
+    const char* name;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+// Ring of one thread's zones. Only the owning thread writes; head counts
+// every event ever written, so slot head % EVENTS_PER_THREAD is next.
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{new Event[EVENTS_PER_THREAD]};
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<const char*> name{nullptr};
+    std::uint32_t id = 0;
+};
+
+// Buffers outlive their threads so a trace can still show them
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+// Buffers are only made once a thread records, so naming a thread is free
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local const char* t_name = nullptr;
+
+ThreadBuffer& getThreadBuffer()
+{
+    if (!t_buffer) {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = registry.buffers.back().get();
+        t_buffer->id = static_cast<std::uint32_t>(registry.buffers.size());
+        t_buffer->name.store(t_name, std::memory_order_relaxed);
+    }
+    return *t_buffer;
+}
+
+// Copy the events of a buffer that a concurrent writer can't have
+// overwritten during the copy, oldest first
+void copyEvents(const ThreadBuffer& buffer, std::vector<Event>& events)
+{
+    std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+    std::uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+    
+    std::size_t copied = events.size();
+    for (std::uint64_t i = first; i < head; ++i) {
+        events.push_back(buffer.events[i % EVENTS_PER_THREAD]);
+    }
+    
+    // Writes that finished or started meanwhile reused the oldest slots
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t headAfter = buffer.head.load(std::memory_order_relaxed);
+    if (headAfter + 1 > first + EVENTS_PER_THREAD) {
+        std::uint64_t stale = std::min(headAfter + 1 - EVENTS_PER_THREAD - first, head - first);
+        events.erase(events.begin() + static_cast<std::ptrdiff_t>(copied),
+                     events.begin() + static_cast<std::ptrdiff_t>(copied + stale));
+    }
+}
+
+// Spike capture settings and progress; only touched by the endFrame thread
+struct SpikeCapture {
+    bool enabled = false;
+    float budgetMs = 0.0f;
+    std::uint64_t before = 0;
+    std::uint64_t after = 0;
+    std::string prefix;
+    std::uint64_t pendingAt = 0;  // Time of a spike waiting for its after-window, 0 if none
+    bool ignoreNext = false;      // The frame that wrote a trace pays for the write
+    unsigned int saved = 0;
+};
+
+SpikeCapture& getSpikeCapture()
+{
+    static SpikeCapture capture;
+    return capture;
+}
+
+std::uint64_t toNanoseconds(float seconds)
+{
+    return static_cast<std::uint64_t>(seconds * 1.0e9f);
+}
+
+}
+
+namespace Profiler {
+
+std::uint64_t now()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void setRecording(bool recording)
+{
+    now();  // Start the clock before the first zone reads it
+    enabledFlag().store(recording, std::memory_order_relaxed);
+}
+
+void setThreadName(const char* name)
+{
+    t_name = name;
+    if (t_buffer) {
+        t_buffer->name.store(name, std::memory_order_relaxed);
+    }
+}
+
+void record(const char* name, std::uint64_t start, std::uint64_t end)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % EVENTS_PER_THREAD] = Event{name, start, end};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+long writeTrace(const std::string& path, std::uint64_t from, std::uint64_t to)
+{
+    ProfileZone zone("Profiler::writeTrace");
+    
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return -1;
+    }
+    
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    
+    long written = 0;
+    bool first = true;
+    std::vector<Event> events;
+    
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        if (const char* name = buffer->name.load(std::memory_order_relaxed)) {
+            std::fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         first ? "" : ",\n", buffer->id, name);
+            first = false;
+        }
+        
+        events.clear();
+        copyEvents(*buffer, events);
+        for (const Event& event : events) {
+            if (event.end < from || event.start > to) {
+                continue;
+            }
+            
+            // Complete events, microseconds on the trace clock
+            std::fprintf(file, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         first ? "" : ",\n", event.name, buffer->id,
+                         static_cast<double>(event.start) / 1000.0,
+                         static_cast<double>(event.end - event.start) / 1000.0);
+            first = false;
+            written++;
+        }
+    }
+    
+    std::fprintf(file, "\n]}\n");
+    bool failed = std::ferror(file) != 0;
+    if (std::fclose(file) != 0 || failed) {
+        return -1;
+    }
+    return written;
+}
+
+void setSpikeCapture(bool enabled, float budgetMs, float beforeSeconds, float afterSeconds,
+                     const std::string& prefix)
+{
+    SpikeCapture& capture = getSpikeCapture();
+    capture.enabled = enabled;
+    capture.budgetMs = budgetMs;
+    capture.before = toNanoseconds(beforeSeconds);
+    capture.after = toNanoseconds(afterSeconds);
+    capture.prefix = prefix;
+    capture.pendingAt = 0;
+    capture.ignoreNext = false;
+    
+    if (enabled) {
+        setRecording(true);
+    }
+}
+
+bool isSpikeCaptureEnabled()
+{
+    return getSpikeCapture().enabled;
+}
+
+std::string endFrame(float workMs)
+{
+    SpikeCapture& capture = getSpikeCapture();
+    if (!capture.enabled) {
+        return std::string();
+    }
+    
+    std::uint64_t time = now();
+    
+    if (capture.ignoreNext) {
+        capture.ignoreNext = false;
+    } else if (capture.pendingAt == 0 && workMs > capture.budgetMs) {
+        // Mark the spike itself on this thread's timeline
+        std::uint64_t work = static_cast<std::uint64_t>(workMs * 1.0e6f);
+        record("Frame over budget", time > work ? time - work : 0, time);
+        capture.pendingAt = time;
+    }
+    
+    if (capture.pendingAt != 0 && time >= capture.pendingAt + capture.after) {
+        std::uint64_t from = capture.pendingAt > capture.before ? capture.pendingAt - capture.before : 0;
+        std::string path = capture.prefix + "-" + std::to_string(++capture.saved) + ".json";
+        capture.pendingAt = 0;
+        capture.ignoreNext = true;
+        
+        if (writeTrace(path, from, time) >= 0) {
+            return path;
+        }
+    }
+    
+    return std::string();
+}
+
+}
@@ -0,0 +1,71 @@
+#include "QualityGovernor.hpp"
+#include <algorithm>
+
+namespace {
+
+// Frames to let the smoothed load settle after a change
+constexpr int COOLDOWN_FRAMES = 10;
+
+// Falling fast, rising slowly: one drop (1.0 to 0.8) is undone by four
+// steps up, 280 frames, and the floor takes fifteen, 1050 frames
+constexpr float DROP_FACTOR = 0.8f;
+constexpr float RAISE_STEP = 0.05f;
+
+}
+
+QualityGovernor::QualityGovernor(float budgetMs)
+    : m_band(budgetMs, COOLDOWN_FRAMES)
+    , m_level(1.0f)
+{
+}
+
+void QualityGovernor::setBudget(float budgetMs)
+{
+    m_band.setBudget(budgetMs);
+}
+
+float QualityGovernor::getBudget() const
+{
+    return m_band.getBudget();
+}
+
+void QualityGovernor::recordFrame(float workMs, bool canRaise)
+{
+    LoadBand::Step step = m_band.recordFrame(workMs, m_level > EFFECTS_QUALITY_MIN, canRaise && m_level < 1.0f);
+    if (step == LoadBand::Step::Down) {
+        m_level = std::max(m_level * DROP_FACTOR, EFFECTS_QUALITY_MIN);
+    } else if (step == LoadBand::Step::Up) {
+        m_level = std::min(m_level + RAISE_STEP, 1.0f);
+    }
+}
+
+void QualityGovernor::reset()
+{
+    m_band.reset();
+    m_level = 1.0f;
+}
+
+float QualityGovernor::getLevel() const
+{
+    return m_level;
+}
+
+float QualityGovernor::getLoad() const
+{
+    return m_band.getLoad();
+}
+
+EffectsQuality QualityGovernor::getQuality() const
+{
+    return EffectsQuality::fromLevel(m_level);
+}
+
+std::uint32_t QualityGovernor::getDowngradeCount() const
+{
+    return m_band.getDownCount();
+}
+
+std::uint32_t QualityGovernor::getUpgradeCount() const
+{
+    return m_band.getUpCount();
+}
@@ -0,0 +1,434 @@
+#include "Replay.hpp"
+#include "Profiler.hpp"
+#include "SnapshotCodec.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define REPLAY_MMAP
+#endif
+
+namespace {
+
+struct FileHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t keyframeInterval;
+    std::uint32_t reserved;
+};
+
+struct RecordHeader {
+    std::uint32_t payloadBytes;
+    std::uint32_t wordCount;
+    float tickTimeMs;
+    std::uint32_t flags;
+};
+
+struct Footer {
+    std::uint64_t indexOffset;
+    std::uint64_t tickCount;
+    std::uint32_t keyframeCount;
+    std::uint32_t magic;
+};
+
+constexpr std::uint32_t RECORD_KEYFRAME = 1u << 0;
+
+// The XOR of current against base (missing base words count as zero), byte
+// plane by byte plane, as alternating runs of zero bytes and literal bytes.
+// A single zero byte between literals stays in the literal run, where it is
+// cheaper than starting a new pair of runs.
+void encode(const std::vector<std::uint32_t>& base, const std::vector<std::uint32_t>& current,
+            std::vector<std::uint8_t>& out)
+{
+    out.clear();
+    const std::size_t count = current.size();
+    const std::size_t total = count * 4;
+    
+    auto byteAt = [&](std::size_t k) {
+        std::size_t plane = k / count;
+        std::size_t i = k % count;
+        std::uint32_t word = current[i] ^ (i < base.size() ? base[i] : 0u);
+        return static_cast<std::uint8_t>(word >> (plane * 8));
+    };
+    
+    std::size_t k = 0;
+    while (k < total) {
+        std::size_t zeros = 0;
+        while (k < total && byteAt(k) == 0) {
+            zeros++;
+            k++;
+        }
+        
+        std::size_t literalStart = k;
+        while (k < total && (byteAt(k) != 0 || (k + 1 < total && byteAt(k + 1) != 0))) {
+            k++;
+        }
+        
+        SnapshotCodec::putRun(out, zeros, k - literalStart);
+        for (std::size_t j = literalStart; j < k; ++j) {
+            out.push_back(byteAt(j));
+        }
+    }
+}
+
+// Undo encode() on top of words, which holds the base resized to the record's length
+bool decode(const std::uint8_t* data, std::size_t size, std::vector<std::uint32_t>& words)
+{
+    const std::size_t count = words.size();
+    auto takeLiterals = [&](std::size_t k, std::size_t literals, const std::uint8_t*& bytes, const std::uint8_t* end) {
+        if (literals > static_cast<std::size_t>(end - bytes)) {
+            return false;
+        }
+        for (std::size_t j = 0; j < literals; ++j, ++k) {
+            words[k % count] ^= static_cast<std::uint32_t>(*bytes++) << ((k / count) * 8);
+        }
+        return true;
+    };
+    return SnapshotCodec::readRuns(data, size, count * 4, takeLiterals);
+}
+
+template <typename T>
+bool readAt(const std::uint8_t* data, std::size_t size, std::uint64_t offset, T& value)
+{
+    if (offset > size || size - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, data + offset, sizeof(T));
+    return true;
+}
+
+}
+
+ReplayWriter::ReplayWriter()
+    : m_file(nullptr)
+    , m_keyframeInterval(0)
+    , m_tickCount(0)
+    , m_offset(0)
+    , m_failed(false)
+{
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+bool ReplayWriter::open(const std::string& path, std::uint32_t keyframeInterval)
+{
+    close();
+    
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        return false;
+    }
+    
+    m_path = path;
+    m_keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+    m_tickCount = 0;
+    m_failed = false;
+    m_keyframes.clear();
+    m_previous.clear();
+    
+    FileHeader header{REPLAY_MAGIC, REPLAY_VERSION, m_keyframeInterval, 0};
+    m_failed = std::fwrite(&header, sizeof(header), 1, m_file) != 1;
+    m_offset = sizeof(header);
+    return !m_failed;
+}
+
+void ReplayWriter::write(const FrameSnapshot& snapshot, float tickTimeMs)
+{
+    if (!m_file) {
+        return;
+    }
+    
+    PROFILE_ZONE("ReplayWriter::write");
+    
+    bool keyframe = m_tickCount % m_keyframeInterval == 0;
+    if (keyframe) {
+        m_keyframes.push_back(m_offset);
+        m_previous.clear();
+    }
+    
+    SnapshotCodec::flatten(snapshot, SnapshotCodec::EXACT, m_current);
+    encode(m_previous, m_current, m_payload);
+    
+    RecordHeader header{static_cast<std::uint32_t>(m_payload.size()), static_cast<std::uint32_t>(m_current.size()),
+                        tickTimeMs, keyframe ? RECORD_KEYFRAME : 0u};
+    m_failed |= std::fwrite(&header, sizeof(header), 1, m_file) != 1;
+    m_failed |= std::fwrite(m_payload.data(), 1, m_payload.size(), m_file) != m_payload.size();
+    m_offset += sizeof(header) + m_payload.size();
+    
+    m_previous.swap(m_current);
+    m_tickCount++;
+    
+    // Let readers of an unfinished file see whole stretches between keyframes
+    if (keyframe) {
+        std::fflush(m_file);
+    }
+}
+
+bool ReplayWriter::close()
+{
+    if (!m_file) {
+        return !m_failed;
+    }
+    
+    std::uint64_t indexOffset = m_offset;
+    m_failed |= std::fwrite(m_keyframes.data(), sizeof(std::uint64_t), m_keyframes.size(), m_file) != m_keyframes.size();
+    
+    Footer footer{indexOffset, m_tickCount, static_cast<std::uint32_t>(m_keyframes.size()), REPLAY_INDEX_MAGIC};
+    m_failed |= std::fwrite(&footer, sizeof(footer), 1, m_file) != 1;
+    m_offset += m_keyframes.size() * sizeof(std::uint64_t) + sizeof(footer);
+    
+    m_failed |= std::fclose(m_file) != 0;
+    m_file = nullptr;
+    return !m_failed;
+}
+
+bool ReplayWriter::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+const std::string& ReplayWriter::getPath() const
+{
+    return m_path;
+}
+
+std::uint64_t ReplayWriter::getTickCount() const
+{
+    return m_tickCount;
+}
+
+std::uint64_t ReplayWriter::getBytesWritten() const
+{
+    return m_offset;
+}
+
+ReplayReader::ReplayReader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_mapped(false)
+    , m_keyframeInterval(0)
+    , m_tickCount(0)
+    , m_recovered(false)
+    , m_currentTick(UINT64_MAX)
+    , m_nextOffset(0)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+    close();
+}
+
+bool ReplayReader::open(const std::string& path)
+{
+    close();
+
+#if defined(REPLAY_MMAP)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        return false;
+    }
+    
+    void* memory = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    
+    m_data = static_cast<const std::uint8_t*>(memory);
+    m_size = static_cast<std::size_t>(status.st_size);
+    m_mapped = true;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    m_fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_fallback.data();
+    m_size = m_fallback.size();
+#endif
+
+    FileHeader header;
+    if (!readAt(m_data, m_size, 0, header) || header.magic != REPLAY_MAGIC ||
+        header.version != REPLAY_VERSION || header.keyframeInterval == 0) {
+        close();
+        return false;
+    }
+    m_keyframeInterval = header.keyframeInterval;
+    
+    // Use the index if the file was closed properly. Each bound is checked
+    // on its own, so huge values in a damaged footer can't wrap past them
+    Footer footer;
+    if (m_size >= sizeof(FileHeader) + sizeof(Footer) &&
+        readAt(m_data, m_size, m_size - sizeof(Footer), footer) && footer.magic == REPLAY_INDEX_MAGIC &&
+        footer.indexOffset >= sizeof(FileHeader) && footer.indexOffset <= m_size - sizeof(Footer) &&
+        m_size - sizeof(Footer) - footer.indexOffset == std::uint64_t{footer.keyframeCount} * sizeof(std::uint64_t) &&
+        footer.keyframeCount == footer.tickCount / m_keyframeInterval + (footer.tickCount % m_keyframeInterval != 0)) {
+        m_keyframes.resize(footer.keyframeCount);
+        std::memcpy(m_keyframes.data(), m_data + footer.indexOffset, footer.keyframeCount * sizeof(std::uint64_t));
+        m_tickCount = footer.tickCount;
+        return true;
+    }
+    
+    // Otherwise walk the complete records
+    m_recovered = true;
+    std::uint64_t offset = sizeof(FileHeader);
+    RecordHeader record;
+    while (readAt(m_data, m_size, offset, record) && record.payloadBytes <= m_size - offset - sizeof(record)) {
+        bool expectKeyframe = m_tickCount % m_keyframeInterval == 0;
+        if (expectKeyframe != ((record.flags & RECORD_KEYFRAME) != 0)) {
+            break;
+        }
+        if (expectKeyframe) {
+            m_keyframes.push_back(offset);
+        }
+        offset += sizeof(record) + record.payloadBytes;
+        m_tickCount++;
+    }
+    return true;
+}
+
+void ReplayReader::close()
+{
+#if defined(REPLAY_MMAP)
+    if (m_mapped) {
+        munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_fallback.clear();
+    m_keyframeInterval = 0;
+    m_tickCount = 0;
+    m_keyframes.clear();
+    m_recovered = false;
+    m_words.clear();
+    m_currentTick = UINT64_MAX;
+    m_nextOffset = 0;
+}
+
+bool ReplayReader::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+std::uint64_t ReplayReader::getTickCount() const
+{
+    return m_tickCount;
+}
+
+std::uint32_t ReplayReader::getKeyframeInterval() const
+{
+    return m_keyframeInterval;
+}
+
+std::size_t ReplayReader::getFileSize() const
+{
+    return m_size;
+}
+
+bool ReplayReader::wasRecovered() const
+{
+    return m_recovered;
+}
+
+bool ReplayReader::read(std::uint64_t tick, FrameSnapshot& snapshot)
+{
+    if (tick >= m_tickCount) {
+        return false;
+    }
+    
+    PROFILE_ZONE("ReplayReader::read");
+    
+    // Keep going from the current tick if it is on the way, else restart at the keyframe
+    bool onTheWay = m_currentTick != UINT64_MAX && tick >= m_currentTick &&
+                    tick / m_keyframeInterval == m_currentTick / m_keyframeInterval;
+    if (!onTheWay) {
+        std::uint64_t keyframe = tick / m_keyframeInterval;
+        m_currentTick = keyframe * m_keyframeInterval;
+        m_nextOffset = applyRecord(m_keyframes[keyframe]);
+    }
+    
+    while (m_currentTick < tick && m_nextOffset != 0) {
+        m_nextOffset = applyRecord(m_nextOffset);
+        m_currentTick++;
+    }
+    
+    if (m_nextOffset == 0 || !SnapshotCodec::unflatten(m_words, SnapshotCodec::EXACT, snapshot)) {
+        m_currentTick = UINT64_MAX;
+        return false;
+    }
+    return true;
+}
+
+float ReplayReader::getTickTime(std::uint64_t tick) const
+{
+    RecordHeader record;
+    if (tick >= m_tickCount || !readAt(m_data, m_size, findRecord(tick), record)) {
+        return 0.0f;
+    }
+    return record.tickTimeMs;
+}
+
+std::uint64_t ReplayReader::findSlowTick(std::uint64_t from, float thresholdMs) const
+{
+    if (from >= m_tickCount) {
+        return m_tickCount;
+    }
+    
+    // Only record headers are read, payloads are skipped
+    std::uint64_t offset = findRecord(from);
+    RecordHeader record;
+    for (std::uint64_t tick = from; tick < m_tickCount && readAt(m_data, m_size, offset, record); ++tick) {
+        if (record.tickTimeMs > thresholdMs) {
+            return tick;
+        }
+        offset += sizeof(record) + record.payloadBytes;
+    }
+    return m_tickCount;
+}
+
+std::uint64_t ReplayReader::findRecord(std::uint64_t tick) const
+{
+    std::uint64_t offset = m_keyframes[tick / m_keyframeInterval];
+    RecordHeader record;
+    for (std::uint64_t i = 0; i < tick % m_keyframeInterval && readAt(m_data, m_size, offset, record); ++i) {
+        offset += sizeof(record) + record.payloadBytes;
+    }
+    return offset;
+}
+
+std::uint64_t ReplayReader::applyRecord(std::uint64_t offset)
+{
+    RecordHeader record;
+    if (!readAt(m_data, m_size, offset, record) || record.payloadBytes > m_size - offset - sizeof(record) ||
+        record.wordCount > SnapshotCodec::MAX_WORDS) {
+        return 0;
+    }
+    
+    if (record.flags & RECORD_KEYFRAME) {
+        m_words.assign(record.wordCount, 0u);
+    } else {
+        m_words.resize(record.wordCount, 0u);
+    }
+    
+    if (!decode(m_data + offset + sizeof(record), record.payloadBytes, m_words)) {
+        return 0;
+    }
+    return offset + sizeof(record) + record.payloadBytes;
+}
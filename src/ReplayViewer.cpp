@@ -0,0 +1,153 @@
+#include "ReplayViewer.hpp"
+#include "Profiler.hpp"
+#include "Constants.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// Playback speeds, in recorded ticks per tick of real time
+constexpr float SPEEDS[] = {0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f};
+constexpr int NORMAL_SPEED = 2;
+
+// Holding Left/Right moves the playhead this many times faster than playing
+constexpr double SCRUB_FACTOR = 8.0;
+
+// Keys acted on once per press
+enum ViewerKey : std::uint32_t {
+    VIEWER_PLAY = 1u << 0,
+    VIEWER_FASTER = 1u << 1,
+    VIEWER_SLOWER = 1u << 2,
+    VIEWER_NEXT_SLOW = 1u << 3,
+    VIEWER_START = 1u << 4,
+    VIEWER_END = 1u << 5
+};
+
+}
+
+ReplayViewer::ReplayViewer(const std::string& path)
+    : m_window(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), std::string(WINDOW_TITLE) + " - " + path)
+    , m_framePacer(TARGET_FRAME_RATE)
+    , m_frameArena(64 * 1024)
+    , m_ui(m_frameArena)
+    , m_position(0.0)
+    , m_speedStep(NORMAL_SPEED)
+    , m_paused(false)
+    , m_previousKeys(0)
+{
+    if (!m_reader.open(path) || m_reader.getTickCount() == 0) {
+        throw std::runtime_error("Not a replay file, or an empty one: " + path);
+    }
+}
+
+void ReplayViewer::run()
+{
+    Profiler::setThreadName("main");
+    m_framePacer.calibrate();
+    
+    while (m_window.isOpen()) {
+        float deltaTime = m_framePacer.waitForNextFrame();
+        
+        while (auto event = m_window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                m_window.close();
+            }
+        }
+        
+        handleInput(deltaTime);
+        render();
+        m_frameArena.reset();
+    }
+}
+
+void ReplayViewer::handleInput(float deltaTime)
+{
+    PROFILE_ZONE("ReplayViewer::handleInput");
+    
+    using Key = sf::Keyboard::Key;
+    
+    std::uint32_t keys = 0;
+    if (sf::Keyboard::isKeyPressed(Key::Space)) keys |= VIEWER_PLAY;
+    if (sf::Keyboard::isKeyPressed(Key::Up)) keys |= VIEWER_FASTER;
+    if (sf::Keyboard::isKeyPressed(Key::Down)) keys |= VIEWER_SLOWER;
+    if (sf::Keyboard::isKeyPressed(Key::N)) keys |= VIEWER_NEXT_SLOW;
+    if (sf::Keyboard::isKeyPressed(Key::Home)) keys |= VIEWER_START;
+    if (sf::Keyboard::isKeyPressed(Key::End)) keys |= VIEWER_END;
+    
+    std::uint32_t pressed = keys & ~m_previousKeys;
+    m_previousKeys = keys;
+    
+    if (sf::Keyboard::isKeyPressed(Key::Escape)) {
+        m_window.close();
+    }
+    
+    if (pressed & VIEWER_PLAY) {
+        m_paused = !m_paused;
+    }
+    if (pressed & VIEWER_FASTER) {
+        m_speedStep = std::min(m_speedStep + 1, static_cast<int>(std::size(SPEEDS)) - 1);
+    }
+    if (pressed & VIEWER_SLOWER) {
+        m_speedStep = std::max(m_speedStep - 1, 0);
+    }
+    if (pressed & VIEWER_START) {
+        seek(0.0);
+    }
+    if (pressed & VIEWER_END) {
+        seek(static_cast<double>(m_reader.getTickCount() - 1));
+    }
+    if (pressed & VIEWER_NEXT_SLOW) {
+        // Stop on the next tick that blew the frame budget
+        std::uint64_t from = static_cast<std::uint64_t>(m_position) + 1;
+        std::uint64_t slow = m_reader.findSlowTick(from, 1000.0f / TARGET_FRAME_RATE);
+        if (slow < m_reader.getTickCount()) {
+            seek(static_cast<double>(slow));
+            m_paused = true;
+        }
+    }
+    
+    // Recorded ticks are assumed to be TARGET_FRAME_RATE apart
+    double ticks = static_cast<double>(deltaTime) * TARGET_FRAME_RATE * SPEEDS[m_speedStep];
+    double scrub = static_cast<double>(deltaTime) * TARGET_FRAME_RATE * SCRUB_FACTOR * std::max(SPEEDS[m_speedStep], 1.0f);
+    
+    if (sf::Keyboard::isKeyPressed(Key::Left)) {
+        seek(m_position - scrub);
+    } else if (sf::Keyboard::isKeyPressed(Key::Right)) {
+        seek(m_position + scrub);
+    } else if (!m_paused) {
+        seek(m_position + ticks);
+    }
+}
+
+void ReplayViewer::seek(double tick)
+{
+    m_position = std::clamp(tick, 0.0, static_cast<double>(m_reader.getTickCount() - 1));
+}
+
+void ReplayViewer::render()
+{
+    PROFILE_ZONE("ReplayViewer::render");
+    
+    std::uint64_t tick = static_cast<std::uint64_t>(m_position);
+    m_reader.read(tick, m_snapshot);
+    
+    m_window.clear(sf::Color::Black);
+    m_worldRenderer.render(m_window, m_snapshot);
+    
+    m_ui.renderScore(m_window, m_snapshot.score);
+    m_ui.renderLives(m_window, m_snapshot.lives);
+    m_ui.renderLevel(m_window, m_snapshot.level);
+    
+    ReplayStatus status;
+    status.tick = tick;
+    status.tickCount = m_reader.getTickCount();
+    status.speed = SPEEDS[m_speedStep];
+    status.tickTimeMs = m_reader.getTickTime(tick);
+    status.budgetMs = 1000.0f / TARGET_FRAME_RATE;
+    status.paused = m_paused;
+    m_ui.renderReplayStatus(m_window, status);
+    
+    m_window.display();
+}
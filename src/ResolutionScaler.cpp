@@ -0,0 +1,93 @@
+#include "ResolutionScaler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Frames to let the smoothed load settle after a change; a little longer
+// than the effects governor's, since the render target has to be redrawn at
+// the new size before the load reflects it
+constexpr int COOLDOWN_FRAMES = 15;
+
+// Pixel count goes with the square of the scale, so a 0.9 drop sheds about
+// a fifth of the fill
+constexpr float DROP_FACTOR = 0.9f;
+constexpr float RAISE_STEP = 1.0f / ResolutionScaler::SCALE_STEPS;
+
+}
+
+ResolutionScaler::ResolutionScaler(float budgetMs, float minScale, float maxScale)
+    : m_band(budgetMs, COOLDOWN_FRAMES)
+    , m_minScale(1.0f)
+    , m_maxScale(1.0f)
+    , m_scale(1.0f)
+{
+    setBounds(minScale, maxScale);
+    reset();
+}
+
+void ResolutionScaler::setBudget(float budgetMs)
+{
+    m_band.setBudget(budgetMs);
+}
+
+void ResolutionScaler::setBounds(float minScale, float maxScale)
+{
+    const float smallest = 1.0f / SCALE_STEPS;
+    m_maxScale = std::clamp(maxScale, smallest, 1.0f);
+    m_minScale = std::clamp(minScale, smallest, m_maxScale);
+    m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+}
+
+float ResolutionScaler::getMinScale() const
+{
+    return m_minScale;
+}
+
+float ResolutionScaler::getMaxScale() const
+{
+    return m_maxScale;
+}
+
+void ResolutionScaler::recordFrame(float workMs, bool canLower)
+{
+    LoadBand::Step step = m_band.recordFrame(workMs, canLower && m_scale > m_minScale, m_scale < m_maxScale);
+    if (step == LoadBand::Step::Down) {
+        // Always at least one step down, however close to a step the drop lands
+        m_scale = std::min(snap(m_scale * DROP_FACTOR), snap(m_scale - RAISE_STEP));
+    } else if (step == LoadBand::Step::Up) {
+        m_scale = snap(m_scale + RAISE_STEP);
+    }
+}
+
+void ResolutionScaler::reset()
+{
+    m_band.reset();
+    m_scale = m_maxScale;
+}
+
+float ResolutionScaler::getScale() const
+{
+    return m_scale;
+}
+
+float ResolutionScaler::getLoad() const
+{
+    return m_band.getLoad();
+}
+
+std::uint32_t ResolutionScaler::getDowngradeCount() const
+{
+    return m_band.getDownCount();
+}
+
+std::uint32_t ResolutionScaler::getUpgradeCount() const
+{
+    return m_band.getUpCount();
+}
+
+float ResolutionScaler::snap(float scale) const
+{
+    float stepped = std::round(scale * SCALE_STEPS) / SCALE_STEPS;
+    return std::clamp(stepped, m_minScale, m_maxScale);
+}
@@ -1,4 +1,6 @@
 #include "ResourceManager.hpp"
+#include "Profiler.hpp"
+#include "StartupTimer.hpp"
 #include <iostream>
 #include <filesystem>
 
@@ -17,8 +19,10 @@ sf::Font& ResourceManager::getFont(const std::string& filename)
     }
     
     // Load the font
+    PROFILE_ZONE("ResourceManager::loadFont");
+    STARTUP_SCOPE("Load font");
     sf::Font font;
-    std::string path = "resources/fonts/" + filename;
+    std::string path = getFontPath(filename);
     
     if (!font.openFromFile(path)) {
         std::cerr << "Failed to load font: " << path << std::endl;
@@ -42,6 +46,11 @@ sf::Font& ResourceManager::getFont(const std::string& filename)
     return m_fonts[filename];
 }
 
+std::string ResourceManager::getFontPath(const std::string& filename)
+{
+    return "resources/fonts/" + filename;
+}
+
 sf::SoundBuffer& ResourceManager::getSoundBuffer(const std::string& filename)
 {
     // Check if sound buffer is already loaded
@@ -51,6 +60,8 @@ sf::SoundBuffer& ResourceManager::getSoundBuffer(const std::string& filename)
     }
     
     // Load the sound buffer
+    PROFILE_ZONE("ResourceManager::loadSoundBuffer");
+    STARTUP_SCOPE("Load sound");
     sf::SoundBuffer buffer;
     std::string path = "resources/sounds/" + filename;
     
@@ -66,16 +77,3 @@ sf::SoundBuffer& ResourceManager::getSoundBuffer(const std::string& filename)
     m_soundBuffers[filename] = buffer;
     return m_soundBuffers[filename];
 }
-
-void ResourceManager::loadResources()
-{
-    // Preload fonts
-    getFont("arial.ttf");
-    
-    // Preload sounds
-    getSoundBuffer("fire.wav");
-    getSoundBuffer("explosion_small.wav");
-    getSoundBuffer("explosion_medium.wav");
-    getSoundBuffer("explosion_large.wav");
-    getSoundBuffer("thrust.wav");
-}
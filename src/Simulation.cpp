@@ -0,0 +1,677 @@
+#include "Simulation.hpp"
+#include "AllocationTracker.hpp"
+#include "Collision.hpp"
+#include "MotionKernel.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Whole ticks a clock has reached. A hair over, so a clock stepped in exact
+// tick periods never lands just short of the tick it has reached
+std::uint32_t wholeTicks(double seconds, float ticksPerSecond)
+{
+    return static_cast<std::uint32_t>(seconds * ticksPerSecond + 1.0e-6);
+}
+
+// Ticks a wait of some seconds lasts, to the nearest tick
+std::uint32_t toTicks(float seconds, float ticksPerSecond)
+{
+    return static_cast<std::uint32_t>(std::lround(seconds * ticksPerSecond));
+}
+
+// Move every entity of a map with the batch motion kernels, the only place
+// asteroids, bullets and particles move. Fields are copied into scratch
+// arrays for the kernels and back; asteroids also spin. Lifetimes don't need
+// touching, they expire through the timing wheels.
+template <typename T>
+void moveEntities(SlotMap<T>& entities, float deltaTime, const sf::Vector2f& worldSize,
+                  std::pmr::memory_resource& scratch)
+{
+    PROFILE_ZONE("Simulation::moveEntities");
+    
+    constexpr bool spins = std::is_same_v<T, Asteroid>;
+    std::size_t count = entities.size();
+    
+    std::pmr::vector<float> x(count, &scratch);
+    std::pmr::vector<float> y(count, &scratch);
+    std::pmr::vector<float> velocityX(count, &scratch);
+    std::pmr::vector<float> velocityY(count, &scratch);
+    std::pmr::vector<float> rotation(spins ? count : 0, &scratch);
+    std::pmr::vector<float> rotationSpeed(spins ? count : 0, &scratch);
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        const T& entity = entities[i];
+        sf::Vector2f position = entity.getPosition();
+        sf::Vector2f velocity = entity.getVelocity();
+        x[i] = position.x;
+        y[i] = position.y;
+        velocityX[i] = velocity.x;
+        velocityY[i] = velocity.y;
+        if constexpr (spins) {
+            rotation[i] = entity.getRotation();
+            rotationSpeed[i] = entity.getRotationSpeed();
+        }
+    }
+    
+    MotionKernel::integrate(x.data(), y.data(), velocityX.data(), velocityY.data(), count,
+                            deltaTime, worldSize.x, worldSize.y);
+    if constexpr (spins) {
+        MotionKernel::advanceAngles(rotation.data(), rotationSpeed.data(), count, deltaTime);
+    }
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        T& entity = entities[i];
+        if (!entity.isActive()) continue;
+        
+        entity.setPosition(sf::Vector2f(x[i], y[i]));
+        if constexpr (spins) {
+            entity.setRotation(rotation[i]);
+        }
+    }
+}
+
+// Despawn the entities of a map whose expiry ticks the wheel passes on its
+// way to a tick. They go inactive at once, so the rest of the tick already
+// treats them as gone; stale handles of entities that went early are skipped
+template <typename T>
+void expireEntities(SlotMap<T>& entities, TimingWheel& wheel, std::uint32_t tick, EntityCommandBuffer& commands)
+{
+    wheel.advance(tick, [&](SlotHandle handle) {
+        T* entity = entities.get(handle);
+        if (!entity || !entity->isActive()) return;
+        
+        entity->setInactive();
+        if constexpr (std::is_same_v<T, Bullet>) {
+            commands.despawnBullet(handle);
+        } else {
+            commands.despawnParticle(handle);
+        }
+    });
+}
+
+}
+
+Simulation::Simulation(const SimulationConfig& config)
+    : m_config(config)
+    , m_rng(config.seed)
+    , m_effectsRng(config.seed ^ 0x5bd1e995u)
+    , m_exhaustTimer(0.0f)
+    , m_collisionStats()
+    , m_scratch(32 * 1024)
+    , m_gameState(GameState::MainMenu)
+    , m_score(0)
+    , m_level(1)
+    , m_levelRunning(false)
+    , m_player()
+    , m_lifetimeClock(0.0)
+    , m_timelineClock(0.0)
+    , m_introEndTick(0)
+    , m_shieldRunning(false)
+    , m_shieldStartTick(0)
+{
+    m_asteroids.reserve(64);
+    m_bullets.reserve(32);
+    m_particles.reserve(512);
+    m_bulletExpiry.reserve(32);
+    m_particleExpiry.reserve(512);
+    m_commands.reserve(64, 32, 512);
+    m_sleepingSectors.configure(m_config.worldSize);
+    m_asteroidIndex.configure(m_config.worldSize);
+    m_collisionQueries.reserve(64, 64);
+    m_timeline.reserve(2);
+    m_levelCleared = m_timeline.createEvent();
+    m_stepTimeline.reserve(2);
+    m_playerShielded = m_stepTimeline.createEvent();
+    
+    m_player.reset(getSpawnPosition());
+    startTimeline();
+}
+
+void Simulation::startGame()
+{
+    resetGame();
+    m_gameState = GameState::Playing;
+}
+
+void Simulation::togglePause()
+{
+    if (m_gameState == GameState::Playing) {
+        m_gameState = GameState::Paused;
+    } else if (m_gameState == GameState::Paused) {
+        m_gameState = GameState::Playing;
+    }
+}
+
+void Simulation::update(const PlayerInput& input, float deltaTime)
+{
+    PROFILE_ZONE("Simulation::update");
+    AllocationScope allocationScope(AllocationTag::Update);
+    
+    // Events and scratch memory only describe the latest tick
+    m_events.clear();
+    m_scratch.reset();
+    m_collisionStats = CollisionStats();
+    
+    // Don't update if paused or in menu
+    if (m_gameState != GameState::Playing) {
+        return;
+    }
+    
+    // Fire a bullet (allowed during the level start delay)
+    if (input.fire && createBullet()) {
+        m_events.push(GameEventType::BulletFired, m_player.getPosition());
+    }
+    
+    // Level intros due by now, and whatever was woken at the end of the
+    // previous tick
+    m_timelineClock += deltaTime;
+    m_timeline.advance(getTimelineTick());
+    
+    bool stepped = false;
+    if (m_levelRunning) {
+        step(input, deltaTime);
+        stepped = true;
+    }
+    
+    // Entities spawned or killed this tick appear or go, all at once
+    applyCommands();
+    
+    // Sleepers keep time with the awake asteroids, so they hold still
+    // through the level start delay like everything else
+    if (stepped) {
+        m_sleepingSectors.update(m_asteroids, m_player.getPosition(), deltaTime);
+    }
+    m_asteroidIndex.sync(m_asteroids);
+    
+    // The level is cleared once the live counts of awake and sleeping
+    // asteroids are both down to zero; the next one starts on the next tick
+    if (m_levelRunning && m_asteroids.empty() && m_sleepingSectors.empty()) {
+        m_levelRunning = false;
+        m_timeline.signal(m_levelCleared);
+    }
+    
+    // Check for game over
+    if (m_player.getLives() <= 0) {
+        m_gameState = GameState::GameOver;
+    }
+}
+
+void Simulation::step(const PlayerInput& input, float deltaTime)
+{
+    // Update player
+    m_player.handleInput(input, deltaTime);
+    m_player.update(deltaTime, m_config.worldSize);
+    
+    // Update bullets, asteroids and particles
+    moveEntities(m_bullets, deltaTime, m_config.worldSize, m_scratch);
+    moveEntities(m_asteroids, deltaTime, m_config.worldSize, m_scratch);
+    moveEntities(m_particles, deltaTime, m_config.worldSize, m_scratch);
+    
+    // Lifetimes run out on the whole ticks the clock passes, usually one
+    m_lifetimeClock += deltaTime;
+    std::uint32_t lifetimeTick = getLifetimeTick();
+    m_stepTimeline.advance(lifetimeTick);
+    expireEntities(m_bullets, m_bulletExpiry, lifetimeTick, m_commands);
+    expireEntities(m_particles, m_particleExpiry, lifetimeTick, m_commands);
+    
+    // Check collisions
+    {
+        AllocationScope collisionScope(AllocationTag::Collision);
+        m_asteroidIndex.sync(m_asteroids);
+        m_collisionStats = Collision::checkCollisions(m_player, m_bullets, m_asteroids, m_asteroidIndex,
+                                                      m_collisionQueries, m_score, getSpawnPosition(),
+                                                      m_rng, m_events, m_commands);
+    }
+    
+    // A hit respawns the player invulnerable; the timeline runs the window
+    for (const GameEvent& event : m_events.getEvents()) {
+        if (event.type == GameEventType::PlayerHit) {
+            m_stepTimeline.signal(m_playerShielded);
+        }
+    }
+    
+    spawnEffects(deltaTime);
+}
+
+void Simulation::setEffectsQuality(const EffectsQuality& quality)
+{
+    m_effectsQuality = quality;
+}
+
+const EffectsQuality& Simulation::getEffectsQuality() const
+{
+    return m_effectsQuality;
+}
+
+GameState Simulation::getState() const
+{
+    return m_gameState;
+}
+
+int Simulation::getScore() const
+{
+    return m_score;
+}
+
+int Simulation::getLevel() const
+{
+    return m_level;
+}
+
+const sf::Vector2f& Simulation::getWorldSize() const
+{
+    return m_config.worldSize;
+}
+
+unsigned int Simulation::getSeed() const
+{
+    return m_config.seed;
+}
+
+const Player& Simulation::getPlayer() const
+{
+    return m_player;
+}
+
+Player& Simulation::getPlayer()
+{
+    return m_player;
+}
+
+const SlotMap<Asteroid>& Simulation::getAsteroids() const
+{
+    return m_asteroids;
+}
+
+SlotMap<Asteroid>& Simulation::getAsteroids()
+{
+    return m_asteroids;
+}
+
+const SlotMap<Bullet>& Simulation::getBullets() const
+{
+    return m_bullets;
+}
+
+SlotMap<Bullet>& Simulation::getBullets()
+{
+    return m_bullets;
+}
+
+const SlotMap<Particle>& Simulation::getParticles() const
+{
+    return m_particles;
+}
+
+SlotMap<Particle>& Simulation::getParticles()
+{
+    return m_particles;
+}
+
+std::size_t Simulation::getSleepingAsteroidCount() const
+{
+    return m_sleepingSectors.size();
+}
+
+const SpatialIndex& Simulation::getAsteroidIndex() const
+{
+    return m_asteroidIndex;
+}
+
+const GameEventQueue& Simulation::getEvents() const
+{
+    return m_events;
+}
+
+const CollisionStats& Simulation::getCollisionStats() const
+{
+    return m_collisionStats;
+}
+
+void Simulation::capture(FrameSnapshot& snapshot) const
+{
+    PROFILE_ZONE("Simulation::capture");
+    
+    snapshot.clear();
+    snapshot.state = m_gameState;
+    snapshot.score = m_score;
+    snapshot.level = m_level;
+    snapshot.lives = m_player.getLives();
+    snapshot.worldWidth = m_config.worldSize.x;
+    snapshot.worldHeight = m_config.worldSize.y;
+    
+    snapshot.player.x = m_player.getPosition().x;
+    snapshot.player.y = m_player.getPosition().y;
+    snapshot.player.rotation = m_player.getRotation();
+    snapshot.player.visible = m_player.isVisible();
+    snapshot.player.thrusting = m_player.isThrusting();
+    
+    for (const Asteroid& asteroid : m_asteroids) {
+        if (!asteroid.isActive()) continue;
+        
+        SnapshotAsteroid entry;
+        entry.x = asteroid.getPosition().x;
+        entry.y = asteroid.getPosition().y;
+        entry.rotation = asteroid.getRotation();
+        entry.firstVertex = static_cast<std::uint32_t>(snapshot.asteroidVertices.size() / 2);
+        entry.vertexCount = static_cast<std::uint32_t>(asteroid.getVertexCount());
+        for (std::size_t i = 0; i < asteroid.getVertexCount(); ++i) {
+            sf::Vector2f vertex = asteroid.getVertex(i);
+            snapshot.asteroidVertices.push_back(vertex.x);
+            snapshot.asteroidVertices.push_back(vertex.y);
+        }
+        snapshot.asteroids.push_back(entry);
+    }
+    
+    for (const Bullet& bullet : m_bullets) {
+        if (!bullet.isActive()) continue;
+        snapshot.bullets.push_back({bullet.getPosition().x, bullet.getPosition().y, bullet.getRadius()});
+    }
+    
+    // Particles fade by the time left to their expiry tick
+    float lifetimeNow = static_cast<float>(m_lifetimeClock * LIFETIME_TICKS_PER_SECOND);
+    for (const Particle& particle : m_particles) {
+        if (!particle.isActive()) continue;
+        sf::Color color = particle.getColor(lifetimeNow);
+        snapshot.particles.push_back({particle.getPosition().x, particle.getPosition().y,
+                                      {color.r, color.g, color.b, color.a}});
+    }
+}
+
+void Simulation::saveState(StateWriter& out) const
+{
+    PROFILE_ZONE("Simulation::saveState");
+    
+    out.write(m_rng);
+    out.write(m_effectsRng);
+    out.write(m_exhaustTimer);
+    out.write(m_gameState);
+    out.write(m_score);
+    out.write(m_level);
+    out.write(m_levelRunning);
+    
+    m_player.save(out);
+    m_asteroids.save(out);
+    m_bullets.save(out);
+    m_particles.save(out);
+    
+    out.write(m_lifetimeClock);
+    m_bulletExpiry.save(out);
+    m_particleExpiry.save(out);
+    
+    out.write(m_timelineClock);
+    out.write(m_timeline.getTick());
+    out.write(m_introEndTick);
+    out.write(m_stepTimeline.getTick());
+    out.write(m_shieldRunning);
+    out.write(m_shieldStartTick);
+    
+    m_sleepingSectors.save(out);
+    m_asteroidIndex.save(out);
+}
+
+bool Simulation::loadState(StateReader& in)
+{
+    std::uint32_t timelineTick = 0;
+    std::uint32_t stepTick = 0;
+    
+    in.read(m_rng);
+    in.read(m_effectsRng);
+    in.read(m_exhaustTimer);
+    in.read(m_gameState);
+    in.read(m_score);
+    in.read(m_level);
+    in.read(m_levelRunning);
+    
+    m_player.load(in);
+    m_asteroids.load(in);
+    m_bullets.load(in);
+    m_particles.load(in);
+    
+    in.read(m_lifetimeClock);
+    m_bulletExpiry.load(in);
+    m_particleExpiry.load(in);
+    
+    in.read(m_timelineClock);
+    in.read(timelineTick);
+    in.read(m_introEndTick);
+    in.read(stepTick);
+    in.read(m_shieldRunning);
+    in.read(m_shieldStartTick);
+    
+    m_sleepingSectors.load(in);
+    m_asteroidIndex.load(in);
+    if (!in.isValid()) {
+        return false;
+    }
+    
+    m_events.clear();
+    m_commands.clear();
+    
+    // Spawn the tasks again where the saved ones were. A cleared level and
+    // a fresh hit were signalled but not yet picked up
+    m_timeline.clear(timelineTick);
+    m_timeline.spawn(runLevels(m_timeline, true));
+    if (!m_levelRunning && timelineTick >= m_introEndTick) {
+        m_timeline.signal(m_levelCleared);
+    }
+    
+    m_stepTimeline.clear(stepTick);
+    m_stepTimeline.spawn(runInvulnerability(m_stepTimeline, m_shieldRunning));
+    if (m_player.isInvulnerable() && !m_shieldRunning) {
+        m_stepTimeline.signal(m_playerShielded);
+    }
+    return true;
+}
+
+void Simulation::spawnEffects(float deltaTime)
+{
+    PROFILE_ZONE("Simulation::spawnEffects");
+    
+    for (const GameEvent& event : m_events.getEvents()) {
+        if (event.type == GameEventType::AsteroidDestroyed) {
+            createExplosion(event.position, sf::Color::White);
+        } else if (event.type == GameEventType::PlayerHit) {
+            createExplosion(event.position, sf::Color::Red);
+        }
+    }
+    
+    // Exhaust trail: a steady stream out of the back of the thrusting ship
+    if (!m_effectsQuality.exhaustTrail || !m_player.isThrusting()) {
+        m_exhaustTimer = 0.0f;
+        return;
+    }
+    
+    std::uniform_real_distribution<float> spreadDist(-0.3f, 0.3f);
+    std::uniform_real_distribution<float> speedDist(PARTICLE_SPEED_MIN, PARTICLE_SPEED_MAX);
+    
+    m_exhaustTimer += deltaTime;
+    while (m_exhaustTimer >= 1.0f / EXHAUST_PARTICLES_PER_SECOND) {
+        m_exhaustTimer -= 1.0f / EXHAUST_PARTICLES_PER_SECOND;
+        
+        sf::Vector2f direction = m_player.getDirection();
+        sf::Vector2f spread(-direction.y, direction.x);
+        sf::Vector2f velocity = m_player.getVelocity() -
+                                (direction + spread * spreadDist(m_effectsRng)) * speedDist(m_effectsRng);
+        m_commands.spawnParticle(m_player.getPosition() - direction * 15.0f, velocity, sf::Color(255, 160, 0),
+                                 0.4f * m_effectsQuality.particleLifetimeScale);
+    }
+}
+
+void Simulation::createExplosion(sf::Vector2f position, sf::Color color)
+{
+    std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159f);
+    std::uniform_real_distribution<float> speedDist(PARTICLE_SPEED_MIN, PARTICLE_SPEED_MAX);
+    
+    for (int i = 0; i < m_effectsQuality.particlesPerExplosion; ++i) {
+        float angle = angleDist(m_effectsRng);
+        float speed = speedDist(m_effectsRng);
+        
+        sf::Vector2f velocity(std::cos(angle) * speed, std::sin(angle) * speed);
+        
+        m_commands.spawnParticle(position, velocity, color, m_effectsQuality.particleLifetimeScale);
+    }
+}
+
+void Simulation::initLevel()
+{
+    // Clear old asteroids
+    m_asteroids.clear();
+    m_sleepingSectors.clear();
+    
+    // Number of asteroids based on level
+    int numAsteroids = 4 + (m_level - 1) * 2;
+    numAsteroids = std::min(numAsteroids, 12); // Cap at 12 asteroids
+    
+    // A world of several screens gets as many per screen, spread all over it
+    float screens = (m_config.worldSize.x * m_config.worldSize.y) /
+                    (static_cast<float>(WINDOW_WIDTH) * static_cast<float>(WINDOW_HEIGHT));
+    if (screens < 2.0f) {
+        for (int i = 0; i < numAsteroids; ++i) {
+            m_asteroids.insert(Asteroid::createRandom(m_player.getPosition(), m_config.worldSize, m_rng));
+        }
+    } else {
+        std::size_t total = static_cast<std::size_t>(numAsteroids * screens);
+        for (std::size_t i = 0; i < total; ++i) {
+            Asteroid asteroid = Asteroid::createScattered(m_player.getPosition(), m_config.worldSize, 150.0f, m_rng);
+            if (m_sleepingSectors.isFar(asteroid.getPosition(), m_player.getPosition())) {
+                m_sleepingSectors.sleep(asteroid);
+            } else {
+                m_asteroids.insert(asteroid);
+            }
+        }
+    }
+    
+    m_asteroidIndex.sync(m_asteroids);
+}
+
+TimelineTask Simulation::runLevels(Timeline& timeline, bool resume)
+{
+    for (;;) {
+        if (!resume) {
+            initLevel();
+            m_introEndTick = timeline.getTick() + toTicks(LEVEL_INTRO_TIME, TIMELINE_TICKS_PER_SECOND);
+        }
+        resume = false;
+        
+        if (!m_levelRunning && timeline.getTick() < m_introEndTick) {
+            co_await timeline.delay(m_introEndTick - timeline.getTick());
+            m_levelRunning = true;
+        }
+        co_await timeline.wait(m_levelCleared);
+        m_level++;
+    }
+}
+
+TimelineTask Simulation::runInvulnerability(Timeline& timeline, bool resume)
+{
+    const std::uint32_t windowTicks = toTicks(PLAYER_INVULNERABILITY_TIME, LIFETIME_TICKS_PER_SECOND);
+    const std::uint32_t blinkTicks = toTicks(PLAYER_BLINK_INTERVAL / 2.0f, LIFETIME_TICKS_PER_SECOND);
+    
+    // The player can only be hit while vulnerable, so a window always ends
+    // before the next one is signalled
+    for (;;) {
+        if (!resume) {
+            co_await timeline.wait(m_playerShielded);
+            m_shieldRunning = true;
+            m_shieldStartTick = timeline.getTick();
+        }
+        resume = false;
+        
+        // Hidden for the first half of every blink, starting from the blink
+        // a resumed window is in
+        std::uint32_t firstBlink = (timeline.getTick() - m_shieldStartTick) / blinkTicks * blinkTicks;
+        for (std::uint32_t elapsed = firstBlink; elapsed < windowTicks; elapsed += blinkTicks) {
+            m_player.setBlinkVisible((elapsed / blinkTicks) % 2 == 1);
+            std::uint32_t blinkEnd = m_shieldStartTick + std::min(elapsed + blinkTicks, windowTicks);
+            co_await timeline.delay(blinkEnd - timeline.getTick());
+        }
+        m_player.endInvulnerability();
+        m_shieldRunning = false;
+    }
+}
+
+void Simulation::startTimeline()
+{
+    m_levelRunning = false;
+    m_timelineClock = 0.0;
+    m_timeline.clear();
+    m_timeline.spawn(runLevels(m_timeline, false));
+    m_shieldRunning = false;
+    m_stepTimeline.clear();
+    m_stepTimeline.spawn(runInvulnerability(m_stepTimeline, false));
+    
+    // The player starts out invulnerable too, from when the first level starts
+    m_stepTimeline.signal(m_playerShielded);
+}
+
+bool Simulation::createBullet()
+{
+    if (!m_player.canFire()) {
+        return false;
+    }
+    
+    // Get player position and direction
+    sf::Vector2f position = m_player.getPosition();
+    sf::Vector2f direction = m_player.getDirection();
+    
+    // Offset the bullet position to start at the nose of the ship
+    position += direction * 20.0f;
+    
+    // Create the bullet at the end of the tick
+    m_commands.spawnBullet(position, direction);
+    
+    // Reset player's fire cooldown
+    m_player.updateFireCooldown(FIRE_COOLDOWN);
+    return true;
+}
+
+void Simulation::applyCommands()
+{
+    PROFILE_ZONE("Simulation::applyCommands");
+    
+    // Only the entities spawned or despawned this tick are touched
+    m_commands.apply(m_asteroids, m_bullets, m_particles, m_rng, m_effectsRng, m_bulletExpiry, m_particleExpiry);
+    
+    // Room for the next tick's collision lookups, one per bullet and the player's
+    m_collisionQueries.reserve(m_bullets.size() + 1, m_bullets.size() + 1);
+}
+
+void Simulation::resetGame()
+{
+    m_events.clear();
+    m_commands.clear();
+    m_score = 0;
+    m_level = 1;
+    m_player.reset(getSpawnPosition());
+    m_player.setLives(3);
+    m_bullets.clear();
+    m_asteroids.clear();
+    m_sleepingSectors.clear();
+    m_particles.clear();
+    m_bulletExpiry.clear();
+    m_particleExpiry.clear();
+    m_lifetimeClock = 0.0;
+    
+    startTimeline();
+}
+
+std::uint32_t Simulation::getLifetimeTick() const
+{
+    return wholeTicks(m_lifetimeClock, LIFETIME_TICKS_PER_SECOND);
+}
+
+std::uint32_t Simulation::getTimelineTick() const
+{
+    return wholeTicks(m_timelineClock, TIMELINE_TICKS_PER_SECOND);
+}
+
+sf::Vector2f Simulation::getSpawnPosition() const
+{
+    return m_config.worldSize / 2.0f;
+}
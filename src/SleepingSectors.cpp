@@ -0,0 +1,315 @@
+#include "SleepingSectors.hpp"
+#include "MotionKernel.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// Sectors looked at around the player along each axis: the awake zone and
+// the ring just outside it that sleepers can drift in from
+constexpr int WAKE_SPAN = 2 * (SleepingSectors::ACTIVE_RADIUS + 1) + 1;
+
+// Number of sectors along one side of the world
+int getSectorCount(float worldLength)
+{
+    return std::max(1, static_cast<int>(worldLength / SleepingSectors::SECTOR_SIZE));
+}
+
+// First sector and count to visit along one axis around the player's sector;
+// every sector once if the axis is shorter than the span
+void getSpan(int playerCell, int count, int& first, int& length)
+{
+    if (count <= WAKE_SPAN) {
+        first = 0;
+        length = count;
+    } else {
+        first = playerCell - (SleepingSectors::ACTIVE_RADIUS + 1);
+        length = WAKE_SPAN;
+    }
+}
+
+int wrapCell(int cell, int count)
+{
+    cell %= count;
+    return cell < 0 ? cell + count : cell;
+}
+
+}
+
+SleepingSectors::SleepingSectors()
+    : m_columns(1)
+    , m_rows(1)
+    , m_enabled(false)
+    , m_count(0)
+    , m_time(0.0)
+    , m_rebucketCursor(0)
+    , m_rebucketBudget(0.0f)
+{
+}
+
+void SleepingSectors::configure(const sf::Vector2f& worldSize)
+{
+    m_worldSize = worldSize;
+    m_columns = getSectorCount(worldSize.x);
+    m_rows = getSectorCount(worldSize.y);
+    m_sectorSize = sf::Vector2f(worldSize.x / m_columns, worldSize.y / m_rows);
+    
+    // Something can only be asleep if some sector is further away than the
+    // band where awake asteroids stay awake
+    m_enabled = m_columns > WAKE_SPAN || m_rows > WAKE_SPAN;
+    
+    m_sectors.clear();
+    m_sectors.resize(m_enabled ? static_cast<std::size_t>(m_columns) * m_rows : 0);
+    m_count = 0;
+    m_time = 0.0;
+    m_rebucketCursor = 0;
+    m_rebucketBudget = 0.0f;
+}
+
+bool SleepingSectors::isEnabled() const
+{
+    return m_enabled;
+}
+
+void SleepingSectors::clear()
+{
+    for (std::vector<Sleeper>& sector : m_sectors) {
+        sector.clear();
+    }
+    m_count = 0;
+}
+
+void SleepingSectors::save(StateWriter& out) const
+{
+    // Field by field with only the vertices in use, which is under half the
+    // size of the struct in a large world's worth of sleepers
+    out.write(static_cast<std::uint64_t>(m_sectors.size()));
+    for (const std::vector<Sleeper>& sector : m_sectors) {
+        out.write(static_cast<std::uint64_t>(sector.size()));
+        for (const Sleeper& sleeper : sector) {
+            out.write(sleeper.position);
+            out.write(sleeper.velocity);
+            out.write(sleeper.rotation);
+            out.write(sleeper.rotationSpeed);
+            out.write(sleeper.since);
+            out.write(sleeper.size);
+            out.write(sleeper.vertexCount);
+            out.writeArray(sleeper.vertices.data(), sleeper.vertexCount);
+        }
+    }
+    out.write(static_cast<std::uint64_t>(m_count));
+    out.write(m_time);
+    out.write(static_cast<std::uint64_t>(m_rebucketCursor));
+    out.write(m_rebucketBudget);
+}
+
+bool SleepingSectors::load(StateReader& in)
+{
+    std::uint64_t sectors = 0;
+    if (!in.read(sectors) || sectors != m_sectors.size()) {
+        in.fail();
+        return false;
+    }
+    
+    std::size_t filed = 0;
+    for (std::vector<Sleeper>& sector : m_sectors) {
+        std::uint64_t sleepers = 0;
+        if (!in.read(sleepers) || sleepers > in.getRemaining()) {
+            in.fail();
+            break;
+        }
+        
+        sector.resize(static_cast<std::size_t>(sleepers));
+        filed += sector.size();
+        for (Sleeper& sleeper : sector) {
+            in.read(sleeper.position);
+            in.read(sleeper.velocity);
+            in.read(sleeper.rotation);
+            in.read(sleeper.rotationSpeed);
+            in.read(sleeper.since);
+            in.read(sleeper.size);
+            if (in.read(sleeper.vertexCount) && sleeper.vertexCount > sleeper.vertices.size()) {
+                in.fail();
+            }
+            if (!in.readArray(sleeper.vertices.data(), sleeper.vertexCount)) {
+                break;
+            }
+        }
+    }
+    
+    std::uint64_t count = 0;
+    std::uint64_t cursor = 0;
+    in.read(count);
+    in.read(m_time);
+    in.read(cursor);
+    in.read(m_rebucketBudget);
+    m_count = static_cast<std::size_t>(count);
+    m_rebucketCursor = static_cast<std::size_t>(cursor);
+    
+    bool consistent = in.isValid() && m_count == filed &&
+                      (m_sectors.empty() || m_rebucketCursor < m_sectors.size());
+    if (!consistent) {
+        in.fail();
+        clear();
+    }
+    return consistent;
+}
+
+bool SleepingSectors::isFar(const sf::Vector2f& position, const sf::Vector2f& playerPosition) const
+{
+    return m_enabled && getDistance(getCell(position), getCell(playerPosition)) > ACTIVE_RADIUS + 1;
+}
+
+void SleepingSectors::sleep(const Asteroid& asteroid)
+{
+    Sleeper sleeper;
+    sleeper.position = asteroid.getPosition();
+    sleeper.velocity = asteroid.getVelocity();
+    sleeper.rotation = asteroid.getRotation();
+    sleeper.rotationSpeed = asteroid.getRotationSpeed();
+    sleeper.since = m_time;
+    sleeper.size = asteroid.getSize();
+    sleeper.vertexCount = static_cast<std::uint8_t>(std::min<std::size_t>(asteroid.getVertexCount(),
+                                                                          sleeper.vertices.size()));
+    for (std::size_t i = 0; i < sleeper.vertexCount; ++i) {
+        sleeper.vertices[i] = asteroid.getVertex(i);
+    }
+    
+    m_sectors[getIndex(getCell(sleeper.position))].push_back(sleeper);
+    m_count++;
+}
+
+void SleepingSectors::update(SlotMap<Asteroid>& asteroids, const sf::Vector2f& playerPosition, float deltaTime)
+{
+    if (!m_enabled) {
+        return;
+    }
+    
+    PROFILE_ZONE("SleepingSectors::update");
+    
+    m_time += deltaTime;
+    rebucket(deltaTime);
+    
+    // Sleepers are filed less than a sector from where they are, so only
+    // sectors within one of the awake zone can hold any that belong in it
+    Cell playerCell = getCell(playerPosition);
+    int firstColumn, columnCount, firstRow, rowCount;
+    getSpan(playerCell.x, m_columns, firstColumn, columnCount);
+    getSpan(playerCell.y, m_rows, firstRow, rowCount);
+    
+    // Collect the leavers before waking anyone, so the asteroids just woken
+    // aren't looked at again
+    m_leaving.clear();
+    for (std::size_t i = 0; i < asteroids.size(); ++i) {
+        if (isFar(asteroids[i].getPosition(), playerPosition)) {
+            m_leaving.push_back(asteroids.handleAt(i));
+        }
+    }
+    
+    for (int row = 0; row < rowCount; ++row) {
+        for (int column = 0; column < columnCount; ++column) {
+            Cell cell = {wrapCell(firstColumn + column, m_columns), wrapCell(firstRow + row, m_rows)};
+            wakeSector(getIndex(cell), playerCell, asteroids);
+        }
+    }
+    
+    for (const SlotHandle& handle : m_leaving) {
+        sleep(*asteroids.get(handle));
+        asteroids.erase(handle);
+    }
+}
+
+std::size_t SleepingSectors::size() const
+{
+    return m_count;
+}
+
+bool SleepingSectors::empty() const
+{
+    return m_count == 0;
+}
+
+SleepingSectors::Cell SleepingSectors::getCell(const sf::Vector2f& position) const
+{
+    // Wrapping can round up to exactly the world size, which is the last sector
+    int x = static_cast<int>(position.x / m_sectorSize.x);
+    int y = static_cast<int>(position.y / m_sectorSize.y);
+    return {std::clamp(x, 0, m_columns - 1), std::clamp(y, 0, m_rows - 1)};
+}
+
+std::size_t SleepingSectors::getIndex(Cell cell) const
+{
+    return static_cast<std::size_t>(cell.y) * m_columns + cell.x;
+}
+
+int SleepingSectors::getDistance(Cell a, Cell b) const
+{
+    int dx = std::abs(a.x - b.x);
+    int dy = std::abs(a.y - b.y);
+    dx = std::min(dx, m_columns - dx);
+    dy = std::min(dy, m_rows - dy);
+    return std::max(dx, dy);
+}
+
+void SleepingSectors::catchUp(Sleeper& sleeper) const
+{
+    float elapsed = static_cast<float>(m_time - sleeper.since);
+    sleeper.position.x = MotionKernel::wrap(sleeper.position.x + sleeper.velocity.x * elapsed, m_worldSize.x);
+    sleeper.position.y = MotionKernel::wrap(sleeper.position.y + sleeper.velocity.y * elapsed, m_worldSize.y);
+    sleeper.rotation = MotionKernel::wrap(sleeper.rotation + sleeper.rotationSpeed * elapsed, 360.0f);
+    sleeper.since = m_time;
+}
+
+void SleepingSectors::wakeSector(std::size_t index, Cell playerCell, SlotMap<Asteroid>& asteroids)
+{
+    std::vector<Sleeper>& sector = m_sectors[index];
+    
+    std::size_t i = 0;
+    while (i < sector.size()) {
+        Sleeper& sleeper = sector[i];
+        catchUp(sleeper);
+        if (getDistance(getCell(sleeper.position), playerCell) > ACTIVE_RADIUS) {
+            ++i;
+            continue;
+        }
+        
+        asteroids.emplace(sleeper.position, sleeper.velocity, sleeper.rotation, sleeper.rotationSpeed,
+                          sleeper.size, sleeper.vertices.data(), static_cast<std::size_t>(sleeper.vertexCount));
+        sleeper = sector.back();
+        sector.pop_back();
+        m_count--;
+    }
+}
+
+void SleepingSectors::rebucket(float deltaTime)
+{
+    // Visit every sector at least once in the time the fastest asteroid
+    // takes to cross half a sector, so none gets a whole sector away from
+    // where it's filed
+    const float period = 0.5f * std::min(m_sectorSize.x, m_sectorSize.y) / ASTEROID_SPEED_MAX;
+    m_rebucketBudget += static_cast<float>(m_sectors.size()) * deltaTime / period;
+    
+    while (m_rebucketBudget >= 1.0f) {
+        m_rebucketBudget -= 1.0f;
+        
+        std::size_t index = m_rebucketCursor;
+        m_rebucketCursor = (m_rebucketCursor + 1) % m_sectors.size();
+        
+        std::size_t i = 0;
+        while (i < m_sectors[index].size()) {
+            Sleeper& sleeper = m_sectors[index][i];
+            catchUp(sleeper);
+            std::size_t target = getIndex(getCell(sleeper.position));
+            if (target == index) {
+                ++i;
+                continue;
+            }
+            
+            m_sectors[target].push_back(sleeper);
+            m_sectors[index][i] = m_sectors[index].back();
+            m_sectors[index].pop_back();
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "SnapshotCodec.hpp"
+#include <cstring>
+
+namespace {
+
+std::uint32_t floatBits(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(std::uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::uint32_t packColor(const SnapshotColor& color)
+{
+    return static_cast<std::uint32_t>(color.r) |
+           static_cast<std::uint32_t>(color.g) << 8 |
+           static_cast<std::uint32_t>(color.b) << 16 |
+           static_cast<std::uint32_t>(color.a) << 24;
+}
+
+SnapshotColor unpackColor(std::uint32_t word)
+{
+    SnapshotColor color;
+    color.r = static_cast<std::uint8_t>(word);
+    color.g = static_cast<std::uint8_t>(word >> 8);
+    color.b = static_cast<std::uint8_t>(word >> 16);
+    color.a = static_cast<std::uint8_t>(word >> 24);
+    return color;
+}
+
+}
+
+namespace SnapshotCodec {
+
+const Quantiser EXACT = {floatBits, bitsFloat, floatBits, bitsFloat};
+
+void flatten(const FrameSnapshot& snapshot, const Quantiser& quantiser, std::vector<std::uint32_t>& words)
+{
+    words.clear();
+    words.push_back(static_cast<std::uint32_t>(snapshot.state));
+    words.push_back(static_cast<std::uint32_t>(snapshot.score));
+    words.push_back(static_cast<std::uint32_t>(snapshot.level));
+    words.push_back(static_cast<std::uint32_t>(snapshot.lives));
+    words.push_back(quantiser.position(snapshot.worldWidth));
+    words.push_back(quantiser.position(snapshot.worldHeight));
+    words.push_back(quantiser.position(snapshot.player.x));
+    words.push_back(quantiser.position(snapshot.player.y));
+    words.push_back(quantiser.angle(snapshot.player.rotation));
+    words.push_back((snapshot.player.visible ? 1u : 0u) | (snapshot.player.thrusting ? 2u : 0u));
+    words.push_back(static_cast<std::uint32_t>(snapshot.asteroids.size()));
+    words.push_back(static_cast<std::uint32_t>(snapshot.asteroidVertices.size()));
+    words.push_back(static_cast<std::uint32_t>(snapshot.bullets.size()));
+    words.push_back(static_cast<std::uint32_t>(snapshot.particles.size()));
+    
+    for (const SnapshotAsteroid& asteroid : snapshot.asteroids) {
+        words.push_back(quantiser.position(asteroid.x));
+        words.push_back(quantiser.position(asteroid.y));
+        words.push_back(quantiser.angle(asteroid.rotation));
+        words.push_back(asteroid.firstVertex);
+        words.push_back(asteroid.vertexCount);
+    }
+    for (float vertex : snapshot.asteroidVertices) {
+        words.push_back(quantiser.position(vertex));
+    }
+    for (const SnapshotBullet& bullet : snapshot.bullets) {
+        words.push_back(quantiser.position(bullet.x));
+        words.push_back(quantiser.position(bullet.y));
+        words.push_back(quantiser.position(bullet.radius));
+    }
+    for (const SnapshotParticle& particle : snapshot.particles) {
+        words.push_back(quantiser.position(particle.x));
+        words.push_back(quantiser.position(particle.y));
+        words.push_back(packColor(particle.color));
+    }
+}
+
+bool unflatten(const std::vector<std::uint32_t>& words, const Quantiser& quantiser, FrameSnapshot& snapshot)
+{
+    if (words.size() < FIXED_WORDS) {
+        return false;
+    }
+    
+    std::size_t asteroids = words[10];
+    std::size_t vertices = words[11];
+    std::size_t bullets = words[12];
+    std::size_t particles = words[13];
+    if (words.size() != FIXED_WORDS + asteroids * 5 + vertices + bullets * 3 + particles * 3) {
+        return false;
+    }
+    
+    snapshot.clear();
+    snapshot.state = static_cast<GameState>(words[0]);
+    snapshot.score = static_cast<int>(words[1]);
+    snapshot.level = static_cast<int>(words[2]);
+    snapshot.lives = static_cast<int>(words[3]);
+    snapshot.worldWidth = quantiser.unposition(words[4]);
+    snapshot.worldHeight = quantiser.unposition(words[5]);
+    snapshot.player.x = quantiser.unposition(words[6]);
+    snapshot.player.y = quantiser.unposition(words[7]);
+    snapshot.player.rotation = quantiser.unangle(words[8]);
+    snapshot.player.visible = (words[9] & 1u) != 0;
+    snapshot.player.thrusting = (words[9] & 2u) != 0;
+    
+    const std::uint32_t* word = words.data() + FIXED_WORDS;
+    for (std::size_t i = 0; i < asteroids; ++i, word += 5) {
+        snapshot.asteroids.push_back({quantiser.unposition(word[0]), quantiser.unposition(word[1]),
+                                      quantiser.unangle(word[2]), word[3], word[4]});
+        if (static_cast<std::size_t>(word[3]) + word[4] > vertices / 2) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < vertices; ++i, ++word) {
+        snapshot.asteroidVertices.push_back(quantiser.unposition(*word));
+    }
+    for (std::size_t i = 0; i < bullets; ++i, word += 3) {
+        snapshot.bullets.push_back({quantiser.unposition(word[0]), quantiser.unposition(word[1]),
+                                    quantiser.unposition(word[2])});
+    }
+    for (std::size_t i = 0; i < particles; ++i, word += 3) {
+        snapshot.particles.push_back({quantiser.unposition(word[0]), quantiser.unposition(word[1]), unpackColor(word[2])});
+    }
+    return true;
+}
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool getVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && data < end; shift += 7) {
+        std::uint8_t byte = *data++;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,604 @@
+#include "SoftwareRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ASTEROIDS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ASTEROIDS_NEON 1
+#endif
+
+namespace {
+
+constexpr SnapshotColor WHITE{255, 255, 255, 255};
+constexpr SnapshotColor RED{255, 0, 0, 255};
+constexpr SnapshotColor YELLOW{255, 255, 0, 255};
+
+// 5x7 glyphs for ' ' to 'Z', one byte per row, bit 4 is the leftmost column
+constexpr std::uint8_t FONT[][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // '!'
+    {0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x0A, 0x1F, 0x0A, 0x0A, 0x0A, 0x1F, 0x0A}, // '#'
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, // '$'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, // '&'
+    {0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00}, // '''
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, // '*'
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ','
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, // ';'
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // '<'
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // '='
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // '>'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // '?'
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, // '@'
+    {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}, // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+};
+
+// Glyph cell is 6x10 font pixels: 5x7 plus spacing, roughly matching the
+// cap height of the HUD font at the same character size
+constexpr float GLYPH_ADVANCE = 6.0f;
+constexpr float GLYPH_LINE = 10.0f;
+
+const std::uint8_t* glyphFor(char c)
+{
+    if (c >= 'a' && c <= 'z') {
+        c = static_cast<char>(c - 'a' + 'A');
+    }
+    if (c < ' ' || c > 'Z') {
+        return FONT[0];
+    }
+    return FONT[c - ' '];
+}
+
+std::uint8_t luma(SnapshotColor color)
+{
+    return static_cast<std::uint8_t>((color.r * 77 + color.g * 150 + color.b * 29) >> 8);
+}
+
+// Rotate a local-space point by degrees and move it to a position
+void transformPoint(float x, float y, float cosine, float sine, float positionX, float positionY,
+                    float scaleX, float scaleY, float* out)
+{
+    out[0] = (positionX + x * cosine - y * sine) * scaleX;
+    out[1] = (positionY + x * sine + y * cosine) * scaleY;
+}
+
+}
+
+SoftwareRenderer::SoftwareRenderer(unsigned int width, unsigned int height, PixelFormat format)
+    : m_width(0)
+    , m_height(0)
+    , m_format(format)
+    , m_pixels(nullptr)
+    , m_worldScaleX(1.0f)
+    , m_worldScaleY(1.0f)
+    , m_hudScaleX(1.0f)
+    , m_hudScaleY(1.0f)
+{
+    resize(width, height);
+}
+
+void SoftwareRenderer::resize(unsigned int width, unsigned int height)
+{
+    m_width = width;
+    m_height = height;
+    m_buffer.assign(getBufferSize(), 0);
+    m_pixels = m_buffer.data();
+}
+
+void SoftwareRenderer::bindTarget(std::uint8_t* pixels)
+{
+    m_pixels = pixels ? pixels : m_buffer.data();
+}
+
+unsigned int SoftwareRenderer::getWidth() const
+{
+    return m_width;
+}
+
+unsigned int SoftwareRenderer::getHeight() const
+{
+    return m_height;
+}
+
+PixelFormat SoftwareRenderer::getFormat() const
+{
+    return m_format;
+}
+
+std::size_t SoftwareRenderer::getBytesPerPixel() const
+{
+    return m_format == PixelFormat::RGBA8 ? 4 : 1;
+}
+
+std::size_t SoftwareRenderer::getBufferSize() const
+{
+    return static_cast<std::size_t>(m_width) * m_height * getBytesPerPixel();
+}
+
+const std::uint8_t* SoftwareRenderer::getPixels() const
+{
+    return m_pixels;
+}
+
+void SoftwareRenderer::render(const FrameSnapshot& snapshot)
+{
+    m_worldScaleX = m_width / snapshot.worldWidth;
+    m_worldScaleY = m_height / snapshot.worldHeight;
+    m_hudScaleX = m_width / static_cast<float>(WINDOW_WIDTH);
+    m_hudScaleY = m_height / static_cast<float>(WINDOW_HEIGHT);
+    
+    clear(SnapshotColor{0, 0, 0, 255});
+    
+    if (snapshot.state != GameState::MainMenu) {
+        renderWorld(snapshot);
+    }
+    renderHud(snapshot);
+}
+
+void SoftwareRenderer::clear(SnapshotColor color)
+{
+    for (unsigned int y = 0; y < m_height; ++y) {
+        fillSpan(static_cast<int>(y), 0, static_cast<int>(m_width) - 1, SnapshotColor{color.r, color.g, color.b, 255});
+    }
+}
+
+void SoftwareRenderer::fillSpan(int y, int x0, int x1, SnapshotColor color)
+{
+    if (y < 0 || y >= static_cast<int>(m_height) || color.a == 0) {
+        return;
+    }
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, static_cast<int>(m_width) - 1);
+    if (x0 > x1) {
+        return;
+    }
+    
+    std::size_t count = static_cast<std::size_t>(x1 - x0 + 1);
+    
+    if (m_format == PixelFormat::Gray8) {
+        std::uint8_t* row = m_pixels + static_cast<std::size_t>(y) * m_width + x0;
+        std::uint8_t value = luma(color);
+        if (color.a == 255) {
+            std::memset(row, value, count);
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                row[i] = static_cast<std::uint8_t>((row[i] * (256 - color.a) + value * color.a) >> 8);
+            }
+        }
+        return;
+    }
+    
+    std::uint8_t* row = m_pixels + (static_cast<std::size_t>(y) * m_width + x0) * 4;
+    
+    if (color.a == 255) {
+        // Opaque: store 4 pixels per vector
+        std::uint32_t packed;
+        const std::uint8_t bytes[4] = {color.r, color.g, color.b, 255};
+        std::memcpy(&packed, bytes, 4);
+
+#if defined(ASTEROIDS_SSE2)
+        const __m128i value = _mm_set1_epi32(static_cast<int>(packed));
+        for (; count >= 4; count -= 4, row += 16) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row), value);
+        }
+#elif defined(ASTEROIDS_NEON)
+        const uint8x16_t value = vreinterpretq_u8_u32(vdupq_n_u32(packed));
+        for (; count >= 4; count -= 4, row += 16) {
+            vst1q_u8(row, value);
+        }
+#endif
+        for (; count > 0; --count, row += 4) {
+            std::memcpy(row, &packed, 4);
+        }
+        return;
+    }
+    
+    // Translucent: dst = (dst * (256 - a) + src * a) >> 8 per channel. The
+    // source alpha lane is 255 so an opaque buffer stays opaque.
+    const unsigned int alpha = color.a;
+    const unsigned int inverse = 256 - alpha;
+
+#if defined(ASTEROIDS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weighted = _mm_setr_epi16(
+        static_cast<short>(color.r * alpha), static_cast<short>(color.g * alpha),
+        static_cast<short>(color.b * alpha), static_cast<short>(255 * alpha),
+        static_cast<short>(color.r * alpha), static_cast<short>(color.g * alpha),
+        static_cast<short>(color.b * alpha), static_cast<short>(255 * alpha));
+    const __m128i weight = _mm_set1_epi16(static_cast<short>(inverse));
+    for (; count >= 4; count -= 4, row += 16) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        low = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(low, weight), weighted), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(high, weight), weighted), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_packus_epi16(low, high));
+    }
+#elif defined(ASTEROIDS_NEON)
+    const std::uint8_t sourceBytes[16] = {
+        color.r, color.g, color.b, 255, color.r, color.g, color.b, 255,
+        color.r, color.g, color.b, 255, color.r, color.g, color.b, 255
+    };
+    const uint8x16_t sourceVector = vld1q_u8(sourceBytes);
+    const uint8x8_t alphaVector = vdup_n_u8(static_cast<std::uint8_t>(alpha));
+    const uint8x8_t inverseVector = vdup_n_u8(static_cast<std::uint8_t>(inverse - 1));
+    for (; count >= 4; count -= 4, row += 16) {
+        uint8x16_t pixels = vld1q_u8(row);
+        // dst * (255 - a) + dst + src * a == dst * (256 - a) + src * a
+        uint16x8_t low = vmull_u8(vget_low_u8(pixels), inverseVector);
+        uint16x8_t high = vmull_u8(vget_high_u8(pixels), inverseVector);
+        low = vaddw_u8(low, vget_low_u8(pixels));
+        high = vaddw_u8(high, vget_high_u8(pixels));
+        low = vmlal_u8(low, vget_low_u8(sourceVector), alphaVector);
+        high = vmlal_u8(high, vget_high_u8(sourceVector), alphaVector);
+        vst1q_u8(row, vcombine_u8(vshrn_n_u16(low, 8), vshrn_n_u16(high, 8)));
+    }
+#endif
+    const std::uint8_t source[4] = {color.r, color.g, color.b, 255};
+    for (; count > 0; --count, row += 4) {
+        for (int channel = 0; channel < 4; ++channel) {
+            row[channel] = static_cast<std::uint8_t>((row[channel] * inverse + source[channel] * alpha) >> 8);
+        }
+    }
+}
+
+void SoftwareRenderer::drawLine(float x0, float y0, float x1, float y1, SnapshotColor color)
+{
+    // Walk the rows the segment crosses and fill the run of pixels it covers
+    // in each, so shallow lines become long spans instead of single pixels
+    if (y0 > y1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    
+    const float dy = y1 - y0;
+    const float slope = dy > 1e-6f ? (x1 - x0) / dy : 0.0f;
+    const int firstRow = std::max(static_cast<int>(std::floor(y0)), 0);
+    const int lastRow = std::min(static_cast<int>(std::floor(y1)), static_cast<int>(m_height) - 1);
+    
+    for (int row = firstRow; row <= lastRow; ++row) {
+        float xa, xb;
+        if (dy > 1e-6f) {
+            float top = std::max(y0, static_cast<float>(row));
+            float bottom = std::min(y1, static_cast<float>(row + 1));
+            xa = x0 + (top - y0) * slope;
+            xb = x0 + (bottom - y0) * slope;
+        } else {
+            xa = x0;
+            xb = x1;
+        }
+        fillSpan(row, static_cast<int>(std::floor(std::min(xa, xb))),
+                 static_cast<int>(std::floor(std::max(xa, xb))), color);
+    }
+}
+
+void SoftwareRenderer::fillRect(float x, float y, float width, float height, SnapshotColor color)
+{
+    int firstRow = static_cast<int>(std::lround(y));
+    int lastRow = static_cast<int>(std::lround(y + height)) - 1;
+    int firstColumn = static_cast<int>(std::lround(x));
+    int lastColumn = static_cast<int>(std::lround(x + width)) - 1;
+    
+    // Always cover at least one pixel so tiny shapes don't vanish at low resolution
+    lastRow = std::max(lastRow, firstRow);
+    lastColumn = std::max(lastColumn, firstColumn);
+    
+    for (int row = firstRow; row <= lastRow; ++row) {
+        fillSpan(row, firstColumn, lastColumn, color);
+    }
+}
+
+void SoftwareRenderer::fillCircle(float centerX, float centerY, float radius, SnapshotColor color)
+{
+    int firstRow = static_cast<int>(std::floor(centerY - radius));
+    int lastRow = static_cast<int>(std::floor(centerY + radius));
+    
+    for (int row = firstRow; row <= lastRow; ++row) {
+        float dy = row + 0.5f - centerY;
+        float halfWidth = std::sqrt(std::max(radius * radius - dy * dy, 0.0f));
+        fillSpan(row, static_cast<int>(std::floor(centerX - halfWidth)),
+                 static_cast<int>(std::floor(centerX + halfWidth)), color);
+    }
+}
+
+void SoftwareRenderer::fillConvexPolygon(const float* points, std::size_t count, SnapshotColor color)
+{
+    if (count < 3) {
+        return;
+    }
+    
+    float top = points[1];
+    float bottom = points[1];
+    for (std::size_t i = 1; i < count; ++i) {
+        top = std::min(top, points[i * 2 + 1]);
+        bottom = std::max(bottom, points[i * 2 + 1]);
+    }
+    
+    int firstRow = std::max(static_cast<int>(std::floor(top)), 0);
+    int lastRow = std::min(static_cast<int>(std::floor(bottom)), static_cast<int>(m_height) - 1);
+    
+    // Sample each row at its centre against every edge
+    for (int row = firstRow; row <= lastRow; ++row) {
+        float sampleY = row + 0.5f;
+        float left = 1e30f;
+        float right = -1e30f;
+    
+        for (std::size_t i = 0; i < count; ++i) {
+            const float* a = points + i * 2;
+            const float* b = points + ((i + 1) % count) * 2;
+            if ((a[1] <= sampleY && b[1] > sampleY) || (b[1] <= sampleY && a[1] > sampleY)) {
+                float x = a[0] + (sampleY - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+                left = std::min(left, x);
+                right = std::max(right, x);
+            }
+        }
+    
+        if (left <= right) {
+            fillSpan(row, static_cast<int>(std::lround(left)), static_cast<int>(std::lround(right)) - 1, color);
+        }
+    }
+}
+
+void SoftwareRenderer::drawPolygonOutline(const float* points, std::size_t count, SnapshotColor color)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        const float* a = points + i * 2;
+        const float* b = points + ((i + 1) % count) * 2;
+        drawLine(a[0], a[1], b[0], b[1], color);
+    }
+}
+
+void SoftwareRenderer::drawText(float x, float y, const char* text, float size, SnapshotColor color)
+{
+    const float cell = size / GLYPH_LINE;
+    float penX = x;
+    float penY = y;
+    
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            penX = x;
+            penY += size;
+            continue;
+        }
+    
+        const std::uint8_t* glyph = glyphFor(*c);
+        for (int row = 0; row < 7; ++row) {
+            // Merge runs of set bits into one rectangle each
+            int column = 0;
+            while (column < 5) {
+                if (!(glyph[row] & (0x10 >> column))) {
+                    ++column;
+                    continue;
+                }
+                int start = column;
+                while (column < 5 && (glyph[row] & (0x10 >> column))) {
+                    ++column;
+                }
+                fillRect(penX + start * cell, penY + row * cell, (column - start) * cell, cell, color);
+            }
+        }
+        penX += GLYPH_ADVANCE * cell;
+    }
+}
+
+float SoftwareRenderer::measureText(const char* text, float size) const
+{
+    std::size_t longest = 0;
+    std::size_t current = 0;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            current = 0;
+            continue;
+        }
+        longest = std::max(longest, ++current);
+    }
+    return longest * GLYPH_ADVANCE * size / GLYPH_LINE;
+}
+
+void SoftwareRenderer::renderWorld(const FrameSnapshot& snapshot)
+{
+    constexpr float DEGREES_TO_RADIANS = 3.14159f / 180.0f;
+    float points[2 * 32];
+    
+    // Asteroids: white outlines
+    for (const SnapshotAsteroid& asteroid : snapshot.asteroids) {
+        float cosine = std::cos(asteroid.rotation * DEGREES_TO_RADIANS);
+        float sine = std::sin(asteroid.rotation * DEGREES_TO_RADIANS);
+        std::size_t count = std::min<std::size_t>(asteroid.vertexCount, 32);
+        const float* local = snapshot.asteroidVertices.data() + asteroid.firstVertex * 2;
+    
+        for (std::size_t i = 0; i < count; ++i) {
+            transformPoint(local[i * 2], local[i * 2 + 1], cosine, sine, asteroid.x, asteroid.y,
+                           m_worldScaleX, m_worldScaleY, points + i * 2);
+        }
+        drawPolygonOutline(points, count, WHITE);
+    }
+    
+    // Bullets: filled circles
+    for (const SnapshotBullet& bullet : snapshot.bullets) {
+        float radius = std::max(bullet.radius * m_worldScaleX, 0.5f);
+        fillCircle(bullet.x * m_worldScaleX, bullet.y * m_worldScaleY, radius, WHITE);
+    }
+    
+    // Particles: 2x2 squares fading out
+    for (const SnapshotParticle& particle : snapshot.particles) {
+        fillRect((particle.x - 1.0f) * m_worldScaleX, (particle.y - 1.0f) * m_worldScaleY,
+                 2.0f * m_worldScaleX, 2.0f * m_worldScaleY, particle.color);
+    }
+    
+    // Player ship and flame (hidden on the game over screen, as in Game::render)
+    const SnapshotPlayer& player = snapshot.player;
+    if (snapshot.state == GameState::GameOver || !player.visible) {
+        return;
+    }
+    
+    float cosine = std::cos(player.rotation * DEGREES_TO_RADIANS);
+    float sine = std::sin(player.rotation * DEGREES_TO_RADIANS);
+    
+    static constexpr float SHIP[] = {20.0f, 0.0f, -10.0f, -10.0f, -10.0f, 10.0f};
+    for (int i = 0; i < 3; ++i) {
+        transformPoint(SHIP[i * 2], SHIP[i * 2 + 1], cosine, sine, player.x, player.y,
+                       m_worldScaleX, m_worldScaleY, points + i * 2);
+    }
+    drawPolygonOutline(points, 3, WHITE);
+    
+    if (player.thrusting) {
+        static constexpr float FLAME[] = {-10.0f, 0.0f, -20.0f, -5.0f, -20.0f, 5.0f};
+        for (int i = 0; i < 3; ++i) {
+            transformPoint(FLAME[i * 2], FLAME[i * 2 + 1], cosine, sine, player.x, player.y,
+                           m_worldScaleX, m_worldScaleY, points + i * 2);
+        }
+        fillConvexPolygon(points, 3, YELLOW);
+        drawPolygonOutline(points, 3, RED);
+    }
+}
+
+void SoftwareRenderer::drawCenteredText(float x, float y, const char* text, float size, SnapshotColor color)
+{
+    // Count lines so multi-line text is centred as a block
+    int lines = 1;
+    for (const char* c = text; *c; ++c) {
+        lines += (*c == '\n') ? 1 : 0;
+    }
+    
+    float scale = std::min(m_hudScaleX, m_hudScaleY);
+    float pixelSize = size * scale;
+    float width = measureText(text, pixelSize);
+    float height = lines * pixelSize;
+    drawText(x * m_hudScaleX - width / 2.0f, y * m_hudScaleY - height / 2.0f, text, pixelSize, color);
+}
+
+void SoftwareRenderer::renderHud(const FrameSnapshot& snapshot)
+{
+    const float width = static_cast<float>(WINDOW_WIDTH);
+    const float height = static_cast<float>(WINDOW_HEIGHT);
+    const float scale = std::min(m_hudScaleX, m_hudScaleY);
+    char text[64];
+    
+    switch (snapshot.state) {
+        case GameState::MainMenu:
+            drawCenteredText(width / 2.0f, height / 3.0f, "ASTEROIDS", 72.0f, WHITE);
+            drawCenteredText(width / 2.0f, height / 2.0f + 60.0f, "Press SPACE to start", 32.0f, WHITE);
+            drawCenteredText(width / 2.0f, height / 2.0f + 150.0f,
+                             "Controls:\nArrow Keys/WASD - Move\nSpace - Fire\nP - Pause", 24.0f, WHITE);
+            break;
+    
+        case GameState::Playing:
+        case GameState::Paused: {
+            std::snprintf(text, sizeof(text), "Score: %d", snapshot.score);
+            drawText(20.0f * m_hudScaleX, 20.0f * m_hudScaleY, text, 24.0f * scale, WHITE);
+    
+            std::snprintf(text, sizeof(text), "Lives: %d", snapshot.lives);
+            drawText(20.0f * m_hudScaleX, 50.0f * m_hudScaleY, text, 24.0f * scale, WHITE);
+    
+            // Ship icons for lives, after the label (the bitmap font is wider than the TTF one)
+            static constexpr float ICON[] = {10.0f, 0.0f, -5.0f, -5.0f, -5.0f, 5.0f};
+            float iconsX = std::max(110.0f, 35.0f + measureText(text, 24.0f * scale) / m_hudScaleX);
+            float points[6];
+            for (int i = 0; i < snapshot.lives && i < 16; ++i) {
+                for (int v = 0; v < 3; ++v) {
+                    // Rotated -90 degrees: (x, y) -> (y, -x)
+                    transformPoint(ICON[v * 2], ICON[v * 2 + 1], 0.0f, -1.0f, iconsX + i * 25.0f, 60.0f,
+                                   m_hudScaleX, m_hudScaleY, points + v * 2);
+                }
+                fillConvexPolygon(points, 3, WHITE);
+            }
+    
+            std::snprintf(text, sizeof(text), "Level: %d", snapshot.level);
+            drawText((width - 150.0f) * m_hudScaleX, 20.0f * m_hudScaleY, text, 24.0f * scale, WHITE);
+    
+            if (snapshot.state == GameState::Paused) {
+                fillRect(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height), SnapshotColor{0, 0, 0, 150});
+                drawCenteredText(width / 2.0f, height / 2.0f - 50.0f, "PAUSED", 64.0f, WHITE);
+                drawCenteredText(width / 2.0f, height / 2.0f + 50.0f, "Press P to resume", 32.0f, WHITE);
+            }
+            break;
+        }
+    
+        case GameState::GameOver:
+            fillRect(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height), SnapshotColor{0, 0, 0, 200});
+            drawCenteredText(width / 2.0f, height / 2.0f - 60.0f, "GAME OVER", 64.0f, RED);
+            std::snprintf(text, sizeof(text), "Final Score: %d", snapshot.score);
+            drawCenteredText(width / 2.0f, height / 2.0f, text, 32.0f, WHITE);
+            drawCenteredText(width / 2.0f, height / 2.0f + 60.0f, "Press SPACE to restart", 24.0f, WHITE);
+            break;
+    }
+}
+
+bool SoftwareRenderer::saveToFile(const std::string& path) const
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    
+    bool gray = m_format == PixelFormat::Gray8;
+    std::fprintf(file, "%s\n%u %u\n255\n", gray ? "P5" : "P6", m_width, m_height);
+    
+    bool ok = true;
+    if (gray) {
+        ok = std::fwrite(m_pixels, 1, getBufferSize(), file) == getBufferSize();
+    } else {
+        // Drop alpha one row at a time
+        std::vector<std::uint8_t> row(static_cast<std::size_t>(m_width) * 3);
+        for (unsigned int y = 0; y < m_height && ok; ++y) {
+            const std::uint8_t* source = m_pixels + static_cast<std::size_t>(y) * m_width * 4;
+            for (unsigned int x = 0; x < m_width; ++x) {
+                row[x * 3 + 0] = source[x * 4 + 0];
+                row[x * 3 + 1] = source[x * 4 + 1];
+                row[x * 3 + 2] = source[x * 4 + 2];
+            }
+            ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+    }
+    
+    return std::fclose(file) == 0 && ok;
+}
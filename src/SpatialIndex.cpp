@@ -0,0 +1,579 @@
+#include "SpatialIndex.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+int getCellCount(float worldLength)
+{
+    int count = static_cast<int>(std::ceil(worldLength / SpatialIndex::MIN_CELL_SIZE));
+    return std::clamp(count, 1, SpatialIndex::MAX_CELLS);
+}
+
+int wrapCell(int cell, int count)
+{
+    cell %= count;
+    return cell < 0 ? cell + count : cell;
+}
+
+// Offsets from a cell that reach each of count cells once: [-(count-1)/2, count/2]
+int getLowestOffset(int count)
+{
+    return -((count - 1) / 2);
+}
+
+int getHighestOffset(int count)
+{
+    return count / 2;
+}
+
+bool isCloser(const SpatialHit& a, const SpatialHit& b)
+{
+    return a.distance < b.distance;
+}
+
+// Stand-in for a map's entities in verify()
+struct Probe {
+    sf::Vector2f position;
+    float radius;
+    
+    bool isActive() const { return true; }
+    sf::Vector2f getPosition() const { return position; }
+    float getRadius() const { return radius; }
+};
+
+// Distances from a query agree if they are within float rounding of each other
+bool isSameDistance(float a, float b)
+{
+    return std::fabs(a - b) <= 1.0e-2f + 1.0e-4f * std::fabs(b);
+}
+
+bool isSameDistances(const std::vector<SpatialHit>& a, const std::vector<float>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (!isSameDistance(a[i].distance, b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Shortest offset from a to b along an axis that wraps at size, in double
+double wrapDelta(double a, double b, double size)
+{
+    double delta = b - a;
+    return delta - size * std::round(delta / size);
+}
+
+}
+
+SpatialIndex::SpatialIndex()
+    : m_columns(1)
+    , m_rows(1)
+    , m_maxRadius(0.0f)
+    , m_count(0)
+    , m_stamp(0)
+{
+    configure(sf::Vector2f(MIN_CELL_SIZE, MIN_CELL_SIZE));
+}
+
+void SpatialIndex::configure(const sf::Vector2f& worldSize)
+{
+    m_worldSize = worldSize;
+    m_columns = getCellCount(worldSize.x);
+    m_rows = getCellCount(worldSize.y);
+    m_cellSize = sf::Vector2f(worldSize.x / m_columns, worldSize.y / m_rows);
+    
+    m_heads.assign(static_cast<std::size_t>(m_columns) * m_rows, NONE);
+    m_nodes.clear();
+    m_count = 0;
+    m_maxRadius = 0.0f;
+}
+
+void SpatialIndex::clear()
+{
+    std::fill(m_heads.begin(), m_heads.end(), NONE);
+    for (Node& node : m_nodes) {
+        node.cell = NONE;
+    }
+    m_count = 0;
+}
+
+void SpatialIndex::save(StateWriter& out) const
+{
+    out.write(m_maxRadius);
+    out.writeVector(m_heads);
+    out.writeVector(m_nodes);
+    out.write(static_cast<std::uint64_t>(m_count));
+    out.write(m_stamp);
+}
+
+bool SpatialIndex::load(StateReader& in)
+{
+    std::size_t cells = m_heads.size();
+    std::uint64_t count = 0;
+    in.read(m_maxRadius);
+    in.readVector(m_heads);
+    in.readVector(m_nodes);
+    in.read(count);
+    in.read(m_stamp);
+    m_count = static_cast<std::size_t>(count);
+    
+    // Every list has to stay within the nodes, and every node within the grid
+    auto isNode = [this](std::uint32_t node) {
+        return node == NONE || node < m_nodes.size();
+    };
+    bool consistent = in.isValid() && m_heads.size() == cells && std::all_of(m_heads.begin(), m_heads.end(), isNode);
+    for (std::size_t i = 0; consistent && i < m_nodes.size(); ++i) {
+        const Node& node = m_nodes[i];
+        consistent = isNode(node.previous) && isNode(node.next) && (node.cell == NONE || node.cell < cells);
+    }
+    if (!consistent) {
+        in.fail();
+        m_heads.assign(cells, NONE);
+        m_nodes.clear();
+        m_count = 0;
+    }
+    return consistent;
+}
+
+std::size_t SpatialIndex::queryCircle(sf::Vector2f center, float radius, std::vector<SpatialHit>& hits) const
+{
+    std::size_t firstHit = hits.size();
+    std::size_t tested = 0;
+    
+    // Any entity overlapping the circle has its centre within this reach
+    float reach = radius + m_maxRadius;
+    int firstColumn = getColumn(center.x - reach);
+    int firstRow = getRow(center.y - reach);
+    int columnCount = std::min(getColumn(center.x + reach) - firstColumn + 1, m_columns);
+    int rowCount = std::min(getRow(center.y + reach) - firstRow + 1, m_rows);
+    
+    for (int row = 0; row < rowCount; ++row) {
+        for (int column = 0; column < columnCount; ++column) {
+            std::uint32_t next = m_heads[getCell(firstColumn + column, firstRow + row)];
+            for (; next != NONE; next = m_nodes[next].next) {
+                const Node& entry = m_nodes[next];
+                tested++;
+                sf::Vector2f delta = getDelta(center, entry.position);
+                float distance = std::hypot(delta.x, delta.y);
+                if (distance < radius + entry.radius) {
+                    hits.push_back({entry.handle, delta, distance});
+                }
+            }
+        }
+    }
+    
+    std::sort(hits.begin() + firstHit, hits.end(), isCloser);
+    return tested;
+}
+
+std::size_t SpatialIndex::queryNearest(sf::Vector2f center, std::size_t count, std::vector<SpatialHit>& hits) const
+{
+    std::size_t firstHit = hits.size();
+    std::size_t tested = 0;
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Search rings of cells outwards from the centre's cell until the
+    // closest count are known: nothing past ring r is nearer than r cells
+    int centerColumn = getColumn(center.x);
+    int centerRow = getRow(center.y);
+    int lowColumn = getLowestOffset(m_columns), highColumn = getHighestOffset(m_columns);
+    int lowRow = getLowestOffset(m_rows), highRow = getHighestOffset(m_rows);
+    int lastRing = std::max({-lowColumn, highColumn, -lowRow, highRow});
+    float ringWidth = std::min(m_cellSize.x, m_cellSize.y);
+    
+    for (int ring = 0; ring <= lastRing; ++ring) {
+        for (int dy = std::max(-ring, lowRow); dy <= std::min(ring, highRow); ++dy) {
+            // Whole rows at the top and bottom of the ring, just the ends in between
+            bool edgeRow = dy == -ring || dy == ring;
+            int step = edgeRow ? 1 : 2 * ring;
+            for (int dx = -ring; dx <= ring; dx += std::max(step, 1)) {
+                if (dx < lowColumn || dx > highColumn) continue;
+                
+                std::uint32_t next = m_heads[getCell(centerColumn + dx, centerRow + dy)];
+                for (; next != NONE; next = m_nodes[next].next) {
+                    const Node& entry = m_nodes[next];
+                    tested++;
+                    sf::Vector2f delta = getDelta(center, entry.position);
+                    hits.push_back({entry.handle, delta, std::hypot(delta.x, delta.y)});
+                }
+            }
+        }
+        
+        // Keep only the closest count found so far
+        std::size_t found = hits.size() - firstHit;
+        if (found >= count) {
+            std::partial_sort(hits.begin() + firstHit, hits.begin() + firstHit + count, hits.end(), isCloser);
+            hits.resize(firstHit + count);
+            if (hits.back().distance <= ring * ringWidth) {
+                return tested;
+            }
+        }
+    }
+    
+    std::sort(hits.begin() + firstHit, hits.end(), isCloser);
+    return tested;
+}
+
+bool SpatialIndex::raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance, SpatialHit& hit) const
+{
+    float length = std::hypot(direction.x, direction.y);
+    if (length <= 0.0f || maxDistance < 0.0f) {
+        return false;
+    }
+    direction /= length;
+    
+    // Past one crossing of the world along either axis the walk would only
+    // go on wrapping, for ever if the ray is endless
+    const float infinity = std::numeric_limits<float>::infinity();
+    float crossX = direction.x != 0.0f ? m_worldSize.x / std::fabs(direction.x) : infinity;
+    float crossY = direction.y != 0.0f ? m_worldSize.y / std::fabs(direction.y) : infinity;
+    maxDistance = std::min(maxDistance, std::min(crossX, crossY));
+    
+    // Walk the cells the ray crosses (in unwrapped coordinates, so it keeps
+    // going across the edges), testing each one's neighbours too, since an
+    // entity can reach into a cell it isn't filed under
+    int column = getColumn(origin.x);
+    int row = getRow(origin.y);
+    int stepColumn = direction.x < 0.0f ? -1 : 1;
+    int stepRow = direction.y < 0.0f ? -1 : 1;
+    float deltaX = direction.x != 0.0f ? m_cellSize.x / std::fabs(direction.x) : infinity;
+    float deltaY = direction.y != 0.0f ? m_cellSize.y / std::fabs(direction.y) : infinity;
+    float boundaryX = (column + (stepColumn > 0 ? 1 : 0)) * m_cellSize.x;
+    float boundaryY = (row + (stepRow > 0 ? 1 : 0)) * m_cellSize.y;
+    float nextX = direction.x != 0.0f ? (boundaryX - origin.x) / direction.x : infinity;
+    float nextY = direction.y != 0.0f ? (boundaryY - origin.y) / direction.y : infinity;
+    
+    int neighbours = static_cast<int>(std::ceil(m_maxRadius / std::min(m_cellSize.x, m_cellSize.y)));
+    float best = infinity;
+    
+    float entered = 0.0f;
+    while (entered <= maxDistance) {
+        sf::Vector2f cellCenter((column + 0.5f) * m_cellSize.x, (row + 0.5f) * m_cellSize.y);
+        
+        for (int dy = -neighbours; dy <= neighbours; ++dy) {
+            for (int dx = -neighbours; dx <= neighbours; ++dx) {
+                std::uint32_t next = m_heads[getCell(column + dx, row + dy)];
+                for (; next != NONE; next = m_nodes[next].next) {
+                    const Node& entry = m_nodes[next];
+                    
+                    // The entity's copy next to this stretch of the ray
+                    sf::Vector2f position = cellCenter + getDelta(cellCenter, entry.position);
+                    sf::Vector2f toCenter = position - origin;
+                    float along = toCenter.x * direction.x + toCenter.y * direction.y;
+                    bool inside = toCenter.x * toCenter.x + toCenter.y * toCenter.y <= entry.radius * entry.radius;
+                    if (!inside && along < 0.0f) continue;
+                    
+                    // From the square of the ray's distance to the centre, not
+                    // along squared less |toCenter| squared, which a float
+                    // can't tell apart thousands of pixels away
+                    sf::Vector2f across = toCenter - direction * along;
+                    float discriminant = entry.radius * entry.radius - (across.x * across.x + across.y * across.y);
+                    if (discriminant < 0.0f) continue;
+                    
+                    float distance = std::max(0.0f, along - std::sqrt(discriminant));
+                    if (distance <= maxDistance && distance < best) {
+                        best = distance;
+                        hit = {entry.handle, toCenter, distance};
+                    }
+                }
+            }
+        }
+        
+        // Every entity reaching this stretch of the ray has been tested, so a
+        // hit before the ray leaves the cell can't be beaten
+        float left = std::min(nextX, nextY);
+        if (best <= left) {
+            return true;
+        }
+        
+        entered = left;
+        if (nextX < nextY) {
+            column += stepColumn;
+            nextX += deltaX;
+        } else {
+            row += stepRow;
+            nextY += deltaY;
+        }
+    }
+    
+    return best != infinity;
+}
+
+std::size_t SpatialIndex::size() const
+{
+    return m_count;
+}
+
+std::size_t SpatialIndex::verify(unsigned int seed, std::size_t count)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float infinity = std::numeric_limits<float>::infinity();
+    constexpr int QUERIES = 256;
+    
+    std::size_t mismatches = 0;
+    std::vector<SpatialHit> hits;
+    std::vector<float> expected;
+    
+    // Worlds of a few screens with the smallest cells, and one big enough
+    // to get cells larger than MIN_CELL_SIZE
+    const sf::Vector2f worlds[] = {
+        {1024.0f + std::floor(unit(rng) * 3072.0f), 768.0f + std::floor(unit(rng) * 2304.0f)},
+        {1024.0f + std::floor(unit(rng) * 3072.0f), 768.0f + std::floor(unit(rng) * 2304.0f)},
+        {50000.0f + std::floor(unit(rng) * 20000.0f), 40000.0f + std::floor(unit(rng) * 10000.0f)}
+    };
+    for (const sf::Vector2f& world : worlds) {
+        auto randomPoint = [&]() {
+            return sf::Vector2f(unit(rng) * world.x, unit(rng) * world.y);
+        };
+        
+        SlotMap<Probe> probes;
+        for (std::size_t i = 0; i < count; ++i) {
+            probes.insert({randomPoint(), 2.0f + unit(rng) * 38.0f});
+        }
+        SpatialIndex index;
+        index.configure(world);
+        index.sync(probes);
+        
+        for (int query = 0; query < QUERIES; ++query) {
+            // Circles of every size up to several cells
+            sf::Vector2f center = randomPoint();
+            float radius = unit(rng) * 600.0f;
+            hits.clear();
+            index.queryCircle(center, radius, hits);
+            expected.clear();
+            for (const Probe& probe : probes) {
+                double dx = wrapDelta(center.x, probe.position.x, world.x);
+                double dy = wrapDelta(center.y, probe.position.y, world.y);
+                double distance = std::hypot(dx, dy);
+                if (distance < radius + probe.radius) {
+                    expected.push_back(static_cast<float>(distance));
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            mismatches += isSameDistances(hits, expected) ? 0 : 1;
+            
+            // The closest few, and sometimes more than there are
+            std::size_t nearest = query % 16 == 0 ? count + 1 : 1 + rng() % 8;
+            hits.clear();
+            index.queryNearest(center, nearest, hits);
+            expected.clear();
+            for (const Probe& probe : probes) {
+                double dx = wrapDelta(center.x, probe.position.x, world.x);
+                double dy = wrapDelta(center.y, probe.position.y, world.y);
+                expected.push_back(static_cast<float>(std::hypot(dx, dy)));
+            }
+            std::sort(expected.begin(), expected.end());
+            expected.resize(std::min(nearest, expected.size()));
+            mismatches += isSameDistances(hits, expected) ? 0 : 1;
+            
+            // Rays in any direction and along the axes, short, long and
+            // endless, against every copy of every entity they can reach
+            float angle = query % 8 == 0 ? (query / 8 % 4) * 1.5707964f : unit(rng) * 6.2831855f;
+            sf::Vector2f direction(std::cos(angle), std::sin(angle));
+            if (query % 8 == 0) {
+                direction = sf::Vector2f(std::round(direction.x), std::round(direction.y));
+            }
+            float maxDistance = query % 3 == 0 ? infinity : query % 3 == 1 ? 1.0e10f : unit(rng) * world.x;
+            float crossX = direction.x != 0.0f ? world.x / std::fabs(direction.x) : infinity;
+            float crossY = direction.y != 0.0f ? world.y / std::fabs(direction.y) : infinity;
+            float reach = std::min(maxDistance, std::min(crossX, crossY));
+            
+            double best = infinity;
+            for (const Probe& probe : probes) {
+                for (int copyY = -2; copyY <= 2; ++copyY) {
+                    for (int copyX = -2; copyX <= 2; ++copyX) {
+                        double toX = probe.position.x + copyX * static_cast<double>(world.x) - center.x;
+                        double toY = probe.position.y + copyY * static_cast<double>(world.y) - center.y;
+                        double along = toX * direction.x + toY * direction.y;
+                        double acrossX = toX - along * direction.x;
+                        double acrossY = toY - along * direction.y;
+                        double radiusSquared = static_cast<double>(probe.radius) * probe.radius;
+                        bool inside = toX * toX + toY * toY <= radiusSquared;
+                        double discriminant = radiusSquared - (acrossX * acrossX + acrossY * acrossY);
+                        if ((!inside && along < 0.0) || discriminant < 0.0) continue;
+                        
+                        double distance = std::max(0.0, along - std::sqrt(discriminant));
+                        if (distance <= reach) {
+                            best = std::min(best, distance);
+                        }
+                    }
+                }
+            }
+            SpatialHit hit;
+            bool found = index.raycast(center, direction, maxDistance, hit);
+            bool agrees = found ? best != infinity && isSameDistance(hit.distance, static_cast<float>(best))
+                                : best == infinity;
+            mismatches += agrees ? 0 : 1;
+        }
+    }
+    
+    return mismatches;
+}
+
+void SpatialIndex::track(SlotHandle handle, sf::Vector2f position, float radius)
+{
+    if (handle.index >= m_nodes.size()) {
+        m_nodes.resize(handle.index + 1, {SlotHandle(), sf::Vector2f(), 0.0f, NONE, NONE, NONE, 0});
+    }
+    
+    Node& node = m_nodes[handle.index];
+    node.handle = handle;
+    node.position = position;
+    node.radius = radius;
+    node.stamp = m_stamp;
+    m_maxRadius = std::max(m_maxRadius, radius);
+    
+    // A slot reused by a new entity since the last sync just keeps its node
+    std::uint32_t cell = static_cast<std::uint32_t>(getCell(getColumn(position.x), getRow(position.y)));
+    if (node.cell != cell) {
+        if (node.cell != NONE) {
+            unlink(handle.index);
+        }
+        link(handle.index, cell);
+    }
+}
+
+void SpatialIndex::removeUnseen()
+{
+    for (std::uint32_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].cell != NONE && m_nodes[i].stamp != m_stamp) {
+            unlink(i);
+        }
+    }
+}
+
+void SpatialIndex::link(std::uint32_t node, std::uint32_t cell)
+{
+    Node& linked = m_nodes[node];
+    linked.cell = cell;
+    linked.previous = NONE;
+    linked.next = m_heads[cell];
+    if (linked.next != NONE) {
+        m_nodes[linked.next].previous = node;
+    }
+    m_heads[cell] = node;
+    m_count++;
+}
+
+void SpatialIndex::unlink(std::uint32_t node)
+{
+    Node& unlinked = m_nodes[node];
+    if (unlinked.previous != NONE) {
+        m_nodes[unlinked.previous].next = unlinked.next;
+    } else {
+        m_heads[unlinked.cell] = unlinked.next;
+    }
+    if (unlinked.next != NONE) {
+        m_nodes[unlinked.next].previous = unlinked.previous;
+    }
+    unlinked.cell = NONE;
+    m_count--;
+}
+
+int SpatialIndex::getColumn(float x) const
+{
+    return static_cast<int>(std::floor(x / m_cellSize.x));
+}
+
+int SpatialIndex::getRow(float y) const
+{
+    return static_cast<int>(std::floor(y / m_cellSize.y));
+}
+
+std::size_t SpatialIndex::getCell(int column, int row) const
+{
+    return static_cast<std::size_t>(wrapCell(row, m_rows)) * m_columns + wrapCell(column, m_columns);
+}
+
+sf::Vector2f SpatialIndex::getDelta(sf::Vector2f a, sf::Vector2f b) const
+{
+    sf::Vector2f delta = b - a;
+    delta.x -= m_worldSize.x * std::round(delta.x / m_worldSize.x);
+    delta.y -= m_worldSize.y * std::round(delta.y / m_worldSize.y);
+    return delta;
+}
+
+SpatialQueryBatch::SpatialQueryBatch()
+    : m_tested(0)
+{
+}
+
+void SpatialQueryBatch::reserve(std::size_t queries, std::size_t hits)
+{
+    m_queries.reserve(queries);
+    m_hits.reserve(hits);
+}
+
+SpatialQueryBatch::Ticket SpatialQueryBatch::addCircle(sf::Vector2f center, float radius)
+{
+    m_queries.push_back({Kind::Circle, center, sf::Vector2f(), radius, 0, 0});
+    return m_queries.size() - 1;
+}
+
+SpatialQueryBatch::Ticket SpatialQueryBatch::addNearest(sf::Vector2f center, std::size_t count)
+{
+    m_queries.push_back({Kind::Nearest, center, sf::Vector2f(), static_cast<float>(count), 0, 0});
+    return m_queries.size() - 1;
+}
+
+SpatialQueryBatch::Ticket SpatialQueryBatch::addRay(sf::Vector2f origin, sf::Vector2f direction, float maxDistance)
+{
+    m_queries.push_back({Kind::Ray, origin, direction, maxDistance, 0, 0});
+    return m_queries.size() - 1;
+}
+
+void SpatialQueryBatch::run(const SpatialIndex& index)
+{
+    PROFILE_ZONE("SpatialQueryBatch::run");
+    
+    m_hits.clear();
+    m_tested = 0;
+    for (Query& query : m_queries) {
+        query.firstHit = m_hits.size();
+        switch (query.kind) {
+            case Kind::Circle:
+                m_tested += index.queryCircle(query.point, query.extent, m_hits);
+                break;
+            case Kind::Nearest:
+                m_tested += index.queryNearest(query.point, static_cast<std::size_t>(query.extent), m_hits);
+                break;
+            case Kind::Ray: {
+                SpatialHit hit;
+                if (index.raycast(query.point, query.direction, query.extent, hit)) {
+                    m_hits.push_back(hit);
+                }
+                break;
+            }
+        }
+        query.hitCount = m_hits.size() - query.firstHit;
+    }
+}
+
+SpatialQueryBatch::Hits SpatialQueryBatch::getHits(Ticket ticket) const
+{
+    const Query& query = m_queries[ticket];
+    return {m_hits.data() + query.firstHit, query.hitCount};
+}
+
+std::size_t SpatialQueryBatch::getTestedCount() const
+{
+    return m_tested;
+}
+
+void SpatialQueryBatch::clear()
+{
+    m_queries.clear();
+    m_hits.clear();
+    m_tested = 0;
+}
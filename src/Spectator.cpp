@@ -0,0 +1,579 @@
+#include "Spectator.hpp"
+#include "FlightRecorder.hpp"
+#include "Profiler.hpp"
+#include "SnapshotCodec.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define SPECTATOR_SOCKETS
+#endif
+
+namespace {
+
+constexpr std::uint32_t FRAME_MAGIC = 0x46535341u;     // "ASSF"
+constexpr std::uint32_t HELLO_MAGIC = 0x48535341u;     // "ASSH"
+
+constexpr std::uint32_t FRAME_KEYFRAME = 1u << 0;
+constexpr std::uint32_t HELLO_WANT_KEYFRAME = 1u << 0;
+
+// Start of every datagram of a frame; the frame's payload is split over
+// chunkCount datagrams of up to CHUNK_BYTES each
+struct FrameHeader {
+    std::uint32_t magic;
+    std::uint32_t frameNumber;
+    std::uint32_t tickLow;
+    std::uint32_t tickHigh;
+    std::uint32_t wordCount;
+    std::uint32_t payloadBytes;
+    std::uint16_t chunk;
+    std::uint16_t chunkCount;
+    std::uint32_t flags;
+};
+
+struct Hello {
+    std::uint32_t magic;
+    std::uint32_t flags;
+};
+
+// Well under the 64 KiB a UDP datagram can carry
+constexpr std::size_t CHUNK_BYTES = 16 * 1024;
+
+// Broadcaster's thread naps this long when there's nothing to send
+constexpr std::chrono::milliseconds IDLE_WAIT{1};
+
+// Spectators say hello this often, and are forgotten after this long without one
+constexpr std::chrono::milliseconds HELLO_INTERVAL{1000};
+constexpr std::chrono::milliseconds SPECTATOR_TIMEOUT{5000};
+
+// Spectators ask for a keyframe at most this often while waiting for one
+constexpr std::chrono::milliseconds KEYFRAME_REQUEST_INTERVAL{100};
+
+// Positions and sizes are sent in units of 1/POSITION_SCALE
+constexpr float POSITION_SCALE = 8.0f;
+
+// Zigzag, so small negative numbers stay small varints
+std::uint32_t quantise(float value)
+{
+    std::int32_t fixed = static_cast<std::int32_t>(std::lround(value * POSITION_SCALE));
+    return (static_cast<std::uint32_t>(fixed) << 1) ^ static_cast<std::uint32_t>(fixed >> 31);
+}
+
+float dequantise(std::uint32_t word)
+{
+    std::int32_t fixed = static_cast<std::int32_t>((word >> 1) ^ (0u - (word & 1u)));
+    return static_cast<float>(fixed) / POSITION_SCALE;
+}
+
+// Degrees to 1/65536 of a turn and back
+std::uint32_t quantiseAngle(float degrees)
+{
+    return static_cast<std::uint32_t>(std::lround(degrees / 360.0f * 65536.0f)) & 0xFFFFu;
+}
+
+float dequantiseAngle(std::uint32_t word)
+{
+    return static_cast<float>(word) * (360.0f / 65536.0f);
+}
+
+const SnapshotCodec::Quantiser FIXED_POINT = {quantise, dequantise, quantiseAngle, dequantiseAngle};
+
+// The fields of current XORed with base (missing base fields count as
+// zero), as alternating runs of unchanged fields and changed ones: a varint
+// count of each, then one varint per changed field
+void encode(const std::vector<std::uint32_t>& base, const std::vector<std::uint32_t>& current,
+            std::vector<std::uint8_t>& out)
+{
+    out.clear();
+    auto changeAt = [&](std::size_t i) {
+        return current[i] ^ (i < base.size() ? base[i] : 0u);
+    };
+    
+    std::size_t i = 0;
+    while (i < current.size()) {
+        std::size_t unchanged = i;
+        while (i < current.size() && changeAt(i) == 0) {
+            i++;
+        }
+        
+        std::size_t changedStart = i;
+        while (i < current.size() && changeAt(i) != 0) {
+            i++;
+        }
+        
+        SnapshotCodec::putRun(out, changedStart - unchanged, i - changedStart);
+        for (std::size_t j = changedStart; j < i; ++j) {
+            SnapshotCodec::putVarint(out, changeAt(j));
+        }
+    }
+}
+
+// Undo encode() on top of words, which holds the base resized to the frame's length
+bool decode(const std::uint8_t* data, std::size_t size, std::vector<std::uint32_t>& words)
+{
+    auto takeChanges = [&](std::size_t i, std::size_t changed, const std::uint8_t*& bytes, const std::uint8_t* end) {
+        for (std::size_t j = 0; j < changed; ++j, ++i) {
+            std::uint64_t change;
+            if (!SnapshotCodec::getVarint(bytes, end, change)) {
+                return false;
+            }
+            words[i] ^= static_cast<std::uint32_t>(change);
+        }
+        return true;
+    };
+    return SnapshotCodec::readRuns(data, size, words.size(), takeChanges);
+}
+
+#if defined(SPECTATOR_SOCKETS)
+sockaddr_in loopbackAddress(std::uint16_t port)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+// A UDP socket that never blocks, bound to a loopback port (0 = any); -1 on failure
+int openSocket(std::uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    sockaddr_in address = loopbackAddress(port);
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+}
+
+SpectatorBroadcaster::SpectatorBroadcaster()
+    : m_socket(-1)
+    , m_running(false)
+    , m_publishedTicks(0)
+    , m_frameNumber(0)
+    , m_lastTick(0)
+    , m_keyframeWanted(true)
+    , m_spectatorCount(0)
+    , m_sentFrames(0)
+    , m_skippedFrames(0)
+    , m_droppedDatagrams(0)
+{
+}
+
+SpectatorBroadcaster::~SpectatorBroadcaster()
+{
+    stop();
+}
+
+bool SpectatorBroadcaster::start(std::uint16_t port)
+{
+    if (m_thread.joinable()) {
+        return true;
+    }
+
+#if defined(SPECTATOR_SOCKETS)
+    m_socket = openSocket(port);
+    if (m_socket < 0) {
+        return false;
+    }
+    
+    m_running.store(true);
+    m_thread = std::thread(&SpectatorBroadcaster::run, this);
+    return true;
+#else
+    (void)port;
+    return false;
+#endif
+}
+
+void SpectatorBroadcaster::stop()
+{
+    m_running.store(false);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+#if defined(SPECTATOR_SOCKETS)
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+#endif
+    m_socket = -1;
+    m_spectators.clear();
+    m_spectatorCount.store(0, std::memory_order_relaxed);
+}
+
+bool SpectatorBroadcaster::isRunning() const
+{
+    return m_thread.joinable();
+}
+
+void SpectatorBroadcaster::publish(const FrameSnapshot& snapshot)
+{
+    PROFILE_ZONE("SpectatorBroadcaster::publish");
+    
+    // Assigning keeps the buffer's capacity, so a steady game doesn't allocate
+    Frame& frame = m_frames.getWriteBuffer();
+    frame.snapshot = snapshot;
+    frame.tick = ++m_publishedTicks;
+    m_frames.publish();
+}
+
+std::size_t SpectatorBroadcaster::getSpectatorCount() const
+{
+    return m_spectatorCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t SpectatorBroadcaster::getSentFrameCount() const
+{
+    return m_sentFrames.load(std::memory_order_relaxed);
+}
+
+std::uint64_t SpectatorBroadcaster::getSkippedFrameCount() const
+{
+    return m_skippedFrames.load(std::memory_order_relaxed);
+}
+
+std::uint64_t SpectatorBroadcaster::getDroppedDatagramCount() const
+{
+    return m_droppedDatagrams.load(std::memory_order_relaxed);
+}
+
+void SpectatorBroadcaster::run()
+{
+    Profiler::setThreadName("spectators");
+    FlightRecorder::installThreadStack();
+    
+    while (m_running.load(std::memory_order_relaxed)) {
+        receiveRequests();
+        dropSilentSpectators();
+        
+        if (!m_frames.update()) {
+            // Cheaper than waking this thread from the publisher, which
+            // would need a lock there
+            std::this_thread::sleep_for(IDLE_WAIT);
+            continue;
+        }
+        
+        const Frame& frame = m_frames.getReadBuffer();
+        if (m_lastTick != 0 && frame.tick > m_lastTick + 1) {
+            m_skippedFrames.fetch_add(frame.tick - m_lastTick - 1, std::memory_order_relaxed);
+        }
+        m_lastTick = frame.tick;
+        
+        if (m_spectators.empty()) {
+            // Nobody to send to; whoever joins next starts from a keyframe
+            m_keyframeWanted = true;
+        } else {
+            sendFrame(frame);
+        }
+    }
+}
+
+void SpectatorBroadcaster::receiveRequests()
+{
+#if defined(SPECTATOR_SOCKETS)
+    auto now = std::chrono::steady_clock::now();
+    
+    Hello hello;
+    sockaddr_in from;
+    socklen_t fromSize = sizeof(from);
+    while (::recvfrom(m_socket, &hello, sizeof(hello), 0, reinterpret_cast<sockaddr*>(&from), &fromSize) ==
+           static_cast<ssize_t>(sizeof(hello))) {
+        fromSize = sizeof(from);
+        if (hello.magic != HELLO_MAGIC) {
+            continue;
+        }
+        
+        auto known = std::find_if(m_spectators.begin(), m_spectators.end(), [&](const Spectator& spectator) {
+            return spectator.address == from.sin_addr.s_addr && spectator.port == from.sin_port;
+        });
+        if (known != m_spectators.end()) {
+            known->lastHeard = now;
+            if (hello.flags & HELLO_WANT_KEYFRAME) {
+                m_keyframeWanted = true;
+            }
+        } else if (m_spectators.size() < MAX_SPECTATORS) {
+            m_spectators.push_back({from.sin_addr.s_addr, from.sin_port, now});
+            m_keyframeWanted = true;
+        }
+    }
+    m_spectatorCount.store(m_spectators.size(), std::memory_order_relaxed);
+#endif
+}
+
+void SpectatorBroadcaster::dropSilentSpectators()
+{
+    auto now = std::chrono::steady_clock::now();
+    m_spectators.erase(std::remove_if(m_spectators.begin(), m_spectators.end(), [&](const Spectator& spectator) {
+        return now - spectator.lastHeard > SPECTATOR_TIMEOUT;
+    }), m_spectators.end());
+    m_spectatorCount.store(m_spectators.size(), std::memory_order_relaxed);
+}
+
+void SpectatorBroadcaster::sendFrame(const Frame& frame)
+{
+    PROFILE_ZONE("SpectatorBroadcaster::sendFrame");
+    
+    m_frameNumber++;
+    bool keyframe = m_keyframeWanted || m_frameNumber % KEYFRAME_INTERVAL == 0;
+    m_keyframeWanted = false;
+    
+    SnapshotCodec::flatten(frame.snapshot, FIXED_POINT, m_current);
+    if (keyframe) {
+        m_previous.clear();
+    }
+    encode(m_previous, m_current, m_payload);
+    m_previous.swap(m_current);
+
+#if defined(SPECTATOR_SOCKETS)
+    FrameHeader header;
+    header.magic = FRAME_MAGIC;
+    header.frameNumber = m_frameNumber;
+    header.tickLow = static_cast<std::uint32_t>(frame.tick);
+    header.tickHigh = static_cast<std::uint32_t>(frame.tick >> 32);
+    header.wordCount = static_cast<std::uint32_t>(m_previous.size());
+    header.payloadBytes = static_cast<std::uint32_t>(m_payload.size());
+    header.chunkCount = static_cast<std::uint16_t>(std::max<std::size_t>(1, (m_payload.size() + CHUNK_BYTES - 1) / CHUNK_BYTES));
+    header.flags = keyframe ? FRAME_KEYFRAME : 0;
+    
+    for (std::uint16_t chunk = 0; chunk < header.chunkCount; ++chunk) {
+        std::size_t offset = chunk * CHUNK_BYTES;
+        std::size_t bytes = std::min(CHUNK_BYTES, m_payload.size() - offset);
+        header.chunk = chunk;
+        
+        m_datagram.resize(sizeof(header) + bytes);
+        std::memcpy(m_datagram.data(), &header, sizeof(header));
+        std::memcpy(m_datagram.data() + sizeof(header), m_payload.data() + offset, bytes);
+        
+        // Never waits: a datagram that doesn't fit is dropped, and the
+        // spectator that misses it finds the gap and asks for a keyframe
+        for (const Spectator& spectator : m_spectators) {
+            sockaddr_in to;
+            std::memset(&to, 0, sizeof(to));
+            to.sin_family = AF_INET;
+            to.sin_addr.s_addr = spectator.address;
+            to.sin_port = spectator.port;
+            if (::sendto(m_socket, m_datagram.data(), m_datagram.size(), 0,
+                         reinterpret_cast<const sockaddr*>(&to), sizeof(to)) < 0) {
+                m_droppedDatagrams.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+#endif
+
+    m_sentFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+SpectatorClient::SpectatorClient()
+    : m_socket(-1)
+    , m_port(0)
+    , m_assemblyFrame(0)
+    , m_assemblyChunks(0)
+    , m_frameNumber(0)
+    , m_haveFrame(false)
+    , m_keyframeWanted(true)
+    , m_tick(0)
+    , m_frameCount(0)
+    , m_lostFrames(0)
+{
+}
+
+SpectatorClient::~SpectatorClient()
+{
+    close();
+}
+
+bool SpectatorClient::connect(std::uint16_t port)
+{
+    close();
+
+#if defined(SPECTATOR_SOCKETS)
+    m_socket = openSocket(0);
+    if (m_socket < 0) {
+        return false;
+    }
+    
+    m_port = port;
+    m_haveFrame = false;
+    m_keyframeWanted = true;
+    m_datagram.resize(sizeof(FrameHeader) + CHUNK_BYTES);
+    sendHello();
+    return true;
+#else
+    (void)port;
+    return false;
+#endif
+}
+
+void SpectatorClient::close()
+{
+#if defined(SPECTATOR_SOCKETS)
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+#endif
+    m_socket = -1;
+}
+
+bool SpectatorClient::poll(FrameSnapshot& snapshot)
+{
+    PROFILE_ZONE("SpectatorClient::poll");
+    
+    bool updated = false;
+
+#if defined(SPECTATOR_SOCKETS)
+    if (m_socket < 0) {
+        return false;
+    }
+    
+    ssize_t received;
+    while ((received = ::recv(m_socket, m_datagram.data(), m_datagram.size(), 0)) >= 0) {
+        if (received < static_cast<ssize_t>(sizeof(FrameHeader))) {
+            continue;
+        }
+        
+        FrameHeader header;
+        std::memcpy(&header, m_datagram.data(), sizeof(header));
+        std::size_t offset = static_cast<std::size_t>(header.chunk) * CHUNK_BYTES;
+        std::size_t bytes = static_cast<std::size_t>(received) - sizeof(header);
+        if (header.magic != FRAME_MAGIC || header.chunk >= header.chunkCount ||
+            header.payloadBytes > static_cast<std::size_t>(header.chunkCount) * CHUNK_BYTES ||
+            offset > header.payloadBytes || bytes > header.payloadBytes - offset) {
+            continue;
+        }
+        
+        // A chunk of a newer frame abandons the one being put together.
+        // Keyframes are always taken, so a broadcaster that restarted its
+        // numbering is picked up again
+        if (m_chunkReceived.empty() || header.frameNumber != m_assemblyFrame) {
+            bool keyframe = (header.flags & FRAME_KEYFRAME) != 0;
+            if ((m_haveFrame && header.frameNumber <= m_frameNumber && !keyframe) ||
+                (!m_chunkReceived.empty() && header.frameNumber < m_assemblyFrame && !keyframe)) {
+                continue;
+            }
+            m_assemblyFrame = header.frameNumber;
+            m_assemblyChunks = 0;
+            m_assembly.resize(header.payloadBytes);
+            m_chunkReceived.assign(header.chunkCount, false);
+        }
+        if (m_chunkReceived.size() != header.chunkCount || m_assembly.size() != header.payloadBytes ||
+            m_chunkReceived[header.chunk]) {
+            continue;
+        }
+        
+        std::memcpy(m_assembly.data() + offset, m_datagram.data() + sizeof(header), bytes);
+        m_chunkReceived[header.chunk] = true;
+        if (++m_assemblyChunks < header.chunkCount) {
+            continue;
+        }
+        
+        // Whole frame: any numbers skipped since the last one were lost
+        m_chunkReceived.clear();
+        if (m_haveFrame && header.frameNumber > m_frameNumber + 1) {
+            m_lostFrames += header.frameNumber - m_frameNumber - 1;
+        }
+        if (applyFrame((header.flags & FRAME_KEYFRAME) != 0, header.wordCount, snapshot)) {
+            m_frameNumber = header.frameNumber;
+            m_tick = static_cast<std::uint64_t>(header.tickHigh) << 32 | header.tickLow;
+            m_frameCount++;
+            m_lastFrameTime = std::chrono::steady_clock::now();
+            updated = true;
+        } else {
+            m_lostFrames++;
+        }
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastHello > HELLO_INTERVAL || (m_keyframeWanted && now - m_lastHello > KEYFRAME_REQUEST_INTERVAL)) {
+        sendHello();
+    }
+#else
+    (void)snapshot;
+#endif
+
+    return updated;
+}
+
+bool SpectatorClient::applyFrame(bool keyframe, std::uint32_t wordCount, FrameSnapshot& snapshot)
+{
+    // A delta only applies on top of the frame right before it
+    if (!keyframe && (!m_haveFrame || m_assemblyFrame != m_frameNumber + 1)) {
+        m_haveFrame = false;
+        m_keyframeWanted = true;
+        return false;
+    }
+    
+    // The count comes straight off the network; zero runs cost next to
+    // nothing in the payload, so only a fixed limit keeps a damaged header
+    // from sizing the buffer
+    if (wordCount > SnapshotCodec::MAX_WORDS) {
+        m_haveFrame = false;
+        m_keyframeWanted = true;
+        return false;
+    }
+    
+    if (keyframe) {
+        m_words.assign(wordCount, 0u);
+    } else {
+        m_words.resize(wordCount, 0u);
+    }
+    
+    if (!decode(m_assembly.data(), m_assembly.size(), m_words) || !SnapshotCodec::unflatten(m_words, FIXED_POINT, snapshot)) {
+        m_haveFrame = false;
+        m_keyframeWanted = true;
+        return false;
+    }
+    
+    m_haveFrame = true;
+    m_keyframeWanted = false;
+    return true;
+}
+
+void SpectatorClient::sendHello()
+{
+#if defined(SPECTATOR_SOCKETS)
+    Hello hello;
+    hello.magic = HELLO_MAGIC;
+    hello.flags = m_keyframeWanted ? HELLO_WANT_KEYFRAME : 0;
+    
+    sockaddr_in to = loopbackAddress(m_port);
+    ::sendto(m_socket, &hello, sizeof(hello), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+#endif
+    m_lastHello = std::chrono::steady_clock::now();
+}
+
+std::uint64_t SpectatorClient::getTick() const
+{
+    return m_tick;
+}
+
+std::uint64_t SpectatorClient::getFrameCount() const
+{
+    return m_frameCount;
+}
+
+std::uint64_t SpectatorClient::getLostFrameCount() const
+{
+    return m_lostFrames;
+}
+
+bool SpectatorClient::isReceiving() const
+{
+    return m_frameCount > 0 && std::chrono::steady_clock::now() - m_lastFrameTime < std::chrono::seconds(1);
+}
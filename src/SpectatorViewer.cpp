@@ -0,0 +1,64 @@
+#include "SpectatorViewer.hpp"
+#include "Profiler.hpp"
+#include "Constants.hpp"
+#include <stdexcept>
+#include <string>
+
+SpectatorViewer::SpectatorViewer(std::uint16_t port)
+    : m_window(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}),
+               std::string(WINDOW_TITLE) + " - spectating port " + std::to_string(port))
+    , m_framePacer(TARGET_FRAME_RATE)
+    , m_frameArena(64 * 1024)
+    , m_ui(m_frameArena)
+    , m_port(port)
+{
+    if (!m_client.connect(port)) {
+        throw std::runtime_error("Can't open a socket to spectate port " + std::to_string(port));
+    }
+}
+
+void SpectatorViewer::run()
+{
+    Profiler::setThreadName("main");
+    m_framePacer.calibrate();
+    
+    while (m_window.isOpen()) {
+        m_framePacer.waitForNextFrame();
+        
+        while (auto event = m_window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                m_window.close();
+            }
+        }
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Escape)) {
+            m_window.close();
+        }
+        
+        m_client.poll(m_snapshot);
+        render();
+        m_frameArena.reset();
+    }
+}
+
+void SpectatorViewer::render()
+{
+    PROFILE_ZONE("SpectatorViewer::render");
+    
+    m_window.clear(sf::Color::Black);
+    if (m_client.getFrameCount() > 0) {
+        m_worldRenderer.render(m_window, m_snapshot);
+        m_ui.renderScore(m_window, m_snapshot.score);
+        m_ui.renderLives(m_window, m_snapshot.lives);
+        m_ui.renderLevel(m_window, m_snapshot.level);
+    }
+    
+    SpectatorStatus status;
+    status.port = m_port;
+    status.tick = m_client.getTick();
+    status.frames = m_client.getFrameCount();
+    status.lostFrames = m_client.getLostFrameCount();
+    status.receiving = m_client.isReceiving();
+    m_ui.renderSpectatorStatus(m_window, status);
+    
+    m_window.display();
+}
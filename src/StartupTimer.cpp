@@ -0,0 +1,178 @@
+#include "StartupTimer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#if defined(__linux__)
+#include <ctime>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Enough for every span startup marks; more are dropped
+constexpr std::size_t MAX_SPANS = 64;
+
+struct Span {
+    const char* name;
+    StartupTimer::Clock::time_point start;
+    StartupTimer::Clock::time_point end;
+    int depth;
+};
+
+struct Report {
+    std::mutex mutex;
+    Span spans[MAX_SPANS];
+    std::size_t count = 0;
+    std::size_t dropped = 0;
+};
+
+Report& getReport()
+{
+    static Report report;
+    return report;
+}
+
+std::atomic<bool> g_finished{false};
+
+// Nesting depth of the scopes open on this thread
+thread_local int t_depth = 0;
+
+#if defined(__linux__)
+// Seconds since the kernel created this process, from the start time in
+// /proc/self/stat (clock ticks since boot); negative if it can't be read
+double readProcessAge()
+{
+    std::FILE* file = std::fopen("/proc/self/stat", "r");
+    if (!file) return -1.0;
+    
+    char buffer[1024];
+    std::size_t length = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    buffer[length] = '\0';
+    
+    // The command name may contain spaces, so count fields from its closing
+    // parenthesis: state is field 3 and starttime field 22
+    const char* field = nullptr;
+    for (std::size_t i = length; i > 0; --i) {
+        if (buffer[i - 1] == ')') {
+            field = buffer + i;
+            break;
+        }
+    }
+    if (!field) return -1.0;
+    
+    unsigned long long startTicks = 0;
+    for (int index = 3; index <= 22; ++index) {
+        while (*field == ' ') ++field;
+        if (index == 22) {
+            if (std::sscanf(field, "%llu", &startTicks) != 1) return -1.0;
+            break;
+        }
+        while (*field && *field != ' ') ++field;
+    }
+    
+    timespec uptime;
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (ticksPerSecond <= 0 || clock_gettime(CLOCK_BOOTTIME, &uptime) != 0) return -1.0;
+    
+    double age = uptime.tv_sec + uptime.tv_nsec * 1e-9 - static_cast<double>(startTicks) / ticksPerSecond;
+    return age;
+}
+#endif
+
+double toMilliseconds(StartupTimer::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Taken during static initialisation so it is as early as possible elsewhere
+const StartupTimer::Clock::time_point g_processStart = StartupTimer::getProcessStart();
+
+}
+
+namespace StartupTimer {
+
+Clock::time_point getProcessStart()
+{
+    static const Clock::time_point start = [] {
+        Clock::time_point now = Clock::now();
+#if defined(__linux__)
+        double age = readProcessAge();
+        if (age > 0.0) {
+            return now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(age));
+        }
+#endif
+        return now;
+    }();
+    return start;
+}
+
+bool isFinished()
+{
+    return g_finished.load(std::memory_order_relaxed);
+}
+
+void record(const char* name, Clock::time_point start, Clock::time_point end, int depth)
+{
+    if (isFinished()) return;
+    
+    Report& report = getReport();
+    std::lock_guard<std::mutex> lock(report.mutex);
+    
+    if (report.count == MAX_SPANS) {
+        report.dropped++;
+        return;
+    }
+    report.spans[report.count++] = Span{name, start, end, depth};
+}
+
+void finish()
+{
+    Clock::time_point end = Clock::now();
+    if (g_finished.exchange(true)) return;
+    
+    Report& report = getReport();
+    std::lock_guard<std::mutex> lock(report.mutex);
+    
+    // Spans are recorded as they end, so inner ones come first; order by start
+    // (outer before inner on a tie) to print them as a tree
+    std::stable_sort(report.spans, report.spans + report.count, [](const Span& a, const Span& b) {
+        return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+    });
+    
+    Clock::time_point start = getProcessStart();
+    double accounted = 0.0;
+    
+    std::printf("Time to first frame: %.1f ms\n", toMilliseconds(end - start));
+    for (std::size_t i = 0; i < report.count; ++i) {
+        const Span& span = report.spans[i];
+        double ms = toMilliseconds(span.end - span.start);
+        if (span.depth == 0) accounted += ms;
+        std::printf("  %*s%-*s %8.1f ms  (at %.1f ms)\n", span.depth * 2, "", 36 - span.depth * 2, span.name, ms,
+                    toMilliseconds(span.start - start));
+    }
+    std::printf("  %-36s %8.1f ms\n", "Other", std::max(toMilliseconds(end - start) - accounted, 0.0));
+    if (report.dropped > 0) {
+        std::printf("  (%zu spans not shown)\n", report.dropped);
+    }
+    std::fflush(stdout);
+}
+
+}
+
+StartupScope::StartupScope(const char* name)
+    : m_name(StartupTimer::isFinished() ? nullptr : name)
+    , m_start(m_name ? StartupTimer::Clock::now() : StartupTimer::Clock::time_point())
+    , m_depth(m_name ? t_depth++ : 0)
+{
+}
+
+StartupScope::~StartupScope()
+{
+    if (m_name) {
+        t_depth--;
+        StartupTimer::record(m_name, m_start, StartupTimer::Clock::now(), m_depth);
+    }
+}
@@ -0,0 +1,226 @@
+#include "Timeline.hpp"
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace {
+
+// In front of every coroutine frame, padded so the frame stays aligned
+struct FrameHeader {
+    Timeline* timeline;
+    std::size_t size;
+};
+
+constexpr std::size_t HEADER_BYTES =
+    (sizeof(FrameHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+FrameHeader* headerOf(void* frame)
+{
+    return reinterpret_cast<FrameHeader*>(static_cast<unsigned char*>(frame) - HEADER_BYTES);
+}
+
+}
+
+void TimelineTask::promise_type::operator delete(void* frame, std::size_t)
+{
+    Timeline::releaseFrame(frame);
+}
+
+TimelineTask TimelineTask::promise_type::get_return_object()
+{
+    return TimelineTask(Handle::from_promise(*this));
+}
+
+TimelineTask::TimelineTask(Handle handle)
+    : m_handle(handle)
+{
+}
+
+TimelineTask::TimelineTask(TimelineTask&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+{
+}
+
+TimelineTask& TimelineTask::operator=(TimelineTask&& other) noexcept
+{
+    if (this != &other) {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+}
+
+TimelineTask::~TimelineTask()
+{
+    // Only a task that was never spawned still owns its frame
+    if (m_handle) {
+        m_handle.destroy();
+    }
+}
+
+void Timeline::Delay::await_suspend(TimelineTask::Handle handle)
+{
+    SlotHandle task;
+    task.index = handle.promise().slot;
+    timeline.m_delays.schedule(task, timeline.m_delays.getTick() + ticks);
+}
+
+void Timeline::Wait::await_suspend(TimelineTask::Handle handle)
+{
+    std::uint32_t slot = handle.promise().slot;
+    handle.promise().nextWaiter = NONE;
+    
+    Waiters& waiters = timeline.m_events[event];
+    if (waiters.last == NONE) {
+        waiters.first = slot;
+    } else {
+        timeline.m_tasks[waiters.last].promise().nextWaiter = slot;
+    }
+    waiters.last = slot;
+}
+
+Timeline::Timeline()
+    : m_taskCount(0)
+{
+}
+
+Timeline::~Timeline()
+{
+    // Frames go back to the pool as the tasks are destroyed, so the pool goes last
+    clear();
+    for (void* frame : m_freeFrames) {
+        ::operator delete(static_cast<unsigned char*>(frame) - HEADER_BYTES);
+    }
+}
+
+void Timeline::reserve(std::size_t tasks)
+{
+    m_tasks.reserve(tasks);
+    m_freeSlots.reserve(tasks);
+    m_ready.reserve(tasks);
+    m_freeFrames.reserve(tasks);
+    m_delays.reserve(tasks);
+}
+
+Timeline::EventId Timeline::createEvent()
+{
+    m_events.push_back(Waiters());
+    return static_cast<EventId>(m_events.size() - 1);
+}
+
+void Timeline::spawn(TimelineTask task)
+{
+    TimelineTask::Handle handle = std::exchange(task.m_handle, nullptr);
+    
+    std::uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_tasks[slot] = handle;
+    } else {
+        slot = static_cast<std::uint32_t>(m_tasks.size());
+        m_tasks.push_back(handle);
+    }
+    
+    handle.promise().timeline = this;
+    handle.promise().slot = slot;
+    m_taskCount++;
+    resume(slot);
+}
+
+void Timeline::clear(std::uint32_t tick)
+{
+    for (std::uint32_t slot = 0; slot < m_tasks.size(); ++slot) {
+        if (m_tasks[slot]) {
+            m_tasks[slot].destroy();
+        }
+    }
+    m_tasks.clear();
+    m_freeSlots.clear();
+    m_taskCount = 0;
+    
+    m_delays.clear(tick);
+    for (Waiters& waiters : m_events) {
+        waiters = Waiters();
+    }
+    m_ready.clear();
+}
+
+void Timeline::signal(EventId event)
+{
+    Waiters& waiters = m_events[event];
+    for (std::uint32_t slot = waiters.first; slot != NONE; slot = m_tasks[slot].promise().nextWaiter) {
+        m_ready.push_back(slot);
+    }
+    waiters = Waiters();
+}
+
+void Timeline::advance(std::uint32_t tick)
+{
+    m_delays.advance(tick, [this](SlotHandle task) {
+        m_ready.push_back(task.index);
+    });
+    
+    // Tasks run now may signal others, which join the end of the queue
+    for (std::size_t i = 0; i < m_ready.size(); ++i) {
+        resume(m_ready[i]);
+    }
+    m_ready.clear();
+}
+
+Timeline::Delay Timeline::delay(std::uint32_t ticks)
+{
+    return Delay{*this, ticks};
+}
+
+Timeline::Wait Timeline::wait(EventId event)
+{
+    return Wait{*this, event};
+}
+
+std::uint32_t Timeline::getTick() const
+{
+    return m_delays.getTick();
+}
+
+std::size_t Timeline::getTaskCount() const
+{
+    return m_taskCount;
+}
+
+void* Timeline::allocateFrame(std::size_t size)
+{
+    for (std::size_t i = 0; i < m_freeFrames.size(); ++i) {
+        void* frame = m_freeFrames[i];
+        if (headerOf(frame)->size == size) {
+            m_freeFrames[i] = m_freeFrames.back();
+            m_freeFrames.pop_back();
+            return frame;
+        }
+    }
+    
+    void* frame = static_cast<unsigned char*>(::operator new(HEADER_BYTES + size)) + HEADER_BYTES;
+    headerOf(frame)->timeline = this;
+    headerOf(frame)->size = size;
+    return frame;
+}
+
+void Timeline::releaseFrame(void* frame)
+{
+    headerOf(frame)->timeline->m_freeFrames.push_back(frame);
+}
+
+void Timeline::resume(std::uint32_t slot)
+{
+    TimelineTask::Handle handle = m_tasks[slot];
+    handle.resume();
+    
+    if (handle.done()) {
+        handle.destroy();
+        m_tasks[slot] = nullptr;
+        m_freeSlots.push_back(slot);
+        m_taskCount--;
+    }
+}
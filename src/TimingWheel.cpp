@@ -0,0 +1,139 @@
+#include "TimingWheel.hpp"
+#include <algorithm>
+
+TimingWheel::TimingWheel()
+    : m_freeHead(NONE)
+    , m_tick(0)
+    , m_count(0)
+{
+    m_buckets.fill(NONE);
+}
+
+void TimingWheel::reserve(std::size_t timers)
+{
+    m_nodes.reserve(timers);
+}
+
+void TimingWheel::clear(std::uint32_t tick)
+{
+    m_buckets.fill(NONE);
+    m_nodes.clear();
+    m_freeHead = NONE;
+    m_tick = tick;
+    m_count = 0;
+}
+
+void TimingWheel::schedule(SlotHandle handle, std::uint32_t tick)
+{
+    // Ticks are compared as distances from now, so the clock may wrap
+    std::int32_t delay = static_cast<std::int32_t>(tick - m_tick);
+    if (delay < 1) {
+        tick = m_tick + 1;
+    } else if (static_cast<std::uint32_t>(delay) > MAX_DELAY) {
+        tick = m_tick + MAX_DELAY;
+    }
+    
+    std::uint32_t node;
+    if (m_freeHead != NONE) {
+        node = m_freeHead;
+        m_freeHead = m_nodes[node].next;
+    } else {
+        node = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.push_back(Node());
+    }
+    
+    m_nodes[node].handle = handle;
+    m_nodes[node].tick = tick;
+    file(node);
+    m_count++;
+}
+
+std::uint32_t TimingWheel::getTick() const
+{
+    return m_tick;
+}
+
+std::size_t TimingWheel::size() const
+{
+    return m_count;
+}
+
+void TimingWheel::save(StateWriter& out) const
+{
+    out.write(m_buckets);
+    out.writeVector(m_nodes);
+    out.write(m_freeHead);
+    out.write(m_tick);
+    out.write(static_cast<std::uint64_t>(m_count));
+}
+
+bool TimingWheel::load(StateReader& in)
+{
+    std::uint64_t count = 0;
+    in.read(m_buckets);
+    in.readVector(m_nodes);
+    in.read(m_freeHead);
+    in.read(m_tick);
+    in.read(count);
+    m_count = static_cast<std::size_t>(count);
+    
+    // Every list has to stay within the node pool
+    auto inPool = [this](std::uint32_t node) {
+        return node == NONE || node < m_nodes.size();
+    };
+    bool consistent = in.isValid() && inPool(m_freeHead) && std::all_of(m_buckets.begin(), m_buckets.end(), inPool) &&
+                      std::all_of(m_nodes.begin(), m_nodes.end(), [&](const Node& node) { return inPool(node.next); });
+    if (!consistent) {
+        in.fail();
+        clear();
+    }
+    return consistent;
+}
+
+void TimingWheel::file(std::uint32_t node)
+{
+    // The lowest level where the tick shares every higher digit with now.
+    // Its digit there is then still ahead of the clock's, so the bucket
+    // comes round (or is cascaded down) no later than the tick itself
+    std::uint32_t tick = m_nodes[node].tick;
+    std::uint32_t level = 0;
+    while (level + 1 < LEVELS && (tick >> (SLOT_BITS * (level + 1))) != (m_tick >> (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    std::uint32_t& head = m_buckets[level * SLOTS + ((tick >> (SLOT_BITS * level)) & MASK)];
+    m_nodes[node].next = head;
+    head = node;
+}
+
+void TimingWheel::cascade()
+{
+    for (std::uint32_t level = LEVELS - 1; level > 0; --level) {
+        std::uint32_t shift = SLOT_BITS * level;
+        if ((m_tick & ((1u << shift) - 1)) != 0) {
+            continue;
+        }
+        
+        std::uint32_t node = detach(level, (m_tick >> shift) & MASK);
+        while (node != NONE) {
+            std::uint32_t next = m_nodes[node].next;
+            file(node);
+            node = next;
+        }
+    }
+}
+
+std::uint32_t TimingWheel::detach(std::uint32_t level, std::uint32_t slot)
+{
+    std::uint32_t& head = m_buckets[level * SLOTS + slot];
+    std::uint32_t node = head;
+    head = NONE;
+    return node;
+}
+
+void TimingWheel::release(std::uint32_t node)
+{
+    m_nodes[node].next = m_freeHead;
+    m_freeHead = node;
+    m_count--;
+}
@@ -1,190 +1,394 @@
 #include "UI.hpp"
-#include "ResourceManager.hpp"
-#include <string>
+#include "Profiler.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
 
-UI::UI()
-    : m_fontLoaded(false)
+constexpr float STATS_PANEL_WIDTH = 300.f;
+constexpr float STATS_PANEL_HEIGHT = 329.f;
+constexpr float REPLAY_BAR_HEIGHT = 6.f;
+
+// Every character size the UI uses, all in one glyph atlas
+const std::vector<unsigned int> TEXT_SIZES = {14, 16, 24, 32, 64, 72};
+constexpr const char* GLYPH_CACHE_PATH = "cache/arial.glyphs";
+
+// "<label><value>" in a string allocated from scratch
+std::pmr::string formatLabel(std::pmr::memory_resource& scratch, const char* label, int value)
 {
-    // Try to load font
-    try {
-        m_font = ResourceManager::getInstance().getFont("arial.ttf");
-        m_fontLoaded = true;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load font: " << e.what() << std::endl;
-    }
+    std::pmr::string text(label, &scratch);
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    text.append(digits, result.ptr);
+    return text;
+}
+
+}
+
+UI::UI(std::pmr::memory_resource& scratch)
+    : m_textsCreated(false)
+    , m_scratch(scratch)
+    , m_drawCalls(0)
+{
+    // Ship icon for the lives display
+    m_lifeIcon.setPointCount(3);
+    m_lifeIcon.setPoint(0, sf::Vector2f(10.f, 0.f));
+    m_lifeIcon.setPoint(1, sf::Vector2f(-5.f, -5.f));
+    m_lifeIcon.setPoint(2, sf::Vector2f(-5.f, 5.f));
+    m_lifeIcon.setFillColor(sf::Color::White);
+    m_lifeIcon.setRotation(sf::degrees(-90.f));
+    
+    // Full-screen overlay for the game over and pause screens
+    m_overlay.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    
+    // Frame statistics panel
+    m_statsPanel.setSize(sf::Vector2f(STATS_PANEL_WIDTH, STATS_PANEL_HEIGHT));
+    m_statsPanel.setFillColor(sf::Color(0, 0, 0, 180));
+    m_statsPanel.setOutlineColor(sf::Color(128, 128, 128));
+    m_statsPanel.setOutlineThickness(1.f);
+    m_statsPanel.setPosition(sf::Vector2f(WINDOW_WIDTH - STATS_PANEL_WIDTH - 20.f,
+                                          WINDOW_HEIGHT - STATS_PANEL_HEIGHT - 20.f));
+    
+    // Replay position bar along the bottom edge
+    m_replayTrack.setSize(sf::Vector2f(WINDOW_WIDTH - 40.f, REPLAY_BAR_HEIGHT));
+    m_replayTrack.setPosition(sf::Vector2f(20.f, WINDOW_HEIGHT - 20.f - REPLAY_BAR_HEIGHT));
+    m_replayTrack.setFillColor(sf::Color(64, 64, 64));
+    m_replayProgress.setPosition(m_replayTrack.getPosition());
 }
 
 void UI::renderScore(sf::RenderWindow& window, int score)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderScore");
+    
+    if (!ensureTexts()) return;
     
-    sf::Text scoreText(m_font, "Score: " + std::to_string(score), 24);
-    scoreText.setFillColor(sf::Color::White);
-    scoreText.setPosition(sf::Vector2f(20.f, 20.f));
+    AllocationScope allocationScope(AllocationTag::UI);
     
-    window.draw(scoreText);
+    m_scoreText->setString(formatLabel(m_scratch, "Score: ", score));
+    draw(window, *m_scoreText);
 }
 
 void UI::renderVelocity(sf::RenderWindow& window, int deltaTime)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderVelocity");
     
-    sf::Text velocityText(m_font, "Velocity: " + std::to_string(deltaTime), 24);
-    velocityText.setFillColor(sf::Color::White);
-    velocityText.setPosition(sf::Vector2f(20.f, 90.f));
+    if (!ensureTexts()) return;
     
-    window.draw(velocityText);
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    m_velocityText->setString(formatLabel(m_scratch, "Velocity: ", deltaTime));
+    draw(window, *m_velocityText);
 }
 
 void UI::renderLives(sf::RenderWindow& window, int lives)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderLives");
+    
+    if (!ensureTexts()) return;
     
-    sf::Text livesText(m_font, "Lives: " + std::to_string(lives), 24);
-    livesText.setFillColor(sf::Color::White);
-    livesText.setPosition(sf::Vector2f(20.f, 50.f));
+    AllocationScope allocationScope(AllocationTag::UI);
     
-    window.draw(livesText);
+    m_livesText->setString(formatLabel(m_scratch, "Lives: ", lives));
+    draw(window, *m_livesText);
     
     // Draw ship icons for lives
     for (int i = 0; i < lives; ++i) {
-        sf::ConvexShape ship;
-        ship.setPointCount(3);
-        ship.setPoint(0, sf::Vector2f(10.f, 0.f));
-        ship.setPoint(1, sf::Vector2f(-5.f, -5.f));
-        ship.setPoint(2, sf::Vector2f(-5.f, 5.f));
-        
-        ship.setFillColor(sf::Color::White);
-        ship.setPosition(sf::Vector2f(110.f + i * 25.f, 60.f));
-        ship.setRotation(sf::degrees(-90.f));
-        
-        window.draw(ship);
+        m_lifeIcon.setPosition(sf::Vector2f(110.f + i * 25.f, 60.f));
+        draw(window, m_lifeIcon);
     }
 }
 
 void UI::renderLevel(sf::RenderWindow& window, int level)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderLevel");
+    
+    if (!ensureTexts()) return;
     
-    sf::Text levelText(m_font, "Level: " + std::to_string(level), 24);
-    levelText.setFillColor(sf::Color::White);
-    levelText.setPosition(sf::Vector2f(WINDOW_WIDTH - 150.f, 20.f));
+    AllocationScope allocationScope(AllocationTag::UI);
     
-    window.draw(levelText);
+    m_levelText->setString(formatLabel(m_scratch, "Level: ", level));
+    draw(window, *m_levelText);
 }
 
 void UI::renderGameOver(sf::RenderWindow& window, int score)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderGameOver");
+    
+    if (!ensureTexts()) return;
+    
+    AllocationScope allocationScope(AllocationTag::UI);
     
     // Semi-transparent background
-    sf::RectangleShape overlay;
-    overlay.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
-    overlay.setFillColor(sf::Color(0, 0, 0, 200));
-    window.draw(overlay);
+    m_overlay.setFillColor(sf::Color(0, 0, 0, 200));
+    draw(window, m_overlay);
     
     // Game Over text
-    sf::Text gameOverText(m_font, "GAME OVER", 64);
-    gameOverText.setFillColor(sf::Color::Red);
-    {
-        sf::FloatRect textRect = gameOverText.getLocalBounds();
-        gameOverText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                             textRect.position.y + textRect.size.y / 2.f));
-    }
-    gameOverText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f - 60.f));
-    window.draw(gameOverText);
+    draw(window, *m_gameOverText);
     
     // Final score text
-    sf::Text finalScoreText(m_font, "Final Score: " + std::to_string(score), 32);
-    finalScoreText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = finalScoreText.getLocalBounds();
-        finalScoreText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                               textRect.position.y + textRect.size.y / 2.f));
-    }
-    finalScoreText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f));
-    window.draw(finalScoreText);
+    m_finalScoreText->setString(formatLabel(m_scratch, "Final Score: ", score));
+    centerOrigin(*m_finalScoreText);
+    draw(window, *m_finalScoreText);
     
     // Restart instructions
-    sf::Text restartText(m_font, "Press SPACE to restart", 24);
-    restartText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = restartText.getLocalBounds();
-        restartText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                            textRect.position.y + textRect.size.y / 2.f));
-    }
-    restartText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 60.f));
-    window.draw(restartText);
+    draw(window, *m_restartText);
 }
 
 void UI::renderMainMenu(sf::RenderWindow& window)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderMainMenu");
+    
+    if (!ensureTexts()) return;
+    
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    draw(window, *m_titleText);
+    draw(window, *m_startText);
+    draw(window, *m_controlsText);
+}
+
+void UI::renderPauseMenu(sf::RenderWindow& window)
+{
+    PROFILE_ZONE("UI::renderPauseMenu");
     
-    // Title text
-    sf::Text titleText(m_font, "ASTEROIDS", 72);
-    titleText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = titleText.getLocalBounds();
-        titleText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                         textRect.position.y + textRect.size.y / 2.f));
+    if (!ensureTexts()) return;
+    
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    // Semi-transparent background
+    m_overlay.setFillColor(sf::Color(0, 0, 0, 150));
+    draw(window, m_overlay);
+    
+    draw(window, *m_pauseText);
+    draw(window, *m_resumeText);
+}
+
+void UI::renderFrameStats(sf::RenderWindow& window, const FramePacer& framePacer, const FrameMemoryStats& memory,
+                          const QualityGovernor& quality, const ResolutionScaler* resolution,
+                          const InputLatency& input, std::uint32_t droppedInputs)
+{
+    PROFILE_ZONE("UI::renderFrameStats");
+    
+    if (!ensureTexts()) return;
+    
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    const sf::Vector2f origin = m_statsPanel.getPosition();
+    draw(window, m_statsPanel);
+    
+    // Summary text, formatted in scratch memory
+    std::pmr::string line(&m_scratch);
+    line.resize(256);
+    int length = std::snprintf(line.data(), line.size(),
+                               "Frame %.2f ms  Jitter %.2f ms\np99 %.2f ms  Worst %.2f ms\nSpin %.2f ms  Arena %zu/%zu KiB\n",
+                               framePacer.getMeanFrameTime(), framePacer.getJitter(),
+                               framePacer.getPercentile(99.0f), framePacer.getWorstFrameTime(),
+                               framePacer.getSpinThreshold(),
+                               memory.arenaPeak / 1024, memory.arenaCapacity / 1024);
+    line.resize(std::min<std::size_t>(std::max(length, 0), line.size() - 1));
+    
+    // Effects quality: level, load against the budget, and what it currently buys
+    EffectsQuality effects = quality.getQuality();
+    char row[96];
+    std::snprintf(row, sizeof(row), "Effects %.2f  Load %.2f  (-%u +%u)\n%d particles, life x%.2f, trail %s\n",
+                  effects.level, quality.getLoad(), quality.getDowngradeCount(), quality.getUpgradeCount(),
+                  effects.particlesPerExplosion, effects.particleLifetimeScale, effects.exhaustTrail ? "on" : "off");
+    line += row;
+    
+    // World render scale and its own count of changes
+    if (resolution) {
+        std::snprintf(row, sizeof(row), "Scale %.2f  [%.2f, %.2f]  (-%u +%u)\n",
+                      resolution->getScale(), resolution->getMinScale(), resolution->getMaxScale(),
+                      resolution->getDowngradeCount(), resolution->getUpgradeCount());
+    } else {
+        std::snprintf(row, sizeof(row), "Scale off\n");
     }
-    titleText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 3.f));
-    window.draw(titleText);
-    
-    // Start instructions
-    sf::Text startText(m_font, "Press SPACE to start", 32);
-    startText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = startText.getLocalBounds();
-        startText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                         textRect.position.y + textRect.size.y / 2.f));
+    line += row;
+    
+    // Key press to its frame on the display, over the last presses
+    std::snprintf(row, sizeof(row), "Input %.1f ms  Mean %.1f  Worst %.1f  Lost %u\n",
+                  input.getLast(), input.getMean(), input.getWorst(), droppedInputs);
+    line += row;
+    
+    if (AllocationTracker::isEnabled()) {
+        // One line per subsystem: allocations and bytes in the last frame
+        for (std::size_t i = 0; i < memory.frame.tags.size(); ++i) {
+            const AllocationTracker::Counters& counters = memory.frame.tags[i];
+            std::snprintf(row, sizeof(row), "%-10s %5llu allocs %8llu B\n",
+                          AllocationTracker::getTagName(static_cast<AllocationTag>(i)),
+                          static_cast<unsigned long long>(counters.allocations),
+                          static_cast<unsigned long long>(counters.bytes));
+            line += row;
+        }
+        std::snprintf(row, sizeof(row), "Heap %zu KiB (peak %zu)  RSS peak %zu MiB\nClean frames %llu",
+                      static_cast<std::size_t>(memory.total.liveBytes / 1024),
+                      static_cast<std::size_t>(memory.total.peakLiveBytes / 1024),
+                      memory.peakResidentBytes / (1024 * 1024),
+                      static_cast<unsigned long long>(memory.framesWithoutHeap));
+        line += row;
+    } else {
+        line += "Allocation tracking off";
+    }
+    
+    m_statsText->setString(line);
+    draw(window, *m_statsText);
+    
+    // Histogram, one bar per bin, scaled to the fullest bin
+    const auto& histogram = framePacer.getHistogram();
+    std::uint32_t fullest = std::max<std::uint32_t>(*std::max_element(histogram.begin(), histogram.end()), 1);
+    
+    const float barWidth = (STATS_PANEL_WIDTH - 16.f) / histogram.size();
+    const float barsHeight = 60.f;
+    const float baseline = origin.y + STATS_PANEL_HEIGHT - 8.f;
+    
+    // Bin holding the target frame time, drawn in a different colour
+    std::size_t targetBin = 0;
+    if (framePacer.getTargetRate() > 0.0f) {
+        targetBin = static_cast<std::size_t>(1000000.0f / framePacer.getTargetRate() / FramePacer::HISTOGRAM_BIN_US);
     }
-    startText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 60.f));
-    window.draw(startText);
-    
-    // Controls instructions
-    sf::Text controlsText(m_font, "Controls:\nArrow Keys/WASD - Move\nSpace - Fire\nP - Pause", 24);
-    controlsText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = controlsText.getLocalBounds();
-        controlsText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                            textRect.position.y + textRect.size.y / 2.f));
+    
+    for (std::size_t i = 0; i < histogram.size(); ++i) {
+        if (histogram[i] == 0) continue;
+        
+        float height = std::max(barsHeight * histogram[i] / fullest, 1.f);
+        m_statsBar.setSize(sf::Vector2f(std::max(barWidth - 1.f, 1.f), height));
+        m_statsBar.setPosition(sf::Vector2f(origin.x + 8.f + i * barWidth, baseline - height));
+        m_statsBar.setFillColor(i == targetBin ? sf::Color::Green : sf::Color(255, 160, 0));
+        draw(window, m_statsBar);
     }
-    controlsText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 150.f));
-    window.draw(controlsText);
 }
 
-void UI::renderPauseMenu(sf::RenderWindow& window)
+void UI::renderReplayStatus(sf::RenderWindow& window, const ReplayStatus& status)
 {
-    if (!m_fontLoaded) return;
+    PROFILE_ZONE("UI::renderReplayStatus");
     
-    // Semi-transparent background
-    sf::RectangleShape overlay;
-    overlay.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
-    overlay.setFillColor(sf::Color(0, 0, 0, 150));
-    window.draw(overlay);
-    
-    // Pause text
-    sf::Text pauseText(m_font, "PAUSED", 64);
-    pauseText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = pauseText.getLocalBounds();
-        pauseText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                         textRect.position.y + textRect.size.y / 2.f));
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    // Slow ticks show up red, so a spike is easy to stop on
+    bool slow = status.budgetMs > 0.0f && status.tickTimeMs > status.budgetMs;
+    float progress = status.tickCount > 1 ? static_cast<float>(status.tick) / (status.tickCount - 1) : 0.f;
+    m_replayProgress.setSize(sf::Vector2f(m_replayTrack.getSize().x * progress, REPLAY_BAR_HEIGHT));
+    m_replayProgress.setFillColor(slow ? sf::Color::Red : sf::Color::White);
+    draw(window, m_replayTrack);
+    draw(window, m_replayProgress);
+    
+    if (!ensureTexts()) return;
+    
+    char line[192];
+    std::snprintf(line, sizeof(line),
+                  "Tick %llu/%llu  %s %gx  Tick time %.3f ms\n"
+                  "Space play/pause  Left/Right seek  Up/Down speed  N next slow tick  Home/End",
+                  static_cast<unsigned long long>(status.tick), static_cast<unsigned long long>(status.tickCount),
+                  status.paused ? "Paused" : "Playing", status.speed, status.tickTimeMs);
+    m_replayText->setString(line);
+    m_replayText->setFillColor(slow ? sf::Color::Red : sf::Color::White);
+    draw(window, *m_replayText);
+}
+
+void UI::renderSpectatorStatus(sf::RenderWindow& window, const SpectatorStatus& status)
+{
+    PROFILE_ZONE("UI::renderSpectatorStatus");
+    
+    AllocationScope allocationScope(AllocationTag::UI);
+    
+    if (!ensureTexts()) return;
+    
+    char line[192];
+    if (status.frames == 0) {
+        std::snprintf(line, sizeof(line), "Waiting for a game broadcasting on port %u", static_cast<unsigned int>(status.port));
+    } else {
+        std::snprintf(line, sizeof(line), "Port %u  Tick %llu  %s\nFrames %llu  Lost %llu",
+                      static_cast<unsigned int>(status.port), static_cast<unsigned long long>(status.tick),
+                      status.receiving ? "Live" : "Stalled", static_cast<unsigned long long>(status.frames),
+                      static_cast<unsigned long long>(status.lostFrames));
     }
-    pauseText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f - 50.f));
-    window.draw(pauseText);
-    
-    // Resume instructions
-    sf::Text resumeText(m_font, "Press P to resume", 32);
-    resumeText.setFillColor(sf::Color::White);
-    {
-        sf::FloatRect textRect = resumeText.getLocalBounds();
-        resumeText.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
-                                          textRect.position.y + textRect.size.y / 2.f));
+    
+    // Stalled streams show up red
+    m_replayText->setString(line);
+    m_replayText->setFillColor(status.receiving ? sf::Color::White : sf::Color::Red);
+    draw(window, *m_replayText);
+}
+
+std::uint32_t UI::takeDrawCalls()
+{
+    std::uint32_t drawCalls = m_drawCalls;
+    m_drawCalls = 0;
+    return drawCalls;
+}
+
+void UI::draw(sf::RenderWindow& window, const sf::Drawable& drawable)
+{
+    window.draw(drawable);
+    m_drawCalls++;
+}
+
+bool UI::ensureTexts()
+{
+    if (m_textsCreated) {
+        return m_atlas.isLoaded();
     }
-    resumeText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 50.f));
-    window.draw(resumeText);
+    m_textsCreated = true;
+    
+    PROFILE_ZONE("UI::ensureTexts");
+    
+    if (!m_atlas.load("arial.ttf", TEXT_SIZES, GLYPH_CACHE_PATH)) {
+        std::cerr << "No font for the HUD, drawing it without text" << std::endl;
+        return false;
+    }
+    
+    // HUD
+    m_scoreText = makeText("Score: 0", 24, sf::Vector2f(20.f, 20.f));
+    m_livesText = makeText("Lives: 0", 24, sf::Vector2f(20.f, 50.f));
+    m_levelText = makeText("Level: 1", 24, sf::Vector2f(WINDOW_WIDTH - 150.f, 20.f));
+    m_velocityText = makeText("Velocity: 0", 24, sf::Vector2f(20.f, 90.f));
+    
+    // Game over screen
+    m_gameOverText = makeText("GAME OVER", 64, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f - 60.f));
+    m_gameOverText->setFillColor(sf::Color::Red);
+    centerOrigin(*m_gameOverText);
+    m_finalScoreText = makeText("Final Score: 0", 32, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f));
+    m_restartText = makeText("Press SPACE to restart", 24, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 60.f));
+    centerOrigin(*m_restartText);
+    
+    // Main menu
+    m_titleText = makeText("ASTEROIDS", 72, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 3.f));
+    centerOrigin(*m_titleText);
+    m_startText = makeText("Press SPACE to start", 32, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 60.f));
+    centerOrigin(*m_startText);
+    m_controlsText = makeText("Controls:\nArrow Keys/WASD - Move\nSpace - Fire\nP - Pause", 24,
+                              sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 150.f));
+    centerOrigin(*m_controlsText);
+    
+    // Pause menu
+    m_pauseText = makeText("PAUSED", 64, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f - 50.f));
+    centerOrigin(*m_pauseText);
+    m_resumeText = makeText("Press P to resume", 32, sf::Vector2f(WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f + 50.f));
+    centerOrigin(*m_resumeText);
+    
+    // Frame statistics
+    m_statsText = makeText("", 14, m_statsPanel.getPosition() + sf::Vector2f(8.f, 6.f));
+    
+    // Replay viewer
+    m_replayText = makeText("", 16, m_replayTrack.getPosition() - sf::Vector2f(0.f, 48.f));
+    
+    return true;
+}
+
+AtlasText UI::makeText(std::string_view value, unsigned int size, sf::Vector2f position)
+{
+    AtlasText text(m_atlas, value, size);
+    text.setFillColor(sf::Color::White);
+    text.setPosition(position);
+    return text;
+}
+
+void UI::centerOrigin(AtlasText& text)
+{
+    sf::FloatRect textRect = text.getLocalBounds();
+    text.setOrigin(sf::Vector2f(textRect.position.x + textRect.size.x / 2.f,
+                                textRect.position.y + textRect.size.y / 2.f));
 }
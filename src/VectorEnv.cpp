@@ -0,0 +1,432 @@
+#include "VectorEnv.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr std::uint32_t ASTEROIDS_OFFSET = AST_ENV_PLAYER_FEATURES;
+constexpr std::uint32_t BULLETS_OFFSET = ASTEROIDS_OFFSET + AST_ENV_MAX_ASTEROIDS * AST_ENV_ASTEROID_FEATURES;
+
+// Shortest vector from a to b in a toroidal world
+sf::Vector2f wrappedDelta(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& worldSize)
+{
+    sf::Vector2f delta = b - a;
+    delta.x -= worldSize.x * std::round(delta.x / worldSize.x);
+    delta.y -= worldSize.y * std::round(delta.y / worldSize.y);
+    return delta;
+}
+
+// Keep the closest count candidates at the front, closest first
+template <typename T>
+std::size_t selectNearest(std::vector<T>& candidates, std::size_t count)
+{
+    auto closer = [](const T& a, const T& b) { return a.distance < b.distance; };
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), closer);
+    return count;
+}
+
+}
+
+VectorEnv::Environment::Environment(const SimulationConfig& config)
+    : simulation(config)
+{
+}
+
+VectorEnv::VectorEnv(const AstEnvConfig& config)
+    : m_config(config)
+    , m_deltaTime(1.0f / (config.tick_rate > 0.0f ? config.tick_rate : 60.0f))
+    , m_ownObservations(static_cast<std::size_t>(config.num_envs) * AST_ENV_OBSERVATION_SIZE, 0.0f)
+    , m_ownRewards(config.num_envs, 0.0f)
+    , m_ownDones(config.num_envs, 0)
+    , m_observations(m_ownObservations.data())
+    , m_rewards(m_ownRewards.data())
+    , m_dones(m_ownDones.data())
+    , m_pixelSize(0)
+    , m_shards(std::min(std::max(config.num_threads, 1u), std::max(config.num_envs, 1u)))
+    , m_generation(0)
+    , m_pending(0)
+    , m_stopping(false)
+    , m_task(Task::Reset)
+    , m_actions(nullptr)
+{
+    SimulationConfig simulationConfig;
+    if (config.world_width > 0.0f && config.world_height > 0.0f) {
+        simulationConfig.worldSize = sf::Vector2f(config.world_width, config.world_height);
+    }
+    
+    PixelFormat pixelFormat = config.pixel_grayscale ? PixelFormat::Gray8 : PixelFormat::RGBA8;
+    if (config.pixel_width > 0 && config.pixel_height > 0) {
+        m_pixelSize = config.pixel_width * config.pixel_height * (config.pixel_grayscale ? 1u : 4u);
+        m_pixels.assign(static_cast<std::size_t>(config.num_envs) * m_pixelSize, 0);
+    }
+    
+    m_environments.reserve(config.num_envs);
+    for (std::uint32_t i = 0; i < config.num_envs; ++i) {
+        simulationConfig.seed = config.seed + i * 7919u;
+        m_environments.push_back(std::make_unique<Environment>(simulationConfig));
+        m_environments.back()->nearby.reserve(64);
+        m_environments.back()->nearestAsteroids.reserve(64);
+        
+        if (m_pixelSize > 0) {
+            auto renderer = std::make_unique<SoftwareRenderer>(config.pixel_width, config.pixel_height, pixelFormat);
+            renderer->bindTarget(m_pixels.data() + static_cast<std::size_t>(i) * m_pixelSize);
+            m_environments.back()->renderer = std::move(renderer);
+        }
+    }
+    
+    for (std::uint32_t worker = 1; worker < m_shards; ++worker) {
+        m_workers.emplace_back(&VectorEnv::workerLoop, this, worker);
+    }
+}
+
+VectorEnv::~VectorEnv()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_startCondition.notify_all();
+    
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::uint32_t VectorEnv::size() const
+{
+    return m_config.num_envs;
+}
+
+const float* VectorEnv::observations() const
+{
+    return m_observations;
+}
+
+const float* VectorEnv::rewards() const
+{
+    return m_rewards;
+}
+
+const std::uint8_t* VectorEnv::dones() const
+{
+    return m_dones;
+}
+
+const std::uint8_t* VectorEnv::pixels() const
+{
+    return m_pixels.empty() ? nullptr : m_pixels.data();
+}
+
+std::uint32_t VectorEnv::pixelSize() const
+{
+    return m_pixelSize;
+}
+
+void VectorEnv::bindBuffers(float* observations, float* rewards, std::uint8_t* dones)
+{
+    if (observations) m_observations = observations;
+    if (rewards) m_rewards = rewards;
+    if (dones) m_dones = dones;
+}
+
+void VectorEnv::reset()
+{
+    runAll(Task::Reset);
+    publishSpectatorFrame();
+}
+
+void VectorEnv::step(const std::uint8_t* actions)
+{
+    m_actions = actions;
+    runAll(Task::Step);
+    m_actions = nullptr;
+    publishSpectatorFrame();
+}
+
+bool VectorEnv::spectate(std::uint16_t port)
+{
+    m_spectators.stop();
+    return port == 0 || m_spectators.start(port);
+}
+
+void VectorEnv::runRange(Task task, std::uint32_t first, std::uint32_t last)
+{
+    for (std::uint32_t i = first; i < last; ++i) {
+        if (task == Task::Reset) {
+            resetEnvironment(i);
+        } else {
+            stepEnvironment(i, m_actions[i]);
+        }
+    }
+}
+
+void VectorEnv::runAll(Task task)
+{
+    if (m_shards > 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = task;
+            m_pending = m_shards - 1;
+            m_generation++;
+        }
+        m_startCondition.notify_all();
+    }
+    
+    // The calling thread takes the first shard
+    runRange(task, 0, m_config.num_envs / m_shards);
+    
+    if (m_shards > 1) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_pending == 0; });
+    }
+}
+
+void VectorEnv::workerLoop(std::uint32_t worker)
+{
+    const std::uint32_t first = static_cast<std::uint32_t>(static_cast<std::uint64_t>(m_config.num_envs) * worker / m_shards);
+    const std::uint32_t last = static_cast<std::uint32_t>(static_cast<std::uint64_t>(m_config.num_envs) * (worker + 1) / m_shards);
+    std::uint64_t seenGeneration = 0;
+    
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+            task = m_task;
+        }
+        
+        runRange(task, first, last);
+        
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_doneCondition.notify_one();
+    }
+}
+
+void VectorEnv::resetEnvironment(std::uint32_t index)
+{
+    Environment& environment = *m_environments[index];
+    environment.simulation.startGame();
+    environment.lastScore = 0;
+    environment.episodeTicks = 0;
+    
+    m_rewards[index] = 0.0f;
+    m_dones[index] = 0;
+    writeObservation(environment, m_observations + static_cast<std::size_t>(index) * AST_ENV_OBSERVATION_SIZE);
+    writePixels(index);
+}
+
+void VectorEnv::stepEnvironment(std::uint32_t index, std::uint8_t action)
+{
+    Environment& environment = *m_environments[index];
+    
+    PlayerInput input;
+    input.thrust = (action & AST_ACTION_THRUST) != 0;
+    input.rotateLeft = (action & AST_ACTION_LEFT) != 0;
+    input.rotateRight = (action & AST_ACTION_RIGHT) != 0;
+    input.fire = (action & AST_ACTION_FIRE) != 0;
+    
+    environment.simulation.update(input, m_deltaTime);
+    environment.episodeTicks++;
+    
+    int score = environment.simulation.getScore();
+    m_rewards[index] = static_cast<float>(score - environment.lastScore);
+    environment.lastScore = score;
+    
+    bool done = environment.simulation.getState() == GameState::GameOver ||
+                (m_config.max_episode_ticks > 0 && environment.episodeTicks >= m_config.max_episode_ticks);
+    m_dones[index] = done ? 1 : 0;
+    
+    if (done) {
+        environment.simulation.startGame();
+        environment.lastScore = 0;
+        environment.episodeTicks = 0;
+    }
+    
+    writeObservation(environment, m_observations + static_cast<std::size_t>(index) * AST_ENV_OBSERVATION_SIZE);
+    writePixels(index);
+}
+
+void VectorEnv::writeObservation(Environment& environment, float* out)
+{
+    const Simulation& simulation = environment.simulation;
+    const Player& player = simulation.getPlayer();
+    const sf::Vector2f& worldSize = simulation.getWorldSize();
+    const sf::Vector2f playerPosition = player.getPosition();
+    const sf::Vector2f halfWorld = worldSize / 2.0f;
+    
+    std::fill(out, out + AST_ENV_OBSERVATION_SIZE, 0.0f);
+    
+    // Player
+    sf::Vector2f direction = player.getDirection();
+    sf::Vector2f velocity = player.getVelocity();
+    out[0] = playerPosition.x / worldSize.x;
+    out[1] = playerPosition.y / worldSize.y;
+    out[2] = velocity.x / PLAYER_MAX_SPEED;
+    out[3] = velocity.y / PLAYER_MAX_SPEED;
+    out[4] = direction.x;
+    out[5] = direction.y;
+    out[6] = player.isInvulnerable() ? 1.0f : 0.0f;
+    out[7] = player.canFire() ? 1.0f : 0.0f;
+    out[8] = static_cast<float>(player.getLives()) / 3.0f;
+    
+    // Nearest asteroids
+    auto& nearestAsteroids = environment.nearestAsteroids;
+    nearestAsteroids.clear();
+    simulation.getAsteroidIndex().queryNearest(playerPosition, AST_ENV_MAX_ASTEROIDS, nearestAsteroids);
+    
+    float* slot = out + ASTEROIDS_OFFSET;
+    for (const SpatialHit& hit : nearestAsteroids) {
+        const Asteroid& asteroid = *simulation.getAsteroids().get(hit.handle);
+        sf::Vector2f asteroidVelocity = asteroid.getVelocity();
+        slot[0] = 1.0f;
+        slot[1] = hit.delta.x / halfWorld.x;
+        slot[2] = hit.delta.y / halfWorld.y;
+        slot[3] = asteroidVelocity.x / ASTEROID_SPEED_MAX;
+        slot[4] = asteroidVelocity.y / ASTEROID_SPEED_MAX;
+        slot[5] = asteroid.getRadius() / ASTEROID_LARGE_RADIUS;
+        slot += AST_ENV_ASTEROID_FEATURES;
+    }
+    
+    // Nearest bullets
+    auto& nearby = environment.nearby;
+    nearby.clear();
+    for (const Bullet& bullet : simulation.getBullets()) {
+        if (!bullet.isActive()) continue;
+        sf::Vector2f delta = wrappedDelta(playerPosition, bullet.getPosition(), worldSize);
+        nearby.push_back({delta.x * delta.x + delta.y * delta.y, delta, &bullet});
+    }
+    
+    std::size_t count = selectNearest(nearby, AST_ENV_MAX_BULLETS);
+    slot = out + BULLETS_OFFSET;
+    for (std::size_t i = 0; i < count; ++i, slot += AST_ENV_BULLET_FEATURES) {
+        slot[0] = 1.0f;
+        slot[1] = nearby[i].delta.x / halfWorld.x;
+        slot[2] = nearby[i].delta.y / halfWorld.y;
+    }
+}
+
+void VectorEnv::writePixels(std::uint32_t index)
+{
+    Environment& environment = *m_environments[index];
+    if (!environment.renderer) {
+        return;
+    }
+    
+    environment.simulation.capture(environment.snapshot);
+    environment.renderer->render(environment.snapshot);
+}
+
+void VectorEnv::publishSpectatorFrame()
+{
+    if (!m_spectators.isRunning() || m_environments.empty()) {
+        return;
+    }
+    
+    m_environments[0]->simulation.capture(m_spectatorSnapshot);
+    m_spectators.publish(m_spectatorSnapshot);
+}
+
+// C interface
+
+extern "C" {
+
+void ast_env_default_config(AstEnvConfig* config)
+{
+    if (!config) return;
+    config->num_envs = 64;
+    config->num_threads = 1;
+    config->seed = 5489u;
+    config->world_width = 0.0f;
+    config->world_height = 0.0f;
+    config->tick_rate = 60.0f;
+    config->max_episode_ticks = 0;
+    config->pixel_width = 0;
+    config->pixel_height = 0;
+    config->pixel_grayscale = 0;
+}
+
+AstEnv* ast_env_create(const AstEnvConfig* config)
+{
+    if (!config || config->num_envs == 0) {
+        return nullptr;
+    }
+    
+    try {
+        return reinterpret_cast<AstEnv*>(new VectorEnv(*config));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void ast_env_destroy(AstEnv* env)
+{
+    delete reinterpret_cast<VectorEnv*>(env);
+}
+
+uint32_t ast_env_num_envs(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->size();
+}
+
+uint32_t ast_env_observation_size(void)
+{
+    return AST_ENV_OBSERVATION_SIZE;
+}
+
+const float* ast_env_observations(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->observations();
+}
+
+const float* ast_env_rewards(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->rewards();
+}
+
+const uint8_t* ast_env_dones(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->dones();
+}
+
+const uint8_t* ast_env_pixels(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->pixels();
+}
+
+uint32_t ast_env_pixel_size(const AstEnv* env)
+{
+    return reinterpret_cast<const VectorEnv*>(env)->pixelSize();
+}
+
+void ast_env_bind_buffers(AstEnv* env, float* observations, float* rewards, uint8_t* dones)
+{
+    reinterpret_cast<VectorEnv*>(env)->bindBuffers(observations, rewards, dones);
+}
+
+int ast_env_spectate(AstEnv* env, uint32_t port)
+{
+    if (port > 65535) {
+        return 0;
+    }
+    return reinterpret_cast<VectorEnv*>(env)->spectate(static_cast<std::uint16_t>(port)) ? 1 : 0;
+}
+
+void ast_env_reset(AstEnv* env)
+{
+    reinterpret_cast<VectorEnv*>(env)->reset();
+}
+
+void ast_env_step(AstEnv* env, const uint8_t* actions)
+{
+    reinterpret_cast<VectorEnv*>(env)->step(actions);
+}
+
+}
@@ -0,0 +1,177 @@
+#include "WorldRenderer.hpp"
+#include "Constants.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+
+namespace {
+
+// Furthest an asteroid's outline reaches from its centre (the largest vertex
+// radius, plus the outline)
+constexpr float ASTEROID_REACH = ASTEROID_LARGE_RADIUS * 1.5f + 1.0f;
+
+// Nose to tail of the ship and its flame
+constexpr float SHIP_REACH = 21.0f;
+
+}
+
+WorldRenderer::WorldRenderer()
+    : m_viewport({0.0f, 0.0f}, {1.0f, 1.0f})
+    , m_drawCalls(0)
+{
+    // Asteroids: white outlines, points are filled in per asteroid
+    m_asteroidShape.setPointCount(ASTEROID_VERTICES_MAX);
+    m_asteroidShape.setFillColor(sf::Color::Transparent);
+    m_asteroidShape.setOutlineColor(sf::Color::White);
+    m_asteroidShape.setOutlineThickness(1.0f);
+    
+    // Bullets: the radius comes from the snapshot
+    m_bulletShape.setFillColor(sf::Color::White);
+    
+    // Particles: 2x2 squares
+    m_particleShape.setSize(sf::Vector2f(2.0f, 2.0f));
+    m_particleShape.setOrigin(sf::Vector2f(1.0f, 1.0f));
+    
+    // Same geometry as Player's own shapes
+    m_shipShape.setPointCount(3);
+    m_shipShape.setPoint(0, sf::Vector2f(20.0f, 0.0f));           // Nose
+    m_shipShape.setPoint(1, sf::Vector2f(-10.0f, -10.0f));        // Left wing
+    m_shipShape.setPoint(2, sf::Vector2f(-10.0f, 10.0f));         // Right wing
+    m_shipShape.setFillColor(sf::Color::Transparent);
+    m_shipShape.setOutlineColor(sf::Color::White);
+    m_shipShape.setOutlineThickness(1.0f);
+    
+    m_flameShape.setPointCount(3);
+    m_flameShape.setPoint(0, sf::Vector2f(-10.0f, 0.0f));
+    m_flameShape.setPoint(1, sf::Vector2f(-20.0f, -5.0f));
+    m_flameShape.setPoint(2, sf::Vector2f(-20.0f, 5.0f));
+    m_flameShape.setFillColor(sf::Color::Yellow);
+    m_flameShape.setOutlineColor(sf::Color::Red);
+    m_flameShape.setOutlineThickness(1.0f);
+}
+
+void WorldRenderer::render(sf::RenderTarget& target, const FrameSnapshot& snapshot)
+{
+    PROFILE_ZONE("WorldRenderer::render");
+    
+    placeCamera(target, snapshot);
+    sf::Vector2f position;
+    
+    for (const SnapshotAsteroid& asteroid : snapshot.asteroids) {
+        if (!toView(asteroid.x, asteroid.y, ASTEROID_REACH, position)) continue;
+        
+        const float* vertices = snapshot.asteroidVertices.data() + asteroid.firstVertex * 2;
+        
+        // Never shrinks below ASTEROID_VERTICES_MAX points, so this doesn't reallocate
+        m_asteroidShape.setPointCount(asteroid.vertexCount);
+        for (std::uint32_t i = 0; i < asteroid.vertexCount; ++i) {
+            m_asteroidShape.setPoint(i, sf::Vector2f(vertices[i * 2], vertices[i * 2 + 1]));
+        }
+        m_asteroidShape.setPosition(position);
+        m_asteroidShape.setRotation(sf::degrees(asteroid.rotation));
+        draw(target, m_asteroidShape);
+    }
+    
+    for (const SnapshotBullet& bullet : snapshot.bullets) {
+        if (!toView(bullet.x, bullet.y, bullet.radius, position)) continue;
+        
+        m_bulletShape.setRadius(bullet.radius);
+        m_bulletShape.setOrigin(sf::Vector2f(bullet.radius, bullet.radius));
+        m_bulletShape.setPosition(position);
+        draw(target, m_bulletShape);
+    }
+    
+    for (const SnapshotParticle& particle : snapshot.particles) {
+        if (!toView(particle.x, particle.y, 1.0f, position)) continue;
+        
+        const SnapshotColor& color = particle.color;
+        m_particleShape.setFillColor(sf::Color(color.r, color.g, color.b, color.a));
+        m_particleShape.setPosition(position);
+        draw(target, m_particleShape);
+    }
+    
+    // The ship is hidden on the game over screen
+    if (snapshot.state != GameState::GameOver) {
+        renderPlayer(target, snapshot.player);
+    }
+    
+    // The HUD is drawn in window coordinates
+    target.setView(target.getDefaultView());
+}
+
+void WorldRenderer::setViewport(const sf::FloatRect& viewport)
+{
+    m_viewport = viewport;
+}
+
+void WorldRenderer::placeCamera(sf::RenderTarget& target, const FrameSnapshot& snapshot)
+{
+    m_worldSize = sf::Vector2f(snapshot.worldWidth, snapshot.worldHeight);
+    m_camera = target.getDefaultView();
+    
+    sf::Vector2f size = m_camera.getSize();
+    sf::Vector2f center = m_worldSize / 2.0f;
+    if (m_worldSize.x > size.x) {
+        center.x = snapshot.player.x;
+    }
+    if (m_worldSize.y > size.y) {
+        center.y = snapshot.player.y;
+    }
+    m_camera.setCenter(center);
+    
+    // Same area of the world whatever the viewport, just in fewer pixels
+    m_camera.setViewport(m_viewport);
+    target.setView(m_camera);
+}
+
+bool WorldRenderer::toView(float x, float y, float margin, sf::Vector2f& position) const
+{
+    // Nearest copy of the point to the camera, across the wrap
+    sf::Vector2f center = m_camera.getCenter();
+    sf::Vector2f delta(x - center.x, y - center.y);
+    delta.x -= m_worldSize.x * std::round(delta.x / m_worldSize.x);
+    delta.y -= m_worldSize.y * std::round(delta.y / m_worldSize.y);
+    
+    sf::Vector2f halfSize = m_camera.getSize() / 2.0f;
+    if (std::fabs(delta.x) > halfSize.x + margin || std::fabs(delta.y) > halfSize.y + margin) {
+        return false;
+    }
+    
+    position = center + delta;
+    return true;
+}
+
+void WorldRenderer::renderPlayer(sf::RenderTarget& target, const SnapshotPlayer& player)
+{
+    // Don't render if blinking during invulnerability
+    if (!player.visible) {
+        return;
+    }
+    
+    sf::Vector2f position;
+    if (!toView(player.x, player.y, SHIP_REACH, position)) {
+        return;
+    }
+    
+    m_shipShape.setPosition(position);
+    m_shipShape.setRotation(sf::degrees(player.rotation));
+    draw(target, m_shipShape);
+    
+    if (player.thrusting) {
+        m_flameShape.setPosition(position);
+        m_flameShape.setRotation(sf::degrees(player.rotation));
+        draw(target, m_flameShape);
+    }
+}
+
+std::uint32_t WorldRenderer::takeDrawCalls()
+{
+    std::uint32_t drawCalls = m_drawCalls;
+    m_drawCalls = 0;
+    return drawCalls;
+}
+
+void WorldRenderer::draw(sf::RenderTarget& target, const sf::Drawable& drawable)
+{
+    target.draw(drawable);
+    m_drawCalls++;
+}
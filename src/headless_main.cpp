@@ -0,0 +1,338 @@
+#include <iostream>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AllocationTracker.hpp"
+#include "FlightRecorder.hpp"
+#include "HeadlessHost.hpp"
+#include "MotionKernel.hpp"
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include "SpatialIndex.hpp"
+
+namespace {
+
+// Parse "WxH", returns false if malformed
+bool parseSize(const std::string& text, float& width, float& height)
+{
+    std::size_t separator = text.find('x');
+    if (separator == std::string::npos) {
+        return false;
+    }
+    width = std::stof(text.substr(0, separator));
+    height = std::stof(text.substr(separator + 1));
+    return width > 0.0f && height > 0.0f;
+}
+
+// Size, index and the slowest ticks of a replay file
+bool printReplayInfo(const std::string& path)
+{
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Not a replay file: " << path << std::endl;
+        return false;
+    }
+    
+    std::uint64_t ticks = reader.getTickCount();
+    std::cout << "Ticks: " << ticks << ", keyframe every " << reader.getKeyframeInterval() << std::endl;
+    std::cout << "Size: " << reader.getFileSize() << " bytes";
+    if (ticks > 0) {
+        std::cout << " (" << reader.getFileSize() / ticks << " per tick)";
+    }
+    std::cout << std::endl;
+    if (reader.wasRecovered()) {
+        std::cout << "No index (unfinished recording), recovered by walking the records" << std::endl;
+    }
+    
+    // Slowest ticks, to know where to look
+    std::vector<std::pair<float, std::uint64_t>> slowest;
+    for (std::uint64_t tick = 0; tick < ticks; ++tick) {
+        slowest.emplace_back(reader.getTickTime(tick), tick);
+    }
+    std::size_t shown = std::min<std::size_t>(5, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + static_cast<std::ptrdiff_t>(shown), slowest.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (std::size_t i = 0; i < shown; ++i) {
+        std::cout << "  tick " << slowest[i].second << ": " << slowest[i].first << " ms" << std::endl;
+    }
+    
+    // Every tick must decode
+    FrameSnapshot snapshot;
+    for (std::uint64_t tick = 0; tick < ticks; ++tick) {
+        if (!reader.read(tick, snapshot)) {
+            std::cerr << "Tick " << tick << " failed to decode" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Summarise a flight recorder dump and, if it starts at the first tick, run
+// its inputs through a new simulation checking every tick's outcome
+bool replayFlight(const std::string& path)
+{
+    FlightRecorder::Dump dump;
+    if (!FlightRecorder::load(path, dump)) {
+        std::cerr << "Not a flight recorder dump: " << path << std::endl;
+        return false;
+    }
+    
+    std::cout << "Reason: " << dump.reason << std::endl;
+    std::cout << "Seed " << dump.seed << ", world " << dump.worldWidth << "x" << dump.worldHeight
+              << ", " << dump.ticks.size() << " ticks";
+    if (dump.ticks.empty()) {
+        std::cout << std::endl;
+        return true;
+    }
+    std::cout << " (" << dump.ticks.front().tick << " to " << dump.ticks.back().tick << ")" << std::endl;
+    if (dump.droppedKeyframes > 0) {
+        std::cout << dump.droppedKeyframes << " keyframes were dropped, there was no memory for their state"
+                  << std::endl;
+    }
+    
+    // Slowest ticks and how their time split
+    std::vector<const FlightRecorder::TickRecord*> slowest;
+    for (const FlightRecorder::TickRecord& record : dump.ticks) {
+        slowest.push_back(&record);
+    }
+    auto total = [](const FlightRecorder::TickRecord* record) {
+        return record->updateUs + record->captureUs + record->publishUs;
+    };
+    std::size_t shown = std::min<std::size_t>(5, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + static_cast<std::ptrdiff_t>(shown), slowest.end(),
+                      [&](const auto* a, const auto* b) { return total(a) > total(b); });
+    for (std::size_t i = 0; i < shown; ++i) {
+        const FlightRecorder::TickRecord& record = *slowest[i];
+        std::cout << "  tick " << record.tick << ": update " << record.updateUs << " us, capture "
+                  << record.captureUs << " us, publish " << record.publishUs << " us, "
+                  << record.asteroids << " asteroids, " << record.particles << " particles" << std::endl;
+    }
+    
+    // The newest keyframe that some recorded tick follows, else the seed
+    // if the dump reaches back to the first tick
+    const std::uint64_t firstTick = dump.ticks.front().tick;
+    const FlightRecorder::Keyframe* keyframe = nullptr;
+    for (const FlightRecorder::Keyframe& candidate : dump.keyframes) {
+        if (candidate.tick + 1 >= firstTick && candidate.tick < dump.ticks.back().tick) {
+            keyframe = &candidate;
+        }
+    }
+    if (!keyframe && firstTick != 1) {
+        std::cout << "The dump starts after the first tick and has no keyframe in reach, so it can't be replayed"
+                  << std::endl;
+        return true;
+    }
+    
+    SimulationConfig config;
+    config.worldSize = sf::Vector2f(dump.worldWidth, dump.worldHeight);
+    config.seed = dump.seed;
+    Simulation simulation(config);
+    
+    std::size_t first = 0;
+    if (keyframe) {
+        StateReader state(keyframe->state.data(), keyframe->state.size());
+        if (!simulation.loadState(state)) {
+            std::cerr << "The keyframe after tick " << keyframe->tick << " is damaged" << std::endl;
+            return false;
+        }
+        first = static_cast<std::size_t>(keyframe->tick + 1 - firstTick);
+        std::cout << "Replaying from the keyframe after tick " << keyframe->tick << std::endl;
+    } else {
+        std::cout << "Replaying from the seed" << std::endl;
+    }
+    
+    // Same order as the game: effects quality, menu actions, then the step
+    for (std::size_t i = first; i < dump.ticks.size(); ++i) {
+        const FlightRecorder::TickRecord& record = dump.ticks[i];
+        simulation.setEffectsQuality(EffectsQuality::fromLevel(record.effectsLevel));
+        if (record.actions & FlightRecorder::ACTION_START_GAME) {
+            simulation.startGame();
+        }
+        if (record.actions & FlightRecorder::ACTION_TOGGLE_PAUSE) {
+            simulation.togglePause();
+        }
+        simulation.update(FlightRecorder::unpackInput(record.input), record.deltaTime);
+        
+        bool matches = simulation.getAsteroids().size() == record.asteroids &&
+                       simulation.getSleepingAsteroidCount() == record.sleepingAsteroids &&
+                       simulation.getBullets().size() == record.bullets &&
+                       simulation.getParticles().size() == record.particles &&
+                       simulation.getScore() == record.score &&
+                       static_cast<std::uint8_t>(simulation.getState()) == record.state;
+        if (!matches) {
+            std::cerr << "Replay diverged at tick " << record.tick << ": " << simulation.getAsteroids().size()
+                      << " asteroids, " << simulation.getBullets().size() << " bullets, "
+                      << simulation.getParticles().size() << " particles, score " << simulation.getScore()
+                      << " (recorded " << record.asteroids << ", " << record.bullets << ", "
+                      << record.particles << ", " << record.score << ")" << std::endl;
+            return false;
+        }
+    }
+    
+    std::cout << "Replayed every tick up to the failure, all matched" << std::endl;
+    return true;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: AsteroidsHeadless [options]" << std::endl;
+    std::cout << "  --instances N     Number of game instances (default 64)" << std::endl;
+    std::cout << "  --threads N       Worker threads, 0 = all hardware threads (default 0)" << std::endl;
+    std::cout << "  --ticks N         Ticks to run per instance (default 3600)" << std::endl;
+    std::cout << "  --world WxH       World size in pixels (default window size)" << std::endl;
+    std::cout << "  --seed N          Base random seed (default 5489)" << std::endl;
+    std::cout << "  --no-pin          Don't pin worker threads to CPUs" << std::endl;
+    std::cout << "  --capture N       Save a frame of every instance every N ticks" << std::endl;
+    std::cout << "  --capture-dir D   Directory for captured frames (default .)" << std::endl;
+    std::cout << "  --capture-size WxH  Resolution of captured frames (default 256x192)" << std::endl;
+    std::cout << "  --gray            Capture greyscale frames instead of RGB" << std::endl;
+    std::cout << "  --check-allocations  Fail if a steady-state tick allocates" << std::endl;
+    std::cout << "  --record FILE     Record instance 0 to a replay file" << std::endl;
+    std::cout << "  --spectate PORT   Broadcast instance 0 to spectators on a loopback port" << std::endl;
+    std::cout << "  --replay-info FILE  Summarise a replay file and its slowest ticks, then exit" << std::endl;
+    std::cout << "  --flight-replay FILE  Summarise a crash's flight recorder dump and replay it, then exit" << std::endl;
+    std::cout << "  --trace FILE      Save a Chrome trace of the run (last zones of each thread)" << std::endl;
+    std::cout << "  --verify-kernels  Compare SIMD and scalar motion kernels, then exit" << std::endl;
+    std::cout << "  --verify-queries  Compare spatial index queries against a scan of every entity, then exit" << std::endl;
+    std::cout << "  --verbose         Print per-instance tick cost" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    try {
+        HeadlessHostConfig config;
+        bool verbose = false;
+        bool verifyKernels = false;
+        bool verifyQueries = false;
+        std::string tracePath;
+        std::string replayInfoPath;
+        std::string flightPath;
+        
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            
+            if (arg == "--instances" && hasValue) {
+                config.instanceCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--threads" && hasValue) {
+                config.threadCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--ticks" && hasValue) {
+                config.ticks = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--world" && hasValue) {
+                if (!parseSize(argv[++i], config.simulation.worldSize.x, config.simulation.worldSize.y)) {
+                    std::cerr << "Invalid world size: " << argv[i] << std::endl;
+                    return EXIT_FAILURE;
+                }
+            } else if (arg == "--capture" && hasValue) {
+                config.captureInterval = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--capture-dir" && hasValue) {
+                config.captureDirectory = argv[++i];
+            } else if (arg == "--capture-size" && hasValue) {
+                float width, height;
+                if (!parseSize(argv[++i], width, height)) {
+                    std::cerr << "Invalid capture size: " << argv[i] << std::endl;
+                    return EXIT_FAILURE;
+                }
+                config.captureWidth = static_cast<unsigned int>(width);
+                config.captureHeight = static_cast<unsigned int>(height);
+            } else if (arg == "--gray") {
+                config.captureFormat = PixelFormat::Gray8;
+            } else if (arg == "--seed" && hasValue) {
+                config.simulation.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--no-pin") {
+                config.pinThreads = false;
+            } else if (arg == "--check-allocations") {
+                config.checkAllocations = true;
+            } else if (arg == "--record" && hasValue) {
+                config.recordPath = argv[++i];
+            } else if (arg == "--spectate" && hasValue) {
+                unsigned long port = std::stoul(argv[++i]);
+                if (port == 0 || port > 65535) {
+                    std::cerr << "Invalid port: " << argv[i] << std::endl;
+                    return EXIT_FAILURE;
+                }
+                config.spectatePort = static_cast<std::uint16_t>(port);
+            } else if (arg == "--replay-info" && hasValue) {
+                replayInfoPath = argv[++i];
+            } else if (arg == "--flight-replay" && hasValue) {
+                flightPath = argv[++i];
+            } else if (arg == "--trace" && hasValue) {
+                tracePath = argv[++i];
+            } else if (arg == "--verify-kernels") {
+                verifyKernels = true;
+            } else if (arg == "--verify-queries") {
+                verifyQueries = true;
+            } else if (arg == "--verbose") {
+                verbose = true;
+            } else {
+                printUsage();
+                return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+        
+        if (verifyKernels) {
+            constexpr std::size_t COUNT = 100003;  // Not a multiple of any SIMD width, so tails run too
+            std::size_t mismatches = MotionKernel::verify(config.simulation.seed, COUNT);
+            std::cout << "Motion kernels: " << (MotionKernel::isVectorized() ? "SIMD" : "scalar")
+                      << ", " << MotionKernel::getWidth() << " wide" << std::endl;
+            std::cout << "Mismatches against scalar: " << mismatches << std::endl;
+            return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        
+        if (verifyQueries) {
+            constexpr std::size_t COUNT = 2000;
+            std::size_t mismatches = SpatialIndex::verify(config.simulation.seed, COUNT);
+            std::cout << "Mismatches against a full scan: " << mismatches << std::endl;
+            return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        
+        if (!replayInfoPath.empty()) {
+            return printReplayInfo(replayInfoPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        
+        if (!flightPath.empty()) {
+            return replayFlight(flightPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        
+        if (config.checkAllocations && !AllocationTracker::isEnabled()) {
+            std::cerr << "--check-allocations needs a build configured with -DASTEROIDS_TRACK_ALLOCATIONS=ON" << std::endl;
+            return EXIT_FAILURE;
+        }
+        
+        if (!tracePath.empty()) {
+            Profiler::setRecording(true);
+        }
+        
+        HeadlessHost host(config);
+        host.run();
+        host.printReport(std::cout, verbose);
+        
+        if (!tracePath.empty()) {
+            Profiler::setRecording(false);
+            long zones = Profiler::writeTrace(tracePath);
+            if (zones < 0) {
+                std::cerr << "Failed to write trace " << tracePath << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::cout << "Trace: " << zones << " zones in " << tracePath << std::endl;
+        }
+        
+        if (!host.passedAllocationCheck()) {
+            std::cerr << "Allocation check failed: steady-state ticks allocated" << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (...) {
+        std::cerr << "Unknown fatal error!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
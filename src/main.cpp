@@ -2,10 +2,58 @@
 #include <exception>
 
 #if defined(USE_SFML)
+#include <string>
+#include "FlightRecorder.hpp"
 #include "Game.hpp"
+#include "ReplayViewer.hpp"
+#include "SpectatorViewer.hpp"
+#include "StartupTimer.hpp"
+
+namespace {
+
+// Two numbers separated by one character, as in "1920x1080"
+bool parsePair(const std::string& text, char separator, float& first, float& second)
+{
+    std::size_t position = text.find(separator);
+    if (position == std::string::npos) {
+        return false;
+    }
+    try {
+        first = std::stof(text.substr(0, position));
+        second = std::stof(text.substr(position + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// A port number from 1 to 65535
+bool parsePort(const std::string& text, std::uint16_t& port)
+{
+    try {
+        unsigned long value = std::stoul(text);
+        if (value == 0 || value > 65535) {
+            return false;
+        }
+        port = static_cast<std::uint16_t>(value);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// Save the last ticks before a fatal error, if a game got far enough to record any
+void dumpFlightRecorder(const char* reason)
+{
+    if (FlightRecorder::dump(reason)) {
+        std::cerr << "Flight recorder dumped to " << FlightRecorder::getDumpPath() << std::endl;
+    }
+}
+
+}
 #endif
 
-int main()
+int main(int argc, char* argv[])
 {
     try {
 #if defined(NO_GRAPHICS)
@@ -32,15 +80,78 @@ int main()
         
         return EXIT_SUCCESS;
 #else
+        // Everything before main (loading SFML, static initialisation)
+        StartupTimer::record("Before main", StartupTimer::getProcessStart(), StartupTimer::Clock::now(), 0);
+        
+        // Crashes leave the last ticks behind, see FlightRecorder
+        FlightRecorder::installSignalHandlers();
+        
+        GameConfig config;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::string value = argv[++i];
+            
+            if (arg == "--replay") {
+                // Asteroids --replay FILE plays a recording back instead of a game
+                ReplayViewer viewer(value);
+                viewer.run();
+                return EXIT_SUCCESS;
+            } else if (arg == "--watch") {
+                // Asteroids --watch PORT shows a game broadcasting on a loopback port
+                std::uint16_t port = 0;
+                if (!parsePort(value, port)) {
+                    std::cerr << "Invalid port: " << value << std::endl;
+                    return EXIT_FAILURE;
+                }
+                SpectatorViewer viewer(port);
+                viewer.run();
+                return EXIT_SUCCESS;
+            } else if (arg == "--spectate") {
+                // Asteroids --spectate PORT lets spectators on this machine watch
+                if (!parsePort(value, config.spectatePort)) {
+                    std::cerr << "Invalid port: " << value << std::endl;
+                    return EXIT_FAILURE;
+                }
+            } else if (arg == "--world") {
+                // Asteroids --world WxH plays in a world bigger than the window
+                if (!parsePair(value, 'x', config.worldSize.x, config.worldSize.y) ||
+                    config.worldSize.x <= 0.0f || config.worldSize.y <= 0.0f) {
+                    std::cerr << "Invalid world size: " << value << std::endl;
+                    return EXIT_FAILURE;
+                }
+            } else if (arg == "--render-scale") {
+                // Asteroids --render-scale MIN:MAX bounds the world's render resolution
+                if (!parsePair(value, ':', config.minResolutionScale, config.maxResolutionScale) ||
+                    config.minResolutionScale <= 0.0f || config.maxResolutionScale > 1.0f ||
+                    config.minResolutionScale > config.maxResolutionScale) {
+                    std::cerr << "Invalid render scale: " << value << std::endl;
+                    return EXIT_FAILURE;
+                }
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        
         // When SFML is available
-        Game game;
+        Game game(config);
         game.run();
 #endif
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
+#if defined(USE_SFML)
+        dumpFlightRecorder(e.what());
+#endif
         return EXIT_FAILURE;
     } catch (...) {
         std::cerr << "Unknown fatal error!" << std::endl;
+#if defined(USE_SFML)
+        dumpFlightRecorder("Unknown fatal error");
+#endif
         return EXIT_FAILURE;
     }
     
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include "MetricsPage.hpp"
+
+namespace {
+
+// Same order as GameState
+const char* const STATE_NAMES[] = {"menu", "playing", "game over", "paused"};
+
+void printUsage()
+{
+    std::cout << "Usage: AsteroidsMetrics [options]" << std::endl;
+    std::cout << "  --pid N           Watch the game with this process id (default newest)" << std::endl;
+    std::cout << "  --interval MS     Milliseconds between samples (default 1000)" << std::endl;
+    std::cout << "  --count N         Stop after N samples, 0 = until the game exits (default 0)" << std::endl;
+    std::cout << "  --list            List running games and exit" << std::endl;
+}
+
+bool isProcessAlive(std::int32_t pid)
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+const char* getStateName(std::int32_t state)
+{
+    if (state < 0 || state >= static_cast<std::int32_t>(sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]))) {
+        return "?";
+    }
+    return STATE_NAMES[state];
+}
+
+void printHeader()
+{
+    std::printf("%10s %9s %9s %5s %7s %5s %6s %7s %5s %6s %8s %8s %8s %6s %8s %6s %8s\n",
+                "tick", "ticks/s", "state", "ast", "asleep", "bul", "part", "pairs", "hits", "sounds",
+                "tick ms", "frame ms", "fps", "draws", "effects", "scale", "input ms");
+}
+
+void printSample(const SimulationMetrics& simulation, const RenderMetrics& render,
+                 double ticksPerSecond, double framesPerSecond)
+{
+    std::printf("%10llu %9.1f %9s %5u %7u %5u %6u %7u %5u %6u %8.3f %8.3f %8.1f %6u %7.0f%% %5.0f%% %8.2f\n",
+                static_cast<unsigned long long>(simulation.tick), ticksPerSecond,
+                getStateName(simulation.state), simulation.asteroids, simulation.sleepingAsteroids,
+                simulation.bullets, simulation.particles, simulation.collisionPairsTested, simulation.collisionHits,
+                simulation.activeSounds, simulation.tickTimeMs, render.frameTimeMs, framesPerSecond,
+                render.drawCalls, simulation.effectsLevel * 100.0f, render.resolutionScale * 100.0f,
+                render.inputLatencyMs);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    try {
+        std::int32_t pid = 0;
+        unsigned int intervalMs = 1000;
+        unsigned long count = 0;
+        bool list = false;
+        
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            
+            if (arg == "--pid" && hasValue) {
+                pid = static_cast<std::int32_t>(std::stol(argv[++i]));
+            } else if (arg == "--interval" && hasValue) {
+                intervalMs = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--count" && hasValue) {
+                count = std::stoul(argv[++i]);
+            } else if (arg == "--list") {
+                list = true;
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return EXIT_SUCCESS;
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        
+        if (list) {
+            MetricsReader reader;
+            for (const std::string& name : Metrics::findSegments()) {
+                bool alive = reader.open(name) && isProcessAlive(reader.getPid());
+                std::cout << name << (alive ? "" : " (stale)") << std::endl;
+            }
+            return EXIT_SUCCESS;
+        }
+        
+        // Without a pid, watch the newest game that is still running
+        MetricsReader reader;
+        if (pid != 0) {
+            reader.open(Metrics::getSegmentName(pid));
+        } else {
+            for (const std::string& name : Metrics::findSegments()) {
+                if (reader.open(name) && isProcessAlive(reader.getPid())) {
+                    break;
+                }
+                reader.close();
+            }
+        }
+        
+        if (!reader.isOpen()) {
+            std::cerr << "No running game found" << std::endl;
+            return EXIT_FAILURE;
+        }
+        
+        std::cout << "Watching process " << reader.getPid() << std::endl;
+        printHeader();
+        
+        // Rates come from the counter deltas between samples
+        SimulationMetrics previousSimulation = reader.readSimulation();
+        RenderMetrics previousRender = reader.readRender();
+        auto previousTime = std::chrono::steady_clock::now();
+        
+        for (unsigned long sample = 0; count == 0 || sample < count; ++sample) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+            
+            if (!isProcessAlive(reader.getPid())) {
+                std::cout << "Game exited" << std::endl;
+                break;
+            }
+            
+            SimulationMetrics simulation = reader.readSimulation();
+            RenderMetrics render = reader.readRender();
+            auto now = std::chrono::steady_clock::now();
+            
+            double seconds = std::chrono::duration<double>(now - previousTime).count();
+            double ticksPerSecond = static_cast<double>(simulation.tick - previousSimulation.tick) / seconds;
+            double framesPerSecond = static_cast<double>(render.frame - previousRender.frame) / seconds;
+            printSample(simulation, render, ticksPerSecond, framesPerSecond);
+            std::fflush(stdout);
+            
+            previousSimulation = simulation;
+            previousRender = render;
+            previousTime = now;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}